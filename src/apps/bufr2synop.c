@@ -117,6 +117,10 @@ FILE *FL; /*!< Buffer to read the list of files */
 struct bufr_subset_sequence_data SUBSET; /*!< ALl data decoded for a subset*/
 struct bufr2tac_subset_state STATE; /*!< Includes the info when parsing a subset sequence */
 struct bufr_atom_data DATARRAY[BUFR_NMAXSEQ]; /****/
+char DATANAMES[BUFR_NMAXSEQ][BUFR_TABLEB_NAME_LENGTH]; /*!< Names of elements in DATARRAY */
+char DATAUNITS[BUFR_NMAXSEQ][BUFR_TABLEB_UNIT_LENGTH]; /*!< Units of elements in DATARRAY */
+char DATACVALS[BUFR_NMAXSEQ][128]; /*!< String values of elements in DATARRAY */
+char DATACTABLES[BUFR_NMAXSEQ][BUFR_EXPLAINED_LENGTH]; /*!< Explained code and flag tables of elements in DATARRAY */
 //struct synop_chunks SYN;
 
 char DEFAULT_BUFRTABLES[] = "/usr/local/lib/bufrtables/"; /*!< Default bufr tables dir */
@@ -389,11 +393,18 @@ int main ( int argc, char *argv[] )
               i = nsub * KELEM + j;
               LINAUX[0] = '\0'; // clean the output line
               c = LINAUX;
-              charray_to_string ( SUBSET.sequence[j].name, ( unsigned char * ) CNAMES[j], 64 );
-              charray_to_string ( SUBSET.sequence[j].unit, ( unsigned char * ) CUNITS[j], 24 );
+              charray_to_string ( DATANAMES[j], ( unsigned char * ) CNAMES[j], 64 );
+              charray_to_string ( DATAUNITS[j], ( unsigned char * ) CUNITS[j], 24 );
+              DATACVALS[j][0] = '\0';
+              DATACTABLES[j][0] = '\0';
+              SUBSET.sequence[j].name = DATANAMES[j];
+              SUBSET.sequence[j].unit = DATAUNITS[j];
+              SUBSET.sequence[j].cval = DATACVALS[j];
+              SUBSET.sequence[j].ctable = DATACTABLES[j];
               integer_to_descriptor ( &SUBSET.sequence[j].desc, KTDEXP[j] );
 
-              c += sprintf ( c, "KTDEXP[%03d]=%s |%03d |", j, SUBSET.sequence[j].desc.c, nsub );
+              c += sprintf ( c, "KTDEXP[%03d]=%u%02u%03u |%03d |", j, SUBSET.sequence[j].desc.f,
+                             SUBSET.sequence[j].desc.x, SUBSET.sequence[j].desc.y, nsub );
               c += sprintf ( c, "'%s'|", SUBSET.sequence[j].name );
               if ( VALUES[i] != MISSING_REAL )
                 {
@@ -401,14 +412,14 @@ int main ( int argc, char *argv[] )
                     {
                       SUBSET.sequence[j].mask |= DESCRIPTOR_HAVE_STRING_VALUE;
                       k = ( ( int ) VALUES[i] ) % 1000;
-                      charray_to_string ( SUBSET.sequence[j].cval, ( unsigned char * ) CVALS[ ( int ) ( VALUES[i]/1000.0 ) - 1], k );
+                      charray_to_string ( DATACVALS[j], ( unsigned char * ) CVALS[ ( int ) ( VALUES[i]/1000.0 ) - 1], k );
                       c += sprintf ( c, "'%s'", SUBSET.sequence[j].cval );
                     }
                   else if ( strstr ( SUBSET.sequence[j].unit,"CODE TABLE" ) == SUBSET.sequence[j].unit )
                     {
                       SUBSET.sequence[j].mask |= DESCRIPTOR_IS_CODE_TABLE;
                       SUBSET.sequence[j].val = VALUES[i];
-                      if ( get_explained_table_val ( SUBSET.sequence[j].ctable, 256, TABLEC, NLINES_TABLEC, &SUBSET.sequence[j].desc, ( int ) VALUES[i] ) != NULL )
+                      if ( get_explained_table_val ( DATACTABLES[j], BUFR_EXPLAINED_LENGTH, TABLEC, NLINES_TABLEC, &SUBSET.sequence[j].desc, ( int ) VALUES[i] ) != NULL )
                         {
                           SUBSET.sequence[j].mask |= DESCRIPTOR_HAVE_CODE_TABLE_STRING;
                           if ( VERBOSE )
@@ -425,7 +436,7 @@ int main ( int argc, char *argv[] )
                     {
                       SUBSET.sequence[j].mask |= DESCRIPTOR_IS_FLAG_TABLE;
                       SUBSET.sequence[j].val = VALUES[i];
-                      if ( get_explained_flag_val ( SUBSET.sequence[j].ctable, 256, TABLEC, NLINES_TABLEC, &SUBSET.sequence[j].desc, ( unsigned long ) VALUES[i] ) != NULL )
+                      if ( get_explained_flag_val ( DATACTABLES[j], BUFR_EXPLAINED_LENGTH, TABLEC, NLINES_TABLEC, &SUBSET.sequence[j].desc, ( unsigned long ) VALUES[i] ) != NULL )
                         {
                           SUBSET.sequence[j].mask |= DESCRIPTOR_HAVE_FLAG_TABLE_STRING;
                           if ( VERBOSE )
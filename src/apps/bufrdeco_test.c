@@ -25,11 +25,13 @@
 struct bufrdeco BUFR;
 
 char ENTRADA[256];
+int COLUMNS; /*!< If == 1 the data of a compressed message is printed by columns */
 
 void print_usage ( void )
 {
   printf ( "Usage: \n" );
-  printf ( "bufrdeco_test -i input_file [-h]\n" );
+  printf ( "bufrdeco_test -i input_file [-c][-h]\n" );
+  printf ( "   -c Print the data of a compressed message by columns, i.e. every element for all subsets\n" );
   printf ( "   -h Print this help\n" );
   printf ( "   -i Input file. Complete input path file for bufr file\n" );
 }
@@ -49,9 +51,12 @@ int read_args ( int _argc, char * _argv[] )
   /*
      Read input options
   */
-  while ( ( iopt = getopt ( _argc, _argv, "hi:" ) ) !=-1 )
+  while ( ( iopt = getopt ( _argc, _argv, "chi:" ) ) !=-1 )
     switch ( iopt )
       {
+      case 'c':
+        COLUMNS = 1;
+        break;
       case 'i':
         if ( strlen ( optarg ) < 256 )
           strcpy ( ENTRADA, optarg );
@@ -70,6 +75,55 @@ int read_args ( int _argc, char * _argv[] )
   return 1;
 }
 
+/*!
+  \fn int print_columns ( struct bufrdeco *b )
+  \brief Print the data of a compressed message by columns
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  Numeric values are printed as doubles and as scaled integers, to check both ways to get them
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int print_columns ( struct bufrdeco *b )
+{
+  size_t i, n, ss;
+  int32_t *v;
+  struct bufrdeco_column c;
+
+  if ( bufrdeco_columns_count ( &n, b ) )
+    return 1;
+
+  if ( ( v = calloc ( b->sec3.subsets + 1, sizeof ( int32_t ) ) ) == NULL )
+    {
+      sprintf ( b->error, "print_columns(): Cannot allocate memory\n" );
+      return 1;
+    }
+
+  for ( i = 0; i < n; i++ )
+    {
+      if ( bufrdeco_get_column ( &c, i, b ) ||
+           ( c.kind != BUFRDECO_COLUMN_STRING && bufrdeco_get_column_int32 ( v, i, b ) ) )
+        {
+          free ( v );
+          return 1;
+        }
+
+      printf ( "# Column %lu: %u %02u %03u '%s' [%s] escale %d\n", ( unsigned long ) i, c.desc.f, c.desc.x, c.desc.y,
+               c.name, c.unit, c.escale );
+      for ( ss = 0; ss < c.nsubsets; ss++ )
+        {
+          if ( c.missing[ss] )
+            printf ( "  %5lu MISSING\n", ( unsigned long ) ss );
+          else if ( c.kind == BUFRDECO_COLUMN_STRING )
+            printf ( "  %5lu '%s'\n", ( unsigned long ) ss, c.str + ss * c.slen );
+          else
+            printf ( "  %5lu %17.10e %d\n", ( unsigned long ) ss, c.val[ss], v[ss] );
+        }
+    }
+
+  free ( v );
+  return 0;
+}
 
 int main ( int argc, char *argv[] )
 {
@@ -102,6 +156,19 @@ int main ( int argc, char *argv[] )
 
   bufrdeco_print_tree ( &BUFR );
 
+  if ( COLUMNS )
+    {
+      if ( print_columns ( &BUFR ) )
+        {
+          printf ( "# %s", BUFR.error );
+          bufrdeco_close ( &BUFR );
+          exit ( EXIT_FAILURE );
+        }
+      printf ( "So far so good !!\n" );
+      bufrdeco_close ( &BUFR );
+      exit ( EXIT_SUCCESS );
+    }
+
   for ( subset = 0; subset < BUFR.sec3.subsets ; subset++ )
     {
       if ( ( seq = bufrdeco_get_subset_sequence_data ( &BUFR ) ) == NULL )
@@ -47,6 +47,9 @@
            is '-F prefix' where prefix is the string to add. Resulting file names are in the form prefix_original_nane
            if no -F option then no archive bin file is generated. timestamp of resulting file is the same than the input
            file. In case of no bufr selected it just create a void file.
+         - To decode the messages to TAC in memory, printing the results in standard output as bufrtotac does,
+           but without the round trip of writing and reading individual files. The option is '-d'. The bufr
+           tables directory can be set with '-t' option.
 
     Second item of resulting name file is 6 characters long:
 
@@ -189,10 +192,10 @@
 */
 #include "bufrnoaa.h"
 
-int STAGE, SELECT, INDIVIDUAL, COLECT, VERBOSE;
+int SELECT, INDIVIDUAL, COLECT, VERBOSE;
 int  LISTF; /*!< if != then a list of messages in bin file is generated */
-unsigned char BUFR[BUFRLEN];
-unsigned char BUF[BLEN];
+int TAC; /*!< if != 0 then selected messages are decoded to TAC in memory */
+char BUFRTABLES_DIR[256]; /*!< Directory for BUFR tables set by user */
 char ENTRADA[256];
 char SEL[64]; /*!< Selection string for argument -T according with T1 */
 char SELS[64]; /*!< Selection string for A1 when T2='S' (argument -S)   */
@@ -209,13 +212,13 @@ char FINAL_SEP[4];
 
 int main ( int argc, char *argv[] )
 {
-  size_t nb = 0, nc, nx = 0, nbuf = 0, nsel = 0, nerr = 0, i, nh = 0, nw;
-  FILE* ficin;
+  size_t nbuf = 0, nsel = 0, nerr = 0, nw, pos = 0, len;
+  int fd, res, mapped = 0;
   FILE* ficout = NULL;
   FILE* ficol = NULL;
-  unsigned char b[4], header[256];
-  unsigned int expected = 0;
-  char name[256], namex[256], namec[256];
+  unsigned char *buf = NULL;
+  struct bin_message msg;
+  char namex[256], namec[256];
   double tx;
   struct timeval tini, tfin, tt;
 
@@ -235,13 +238,37 @@ int main ( int argc, char *argv[] )
       exit ( EXIT_FAILURE );
     }
 
-  // Open output file
-  if ( ( ficin = fopen ( ENTRADA,"r" ) ) == NULL )
+  // Open input file
+  if ( ( fd = open ( ENTRADA, O_RDONLY ) ) < 0 )
     {
       printf ( "%s: Cannot open %s\n", OWN, ENTRADA );
       exit ( EXIT_FAILURE );
     }
 
+  // Map the whole input file. If not possible, read it in a single block
+  len = INSTAT.st_size;
+  if ( len )
+    {
+      if ( ( buf = mmap ( NULL, len, PROT_READ, MAP_PRIVATE, fd, 0 ) ) != MAP_FAILED )
+        {
+          mapped = 1;
+          madvise ( buf, len, MADV_SEQUENTIAL );
+        }
+      else if ( ( buf = malloc ( len ) ) == NULL || ( size_t ) read ( fd, buf, len ) != len )
+        {
+          printf ( "%s: Cannot read %s\n", OWN, ENTRADA );
+          close ( fd );
+          exit ( EXIT_FAILURE );
+        }
+    }
+  close ( fd );
+
+  if ( TAC && init_bufr_to_tac() )
+    {
+      printf ( "%s: Cannot init bufr decoder\n", OWN );
+      exit ( EXIT_FAILURE );
+    }
+
   if ( COLECT )
     {
       // To make an archive
@@ -258,225 +285,76 @@ int main ( int argc, char *argv[] )
         }
     }
 
-
-  STAGE = 0;
-
-  memset ( &b, 0, 4 * sizeof ( unsigned char ) );
-
-  while ( ( nc = fread ( &BUF[0], sizeof ( unsigned char ), BLEN, ficin ) ) > 0 )
+  while ( ( res = find_next_bufr ( buf, len, &pos, &msg, &nerr ) ) > 0 )
     {
-      for ( i = 0; i < nc ; i++ )
+      nbuf++;
+      if ( LISTF )
+        printf ( "%s\n", msg.name );
+      if ( bufr_is_selected ( msg.name ) )
         {
-          // ingest a byte
-          b[3] = b[2];
-          b[2] = b[1];
-          b[1] = b[0];
-          b[0] = BUF[i];
-
-          switch ( STAGE )
+          nsel++;
+          // name as 'YYYYMMDDHHmmss_ISIE06_SBBR_012100_RRB.bufr' prefixed with input file timestamp
+          date_mtime_from_stat ( namex, &INSTAT );
+          strcat ( namex,"_" );
+          strcat ( namex, msg.name );
+          strcat ( namex, ".bufr" );
+          if ( TAC )
             {
-            case 0: // begining, searching header init
-              if ( is_head_custom ( &b[0] , HEADER_MARK ) )
-                {
-                  memset ( &header[0], 0, 64 * sizeof ( unsigned char ) );
-                  header[0] = HEADER_MARK;
-                  header[1] = HEADER_MARK;
-                  header[2] = HEADER_MARK;
-                  header[3] = HEADER_MARK;
-                  nh = 4;
-                  STAGE = 1;
-                }
-              break;
-            case 1: // header found, filling
-              if ( nh < 255 )
-                header[nh++] = b[0];
-              else
-                {
-                  STAGE = 0;
-                  nerr++;
-                  break;
-                }
-              if ( is_head_custom ( &b[0] , HEADER_MARK ) )
-                {
-                  STAGE = 2;
-                  //header[nh++] = '\0';
-                  //printf("Header: '%s'\n",header);
-                }
-              break;
-            case 2: // header already finished
-              if ( nh < 255 )
-                header[nh++] = b[0];
-              else
-                {
-                  STAGE = 0;
-                  nerr++;
-                  break;
-                }
-              if ( b[0] != 0x0a && b[0] != 0x0d )
-                {
-                  STAGE = 3;
-                  memset ( &name[0], 0, 128 * sizeof ( unsigned char ) );
-                  name[0] = b[0];
-                  nx = 1;
-                }
-              break;
-            case 3: // name already inited
-              if ( nh < 255 )
-                header[nh++] = b[0];
-              else
-                {
-                  STAGE = 0;
-                  nerr++;
-                  break;
-                }
-              if ( nx >= 255 )
-                {
-                  STAGE = 0;
-                  break;
-                }
-              if ( b[0] == 0x01a || b[0] == 0x0d )
-                {
-                  STAGE = 4;
-                  name[nx++] = '\0';
-                  //printf("Name: '%s'\n",name);
-                }
-              else if ( b[0] == ' ' )
-                name[nx++] = '_'; // substitute a space by '_'
-              else
-                name[nx++] = b[0];
-              break;
-            case 4: // Waiting BUFR message begin
-              if ( nh < 255 )
-                header[nh++] = b[0];
-              else
-                {
-                  STAGE = 0;
-                  nerr++;
-                  break;
-                }
-              if ( is_bufr ( &b[0] ) )
+              // decode in memory. The name is used to guess the GTS header
+              bufr_to_tac ( &msg, namex );
+            }
+          if ( INDIVIDUAL )
+            {
+              if ( ( ficout = fopen ( namex, "w" ) ) == NULL )
                 {
-                  STAGE = 5;
-                  expected = 0;
-                  // printf("Leyendo BUFR\n");
-                  memset ( &BUFR[0], 0, BUFRLEN );
-                  nb = 4;
-                  BUFR[0]='B';
-                  BUFR[1]='U';
-                  BUFR[2]='F';
-                  BUFR[3]='R';
-                  nh -= 4;
-                  header[nh] = '\0';
+                  printf ( "Error: cannot open %s\n", msg.name );
+                  exit ( EXIT_FAILURE );
                 }
-              break;
-            case 5: // Filling BUFR message till final '7777'
-              if ( nb < ( BUFRLEN - 1 ) )
-                BUFR[nb++] = b[0];
-              else
+              if ( ( nw = fwrite ( msg.bufr, sizeof ( unsigned char ), msg.nb, ficout ) ) != msg.nb )
                 {
-                  printf ( "Error: Bufr message length > %d", BUFRLEN );
-                  fclose ( ficin );
+                  printf ( "Error: Writen %lu bytes instead of %lu in %s file\n", nw, msg.nb, namex );
+                  fclose ( ficout );
                   exit ( EXIT_FAILURE );
                 }
-              // check expected length
-              if ( nb == 7 )
+              // close an individual fileq
+              fclose ( ficout );
+              // change individual file timestamp
+              mtime_from_stat ( namex, &INSTAT );
+            }
+          if ( COLECT )
+            {
+              // first write header
+              if ( ( nw = fwrite ( msg.header, sizeof ( char ), msg.nh, ficol ) ) != msg.nh )
                 {
-                  expected = ( unsigned int ) b[0] + ( unsigned int ) b[1] * 256 + ( unsigned int ) b[2] * 65536;
+                  printf ( "%s: Error: Writen %lu bytes instead of %lu in %s file\n", OWN, nw, msg.nh, namec );
+                  fclose ( ficol );
+                  exit ( EXIT_FAILURE );
                 }
 
-              // Has been detected some void and fakes bufr
-              if ( b[0] == HEADER_MARK &&
-                   b[1] == HEADER_MARK &&
-                   b[2] == HEADER_MARK
-                 )
+              // then bufr message
+              if ( ( nw = fwrite ( msg.bufr, sizeof ( unsigned char ), msg.nb, ficol ) ) != msg.nb )
                 {
-                  // Ooops. a fake bufr
-                  // it seems a new header has been found before '7777'
-                  STAGE = 0;
-                  nerr++;
-                  break;
+                  printf ( "%s: Error: Writen %lu bytes instead of %lu in %s file\n", OWN, nw, msg.nb, namec );
+                  fclose ( ficol );
+                  exit ( EXIT_FAILURE );
                 }
-              if ( nb == expected )
+              // finally \r\r\n
+              if ( FINAL_SEP[0] )
                 {
-                  if ( is_endb ( &b[0] ) )
+                  if ( ( nw = fwrite ( &FINAL_SEP[0], sizeof ( char ), 3, ficol ) ) != 3 )
                     {
-                      STAGE = 0;
-                      nbuf++;
-                      if ( LISTF )
-                        printf ( "%s\n", name );
-                      if ( bufr_is_selected ( name ) )
-                        {
-                          nsel++;
-                          if ( INDIVIDUAL )
-                            {
-                              // prefix with input file timestamp
-                              date_mtime_from_stat ( namex, &INSTAT );
-                              strcat ( namex,"_" );
-                              strcat ( namex, name );
-                              strcat ( namex, ".bufr" );
-                              if ( ( ficout = fopen ( namex, "w" ) ) == NULL )
-                                {
-                                  printf ( "Error: cannot open %s\n", name );
-                                  fclose ( ficin );
-                                  exit ( EXIT_FAILURE );
-                                }
-                              if ( ( nw = fwrite ( &BUFR[0], sizeof ( unsigned char ), nb, ficout ) ) != nb )
-                                {
-                                  printf ( "Error: Writen %lu bytes instead of %lu in %s file\n", nw, nb, namex );
-                                  fclose ( ficin );
-                                  fclose ( ficout );
-                                  exit ( EXIT_FAILURE );
-                                }
-                              // close an individual fileq
-                              fclose ( ficout );
-                              // change individual file timestamp
-                              mtime_from_stat ( namex, &INSTAT );
-                            }
-                          if ( COLECT )
-                            {
-                              // first write header
-                              if ( ( nw = fwrite ( &header[0], sizeof ( char ), nh, ficol ) ) != nh )
-                                {
-                                  printf ( "%s: Error: Writen %lu bytes instead of %lu in %s file\n", OWN, nw, nh, namec );
-                                  fclose ( ficin );
-                                  fclose ( ficol );
-                                  exit ( EXIT_FAILURE );
-                                }
-
-                              // then bufr message
-                              if ( ( nw = fwrite ( &BUFR[0], sizeof ( unsigned char ), nb, ficol ) ) != nb )
-                                {
-                                  printf ( "%s: Error: Writen %lu bytes instead of %lu in %s file\n", OWN, nw, nb, namex );
-                                  fclose ( ficin );
-                                  fclose ( ficout );
-                                  exit ( EXIT_FAILURE );
-                                }
-                              // finally \r\r\n
-                              if (FINAL_SEP[0])
-                              {
-                              if ( ( nw = fwrite ( &FINAL_SEP[0], sizeof ( char ), 3, ficol ) ) != 3 )
-                                {
-                                  printf ( "%s: Error: Writen %lu bytes instead of 3 chars separing messages in %s\n", OWN, nw, namex );
-                                  fclose ( ficin );
-                                  fclose ( ficout );
-                                  exit ( EXIT_FAILURE );
-                                }
-                              }
-                            }
-                        }
-                    }
-                  else
-                    {
-                      // reached the expected end of BUFR without a '7777'
-                      STAGE = 0;
-                      nerr++;
-                      break;
+                      printf ( "%s: Error: Writen %lu bytes instead of 3 chars separing messages in %s\n", OWN, nw, namec );
+                      fclose ( ficol );
+                      exit ( EXIT_FAILURE );
                     }
                 }
             }
         }
     }
 
+  if ( TAC )
+    close_bufr_to_tac();
+
   if ( COLECT )
     {
       fclose ( ficol );
@@ -486,7 +364,10 @@ int main ( int argc, char *argv[] )
 
   // Final time
   gettimeofday ( &tfin, NULL );
-  fclose ( ficin );
+  if ( mapped )
+    munmap ( buf, len );
+  else
+    free ( buf );
 
   // A brief stat output
   if ( VERBOSE )
@@ -23,6 +23,10 @@
    \file bufrnoaa.h
    \brief inclusion file for binary bufrnoaa
 */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,15 +35,37 @@
 #include <utime.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bufrdeco.h"
+#include "bufr2tac.h"
 
-#define BLEN 1024
 // longitud maxima de un bufr 8 MB
 #define BUFRLEN 8388608
+// longitud maxima de la cabecera
+#define HEADLEN 256
+
+/*!
+  \struct bin_message
+  \brief A bufr message found in a NOAA bin file. Pointers are into the input buffer, nothing is copied
+*/
+struct bin_message
+{
+  unsigned char *header; /*!< Pointer to the first header mark */
+  size_t nh; /*!< Length of header, from first mark to the byte preceding 'BUFR' */
+  char name[256]; /*!< Name of message, with '_' instead of spaces */
+  unsigned char *bufr; /*!< Pointer to 'BUFR' */
+  size_t nb; /*!< Length of bufr message, up to the final '7777' */
+};
 
-extern int STAGE, SELECT, INDIVIDUAL, COLECT, VERBOSE;
+extern int SELECT, INDIVIDUAL, COLECT, VERBOSE;
 extern int LISTF;
-extern unsigned char BUFR[BUFRLEN];
-extern unsigned char BUF[BLEN];
+extern int TAC;
+extern char BUFRTABLES_DIR[256];
+extern struct bufrdeco BUFRDECO;
+extern struct metreport REPORT;
+extern struct bufr2tac_subset_state STATE;
 extern char ENTRADA[256], PREFIX[64];
 extern struct stat INSTAT;
 extern char SEL[64], SELS[64], SELO[64], SELU[64];
@@ -59,6 +85,10 @@ void print_usage ( void );
 int bufr_is_selected ( char *name );
 int date_mtime_from_stat ( char *date, struct stat *st );
 int mtime_from_stat ( char *filename, struct stat *st );
+int find_next_bufr ( unsigned char *buf, size_t len, size_t *pos, struct bin_message *m, size_t *nerr );
+int init_bufr_to_tac ( void );
+int bufr_to_tac ( struct bin_message *m, char *filename );
+int close_bufr_to_tac ( void );
 
 
 
@@ -26,11 +26,14 @@
 void print_usage ( void )
 {
   printf ( "Usage: \n" );
-  printf ( "bufrnoaa -i input_file [-h][-f][-l][-F prefix][-T T2_selection][-O selo][-S sels][-U selu]\n" );
+  printf ( "bufrnoaa -i input_file [-h][-f][-l][-d][-t bufrtable_dir][-F prefix][-T T2_selection][-O selo][-S sels][-U selu]\n" );
   printf ( "   -h Print this help\n" );
   printf ( "   -i Input file. Complete input path file for NOAA *.bin bufr archive file\n" );
   printf ( "   -2 Input file is formatted in alternative form: Headers has '#' instead of '*' marks and no sep after '7777'\n");
   printf ( "   -l list the names of reports in input file\n" );
+  printf ( "   -d Decode selected reports to TAC in memory and print them in standard output, as bufrtotac does\n" );
+  printf ( "      with the files extracted with -f option, but without writing nor reading any file\n" );
+  printf ( "   -t bufrtable_dir. Pathname of bufr tables directory when using -d option. Ended with '/'\n" );
   printf ( "   -f Extract selected reports and write them in files, one per bufr message, as \n" );
   printf ( "      example '20110601213442_ISIE06_SBBR_012100_RRB.bufr'. First field in name is input file timestamp \n" );
   printf ( "      Other fields are from header\n" );
@@ -72,6 +75,8 @@ int read_args ( int _argc, char * _argv[] )
   INDIVIDUAL = 0;
   COLECT = 0;
   LISTF = 0;
+  TAC = 0;
+  BUFRTABLES_DIR[0] = '\0';
   VERBOSE = 1;
   HEADER_MARK = '*';
   strcpy(FINAL_SEP, SEP);
@@ -79,7 +84,7 @@ int read_args ( int _argc, char * _argv[] )
   /*
      Read input options
   */
-  while ( ( iopt = getopt ( _argc, _argv, "h2i:flF:O:qS:T:U:" ) ) !=-1 )
+  while ( ( iopt = getopt ( _argc, _argv, "dh2i:flF:O:qS:T:t:U:" ) ) !=-1 )
     switch ( iopt )
       {
       case 'i':
@@ -93,6 +98,13 @@ int read_args ( int _argc, char * _argv[] )
       case 'f':
         INDIVIDUAL = 1;
         break;
+      case 'd':
+        TAC = 1;
+        break;
+      case 't':
+        if ( strlen ( optarg ) < 256 )
+          strcpy ( BUFRTABLES_DIR, optarg );
+        break;
       case 'q':
         VERBOSE = 0;
         break;
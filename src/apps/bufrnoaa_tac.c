@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+   \file bufrnoaa_tac.c
+   \brief File with the code to decode to TAC the messages found by bufrnoaa, without writing files
+*/
+#include "bufrnoaa.h"
+
+struct bufrdeco BUFRDECO; /*!< struct to decode the bufr messages */
+struct metreport REPORT; /*!< stuct to set the parsed report */
+struct bufr2tac_subset_state STATE; /*!< Includes the info when parsing a subset sequence */
+
+/*!
+  \fn int init_bufr_to_tac ( void )
+  \brief Init the bufr decoder used with option -d
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int init_bufr_to_tac ( void )
+{
+  if ( bufrdeco_init ( &BUFRDECO ) )
+    return 1;
+
+  strcpy ( BUFRDECO.bufrtables_dir, BUFRTABLES_DIR );
+  return 0;
+}
+
+/*!
+  \fn int close_bufr_to_tac ( void )
+  \brief Free the memory used by the bufr decoder
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int close_bufr_to_tac ( void )
+{
+  return bufrdeco_close ( &BUFRDECO );
+}
+
+/*!
+  \fn int bufr_to_tac ( struct bin_message *m, char *filename )
+  \brief Decode a bufr message to TAC and print the reports in standard output
+  \param m pointer to the struct \ref bin_message with the bufr message
+  \param filename name of file as it would be written with option -f. It is used to guess the GTS header
+
+  The message is decoded in place, from the input buffer. The output is the same than the one of
+  bufrtotac for the file \a filename
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufr_to_tac ( struct bin_message *m, char *filename )
+{
+  size_t subset;
+  int res = 0;
+  char err[256];
+
+  if ( bufrdeco_read_buffer_view ( &BUFRDECO, m->bufr, m->nb ) )
+    {
+      bufrdeco_reset ( &BUFRDECO );
+      return 1;
+    }
+
+  /* Try to guess a GTS header from filename*/
+  guess_gts_header ( &BUFRDECO.header , filename );
+
+  if ( bufrdeco_parse_tree ( &BUFRDECO ) )
+    {
+      bufrdeco_reset ( &BUFRDECO );
+      return 1;
+    }
+
+  for ( subset = 0; subset < BUFRDECO.sec3.subsets ; subset++ )
+    {
+      if ( bufrdeco_get_subset_sequence_data ( &BUFRDECO ) == NULL )
+        {
+          res = 1;
+          break;
+        }
+
+      if ( BUFRDECO.sec3.ndesc )
+        bufrdeco_parse_subset_sequence ( &REPORT, &STATE, &BUFRDECO, err );
+      print_plain ( stdout, &REPORT );
+    }
+
+  bufrdeco_reset ( &BUFRDECO );
+  return res;
+}
@@ -183,3 +183,98 @@ int mtime_from_stat ( char *filename, struct stat *st )
   utime ( filename, &ut );
   return 1;
 }
+
+/*!
+  \fn int find_next_bufr ( unsigned char *buf, size_t len, size_t *pos, struct bin_message *m, size_t *nerr )
+  \brief Search the next bufr message in a NOAA bin buffer
+  \param buf pointer to the buffer with the whole input file
+  \param len length of buffer
+  \param pos pointer to offset where to begin to search. It is updated to continue the search with next call
+  \param m pointer to a struct \ref bin_message where to set the message found
+  \param nerr pointer to the counter of wrong messages
+
+  The messages are searched with \ref bufrdeco_iterator_find, so a message is wrong if it has more than
+  BUFRLEN - 1 bytes, it has not the '7777' at the length given in sec0 or it has a header mark inside, as
+  a false 'BUFR' whose length ends in the '7777' of a later message. Then the search goes on after its 'BUFR' mark. The NOAA header (header mark repeated four times, second header mark and name line)
+  is searched in the HEADLEN - 1 bytes preceding the 'BUFR'. A message without header is also wrong.
+
+  Returns 1 if a message is found, 0 if no more messages
+*/
+int find_next_bufr ( unsigned char *buf, size_t len, size_t *pos, struct bin_message *m, size_t *nerr )
+{
+  unsigned char mark[4], *c, *h, *q, *s, *w;
+  size_t nx, start;
+  int res;
+  struct bufrdeco_message_iterator it;
+
+  memset ( mark, HEADER_MARK, 4 );
+  bufrdeco_iterator_init_buffer ( &it, buf, len );
+  it.pos = *pos;
+  it.max_size = BUFRLEN - 1;
+
+  while ( 1 )
+    {
+      start = it.pos;
+      if ( ( res = bufrdeco_iterator_find ( &it, 0 ) ) < 0 )
+        break;
+      if ( res > 0 )
+        {
+          ( *nerr )++;
+          continue;
+        }
+
+      s = buf + it.offset;
+
+      // A message with a header mark inside is a false one spanning over next headers. Resync after its 'BUFR'
+      if ( memmem ( s, it.size, mark, 4 ) != NULL )
+        {
+          ( *nerr )++;
+          it.pos = it.offset + 4;
+          continue;
+        }
+
+      // The header, up to 'BUFR', cannot be longer than HEADLEN - 1 bytes
+      w = ( it.offset - start > HEADLEN - 1 ) ? s - ( HEADLEN - 1 ) : buf + start;
+
+      // Header init. The first header mark in window which is followed by a valid header
+      for ( h = memmem ( w, s - w, mark, 4 ); h != NULL; h = memmem ( h + 1, s - h - 1, mark, 4 ) )
+        {
+          // Header end
+          if ( ( q = memmem ( h + 1, s - h - 1, mark, 4 ) ) == NULL )
+            {
+              h = NULL;
+              break;
+            }
+
+          // Skip line terminators until the name
+          for ( c = q + 4; c < s && ( *c == 0x0a || *c == 0x0d ); c++ );
+          if ( c == s )
+            continue;
+
+          // the name, till a CR or 0x1a
+          m->name[0] = *c++;
+          for ( nx = 1; c < s && *c != 0x1a && *c != 0x0d; c++ )
+            m->name[nx++] = ( *c == ' ' ) ? '_' : *c;
+          if ( c == s )
+            continue;
+          m->name[nx] = '\0';
+          break;
+        }
+
+      if ( h == NULL )
+        {
+          ( *nerr )++;
+          continue;
+        }
+
+      m->header = h;
+      m->nh = s - h;
+      m->bufr = s;
+      m->nb = it.size;
+      *pos = it.pos;
+      return 1;
+    }
+
+  *pos = len;
+  return 0;
+}
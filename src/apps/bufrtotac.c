@@ -93,6 +93,7 @@ struct bufr2tac_subset_state STATE; /*!< Includes the info when parsing a subset
 const char SELF[]= "bufrtotac"; /*! < the name of this binary */
 char ERR[256]; /*!< string with an error */
 char BUFRTABLES_DIR[256]; /*!< Directory for BUFR tables set by user */
+char PROJECTION[256]; /*!< List of descriptors to decode set by user. If void all are decoded */
 char LISTOFFILES[256]; /*!< The pathname of a file which includes a list of bufr files to parse */
 char INPUTFILE[256]; /*!< The pathname of input file */
 char OUTPUTFILE[256]; /*!< The pathname of output file */
@@ -110,150 +111,267 @@ int NOTAC; /*!< if == 1 then do not decode to TAC */
 int FIRST_SUBSET; /*!< First subset index in output. First available is 0 */
 int LAST_SUBSET; /*!< Last subset index in output. First available is 0 */
 FILE *FL; /*!< Buffer to read the list of files */
+struct bufr_stream STREAM; /*!< Buffer to read bufr messages from a stream */
+int NWORKERS; /*!< Amount of workers decoding files in parallel */
+int UNORDERED; /*!< If == 1 the output of workers is not sorted as the input files */
 
-int main ( int argc, char *argv[] )
+/*!
+  \fn int bufrtotac_parse_message ( void )
+  \brief Parse the bufr message already read in BUFR, decode every subset to TAC and print the results
+  
+  Returns 0 if all is OK, 1 otherwise. In any case BUFR should be reset by caller
+*/
+int bufrtotac_parse_message ( void )
 {
   size_t subset;
   char subset_id[32];
   struct bufrdeco_subset_sequence_data *seq;
-  
 
-  if ( read_args ( argc, argv ) < 0 )
-    exit ( EXIT_FAILURE );
+  /* Prints sections if verbose */
+  if ( VERBOSE )
+    {
+      print_sec0_info ( &BUFR );
+      print_sec1_info ( &BUFR );
+      print_sec3_info ( &BUFR );
+      print_sec4_info ( &BUFR );
+    }
 
-  // init bufr struct
-  if ( bufrdeco_init ( &BUFR ) )
+  if ( bufrdeco_parse_tree ( &BUFR ) )
     {
-      printf ( "%s(): Cannot init bufr struct\n", SELF );
+      if ( DEBUG )
+        printf ( "# %s", BUFR.error );
       return 1;
     }
+  if ( VERBOSE )
+    bufrdeco_print_tree ( &BUFR );
 
-  // If needed mark to use ECMWF tables
-  if ( ECMWF )
-    BUFR.mask |= BUFRDECO_USE_ECMWF_TABLES;
-  
-  if ( HTML )
-    BUFR.mask |= BUFRDECO_OUTPUT_HTML;
+  // Jump to FIRST_SUBSET without decoding the previous ones. If not possible, we decode since subset 0
+  subset = 0;
+  if ( FIRST_SUBSET > 0 && ( size_t ) FIRST_SUBSET < BUFR.sec3.subsets &&
+       bufrdeco_seek_subset ( &BUFR, FIRST_SUBSET ) == 0 )
+    subset = FIRST_SUBSET;
 
-  /**** Set bufr tables dir ****/
-  strcpy(BUFR.bufrtables_dir , BUFRTABLES_DIR);
-  
-  /**** Big loop. a cycle per file ****/
-  while ( get_bufrfile_path ( INPUTFILE, ERR ) )
+  for ( ; subset < BUFR.sec3.subsets ; subset++ )
     {
-      //printf ( "%s\n", INPUTFILE );
-      if ( DEBUG )
-        printf ( "# %s\n", INPUTFILE );
-
-      // The following call to bufrdeco_read_bufr() does the folowing tasks:
-      // - Read the file and checks the marks at the begining and end to see wheter is a BUFR file
-      // - Init the structs and allocate the needed memory if not done previously
-      // - Splits and parse the BUFR sections (without expanding descriptors nor parsing data)
-      // - Reads the needed Table files and store them in memory.
-      if ( bufrdeco_read_bufr ( &BUFR, INPUTFILE ) )
+      // Here we get all subsets since the first decoded one, then we filter the subsets before FIRST_SUBSET
+      if ( subset > (size_t) LAST_SUBSET)
+          break;
+
+      if ( ( seq = bufrdeco_get_subset_sequence_data ( &BUFR ) ) == NULL )
         {
           if ( DEBUG )
-            printf ( "# %s\n", BUFR.error );
-          NFILES++;
-          bufrdeco_reset ( &BUFR );
-          continue;
+            printf ( "# %s", BUFR.error );
+          return 1;
         }
 
-      /* Try to guess a GTS header from filename*/
-      GTS_HEADER = guess_gts_header ( &BUFR.header , INPUTFILE );  // GTS_HEADER = 1 if succeeded
-      if ( GTS_HEADER && DEBUG )
-        printf ( "#%s %s %s %s %s\n", BUFR.header.timestamp, BUFR.header.bname, BUFR.header.center,
-                 BUFR.header.dtrel, BUFR.header.order );
-
-      /* Prints sections if verbose */
+      // But here we filter the subset array to show since FIRST_SUBSET
+      if (subset < (size_t) FIRST_SUBSET)
+          continue;
+      
       if ( VERBOSE )
         {
-          print_sec0_info ( &BUFR );
-          print_sec1_info ( &BUFR );
-          print_sec3_info ( &BUFR );
-          print_sec4_info ( &BUFR );
+          if ( ( subset == 0 ) && BUFR.sec3.compressed )
+            print_bufrdeco_compressed_data_references ( & ( BUFR.refs ) );
+          if ( BUFR.mask & BUFRDECO_OUTPUT_HTML )
+          {
+            sprintf(subset_id, "subset_%lu", subset);  
+            bufrdeco_print_subset_sequence_data_tagged_html ( seq, subset_id );
+          }
+          else
+            bufrdeco_print_subset_sequence_data ( seq );
         }
 
-      if ( bufrdeco_parse_tree ( &BUFR ) )
+      if ( ! NOTAC )
         {
-          if ( DEBUG )
-            printf ( "# %s", BUFR.error );
-          NFILES++;
-          bufrdeco_reset ( &BUFR );
-          continue;
-        }
-      if ( VERBOSE )
-        bufrdeco_print_tree ( &BUFR );
-
-      for ( subset = 0; subset < BUFR.sec3.subsets ; subset++ )
-        {
-          // Here we get all subsets since 0. FIRST_SUBSET here is not significant
-          if ( subset > (size_t) LAST_SUBSET)
-              break;
-
-          if ( ( seq = bufrdeco_get_subset_sequence_data ( &BUFR ) ) == NULL )
+          // Here we perform the decode to TAC  
+          if ( BUFR.sec3.ndesc &&  bufrdeco_parse_subset_sequence ( &REPORT, &STATE, &BUFR, ERR ) )
             {
               if ( DEBUG )
-                printf ( "# %s", BUFR.error );
-              goto fin;
+                fprintf ( stderr, "# %s\n", ERR );
             }
-
-          // But here we filter the subset array to show since FIRST_SUBSET
-          if (subset < (size_t) FIRST_SUBSET)
-              continue;
           
-          if ( VERBOSE )
+          // And here print the results
+          if ( XML )
             {
-              if ( ( subset == 0 ) && BUFR.sec3.compressed )
-                print_bufrdeco_compressed_data_references ( & ( BUFR.refs ) );
-              if ( BUFR.mask & BUFRDECO_OUTPUT_HTML )
-              {
-                sprintf(subset_id, "subset_%lu", subset);  
-                bufrdeco_print_subset_sequence_data_tagged_html ( seq, subset_id );
-              }
-              else
-                bufrdeco_print_subset_sequence_data ( seq );
+              if ( subset == 0 )
+                fprintf ( stdout, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+              print_xml ( stdout, &REPORT );
             }
-
-          if ( ! NOTAC )
+          else if ( JSON )
+            {
+              print_json ( stdout, &REPORT );
+            }
+          else if ( CSV )
+            {
+              if ( subset == 0 )
+                fprintf ( stdout, "TYPE,FILE,DATETIME,INDEX,NAME,COUNTRY,LATITUDE,LONGITUDE,ALTITUDE,REPORT\n" );
+              print_csv ( stdout, &REPORT );
+            }
+          else if ( HTML )
             {
-              // Here we perform the decode to TAC  
-              if ( BUFR.sec3.ndesc &&  bufrdeco_parse_subset_sequence ( &REPORT, &STATE, &BUFR, ERR ) )
-                {
-                  if ( DEBUG )
-                    fprintf ( stderr, "# %s\n", ERR );
-                }
-              
-              // And here print the results
-              if ( XML )
-                {
-                  if ( subset == 0 )
-                    fprintf ( stdout, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
-                  print_xml ( stdout, &REPORT );
-                }
-              else if ( JSON )
-                {
-                  print_json ( stdout, &REPORT );
-                }
-              else if ( CSV )
-                {
-                  if ( subset == 0 )
-                    fprintf ( stdout, "TYPE,FILE,DATETIME,INDEX,NAME,COUNTRY,LATITUDE,LONGITUDE,ALTITUDE,REPORT\n" );
-                  print_csv ( stdout, &REPORT );
-                }
-              else if ( HTML )
-                {
-                  print_html ( stdout, &REPORT );
-                }
-              else
-                {
-                  print_plain ( stdout, &REPORT );
-                }
+              print_html ( stdout, &REPORT );
+            }
+          else
+            {
+              print_plain ( stdout, &REPORT );
             }
         }
-    fin:
-      ;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrtotac_parse_file ( char *filename )
+  \brief Read a bufr file, decode it to TAC and print the results
+  \param filename complete path of bufr file
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrtotac_parse_file ( char *filename )
+{
+  int res;
+
+  //printf ( "%s\n", filename );
+  if ( DEBUG )
+    printf ( "# %s\n", filename );
+
+  // The following call to bufrdeco_read_bufr() does the folowing tasks:
+  // - Read the file and checks the marks at the begining and end to see wheter is a BUFR file
+  // - Init the structs and allocate the needed memory if not done previously
+  // - Splits and parse the BUFR sections (without expanding descriptors nor parsing data)
+  // - Reads the needed Table files and store them in memory.
+  if ( bufrdeco_read_bufr ( &BUFR, filename ) )
+    {
+      if ( DEBUG )
+        printf ( "# %s\n", BUFR.error );
       bufrdeco_reset ( &BUFR );
+      return 1;
+    }
+
+  /* Try to guess a GTS header from filename*/
+  GTS_HEADER = guess_gts_header ( &BUFR.header , filename );  // GTS_HEADER = 1 if succeeded
+  if ( GTS_HEADER && DEBUG )
+    printf ( "#%s %s %s %s %s\n", BUFR.header.timestamp, BUFR.header.bname, BUFR.header.center,
+             BUFR.header.dtrel, BUFR.header.order );
+
+  res = bufrtotac_parse_message ();
+  bufrdeco_reset ( &BUFR );
+  return res;
+}
+
+/*!
+  \fn int bufrtotac_parse_stream ( void )
+  \brief Parse a stream of bufr messages from standard input or a FIFO, as they arrive
+  
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrtotac_parse_stream ( void )
+{
+  int fd;
+  uint8_t *msg;
+  size_t size;
+
+  if ( strcmp ( INPUTFILE, "-" ) == 0 )
+    fd = STDIN_FILENO;
+  else if ( ( fd = open ( INPUTFILE, O_RDONLY ) ) < 0 )
+    {
+      printf ( "%s(): Cannot open '%s'\n", SELF, INPUTFILE );
+      return 1;
+    }
+
+  while ( get_bufr_from_stream ( fd, &msg, &size, &BUFR.header, ERR ) > 0 )
+    {
+      // The message is decoded in place from the stream buffer
+      if ( bufrdeco_read_buffer_view ( &BUFR, msg, size ) )
+        {
+          if ( DEBUG )
+            printf ( "# %s\n", BUFR.error );
+          NFILES++;
+          bufrdeco_reset ( &BUFR );
+          continue;
+        }
+
+      // GTS header, if any, is the heading preceding the message
+      GTS_HEADER = ( BUFR.header.bname[0] != '\0' );
+      strcpy ( BUFR.header.filename, INPUTFILE );
+      if ( GTS_HEADER && DEBUG )
+        printf ( "#%s %s %s %s\n", BUFR.header.bname, BUFR.header.center, BUFR.header.dtrel, BUFR.header.order );
+
+      bufrtotac_parse_message ();
+      bufrdeco_reset ( &BUFR );
+      NFILES ++;
+
+      // the consumer gets the results as soon as the message arrives
+      fflush ( stdout );
+    }
+
+  if ( ERR[0] && DEBUG )
+    printf ( "# %s\n", ERR );
+
+  if ( fd != STDIN_FILENO )
+    close ( fd );
+  free ( STREAM.buf );
+  memset ( &STREAM, 0, sizeof ( struct bufr_stream ) );
+  return 0;
+}
+
+int main ( int argc, char *argv[] )
+{
+  if ( read_args ( argc, argv ) < 0 )
+    exit ( EXIT_FAILURE );
+
+  // init bufr struct
+  if ( bufrdeco_init ( &BUFR ) )
+    {
+      printf ( "%s(): Cannot init bufr struct\n", SELF );
+      return 1;
+    }
+
+  // If needed mark to use ECMWF tables
+  if ( ECMWF )
+    BUFR.mask |= BUFRDECO_USE_ECMWF_TABLES;
+  
+  if ( HTML )
+    BUFR.mask |= BUFRDECO_OUTPUT_HTML;
+
+  // Read the bufr files mapping them in memory, with no copies
+  BUFR.mask |= BUFRDECO_USE_MMAP;
+
+  /**** Set bufr tables dir ****/
+  strcpy(BUFR.bufrtables_dir , BUFRTABLES_DIR);
+
+  /**** Set the descriptors to decode, if any ****/
+  if ( PROJECTION[0] && bufrdeco_set_projection ( &BUFR, PROJECTION ) )
+    {
+      printf ( "%s", BUFR.error );
+      bufrdeco_close ( &BUFR );
+      exit ( EXIT_FAILURE );
+    }
+
+  /**** Standard input or a FIFO are read as a stream of messages ****/
+  if ( LISTOFFILES[0] == 0 && is_stream_input ( INPUTFILE ) )
+    {
+      bufrtotac_parse_stream ();
+      bufrdeco_close ( &BUFR );
+      exit ( EXIT_SUCCESS );
+    }
+  
+  /**** Several workers decoding files in parallel ****/
+  if ( NWORKERS > 1 )
+    {
+      if ( bufrtotac_run_workers () )
+        {
+          bufrdeco_close ( &BUFR );
+          exit ( EXIT_FAILURE );
+        }
+      bufrdeco_close ( &BUFR );
+      exit ( EXIT_SUCCESS );
+    }
+
+  /**** Big loop. a cycle per file ****/
+  while ( get_bufrfile_path ( INPUTFILE, ERR ) )
+    {
+      bufrtotac_parse_file ( INPUTFILE );
       NFILES ++;
     } // End of big loop parsing files
 
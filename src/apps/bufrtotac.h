@@ -23,6 +23,10 @@
 */
 #include "bufrdeco.h"
 #include "bufr2tac.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 // To use package config.h
 #ifndef CONFIG_H
@@ -30,6 +34,73 @@
 # define CONFIG_H
 #endif
 
+/*!
+  \def STREAM_BLOCK
+  \brief Initial size and minimum read size of the buffer used to read a stream of bufr messages
+*/
+#define STREAM_BLOCK (1048576)
+
+/*!
+  \struct bufr_stream
+  \brief Buffer to read a stream of bufr messages from standard input or a FIFO
+*/
+struct bufr_stream
+{
+  uint8_t *buf; /*!< Buffer with data read from stream */
+  size_t dim; /*!< Allocated size of \a buf */
+  size_t len; /*!< Bytes of data in \a buf */
+  size_t pos; /*!< Offset in \a buf of first byte not yet parsed */
+  int eof; /*!< If != 0 no more data is available in stream */
+  size_t nerr; /*!< Amount of wrong messages skipped */
+};
+
+/*!
+  \struct bufrtotac_job
+  \brief A file to be decoded by a worker
+*/
+struct bufrtotac_job
+{
+  size_t idx; /*!< Index of file in the list of input files */
+  int lost; /*!< Amount of workers lost while decoding this file */
+  char file[256]; /*!< Pathname of file */
+};
+
+/*!
+  \struct bufrtotac_queue
+  \brief Files waiting for a worker. The files of lost workers go before the rest of input files
+*/
+struct bufrtotac_queue
+{
+  struct bufrtotac_job *retry; /*!< Array of files to decode again because their worker was lost */
+  int nretry; /*!< Amount of files in \a retry */
+  size_t nreq; /*!< Amount of files taken from the list of input files. It is the index of next one */
+  int nomore; /*!< If == 1 the list of input files is exhausted */
+};
+
+/*!
+  \struct bufrtotac_worker
+  \brief Data of a worker process decoding files in parallel
+*/
+struct bufrtotac_worker
+{
+  pid_t pid; /*!< Process id of worker */
+  int req; /*!< File descriptor where to write requests to worker. -1 if closed */
+  int res; /*!< File descriptor where to read results from worker. -1 if the worker has been lost */
+  int busy; /*!< If == 1 the worker is decoding a file */
+  struct bufrtotac_job job; /*!< The file being decoded if \a busy */
+};
+
+/*!
+  \struct bufrtotac_result
+  \brief Output of a file decoded by a worker, waiting to be written in order
+*/
+struct bufrtotac_result
+{
+  char *out; /*!< Output of the file */
+  size_t len; /*!< Length of \a out */
+  int done; /*!< If == 1 the file has been decoded */
+};
+
 extern struct bufrdeco BUFR;
 extern struct bufrdeco_subset_sequence_data SEQ;
 extern struct bufrdeco_compressed_data_references REF;
@@ -41,6 +112,7 @@ extern char ERR[256];
 extern char INPUTFILE[256];
 extern char OUTPUTFILE[256];
 extern char BUFRTABLES_DIR[256];
+extern char PROJECTION[256];
 extern char LISTOFFILES[256];
 extern int NFILES;
 extern int GTS_HEADER;
@@ -55,10 +127,26 @@ extern int HTML;
 extern int NOTAC;
 extern int FIRST_SUBSET, LAST_SUBSET;
 extern FILE *FL;
+extern struct bufr_stream STREAM;
+extern int NWORKERS;
+extern int UNORDERED;
 
 // functions
 void print_usage ( void );
 int read_args ( int _argc, char * _argv[] );
 char * get_bufrfile_path ( char *filename, char *err );
-int bufrdeco_parse_subset_sequence ( struct metreport *m, struct bufr2tac_subset_state *st, struct bufrdeco *b,
-                                     char *err );
+int is_stream_input ( char *filename );
+size_t read_stream ( int fd, char *err );
+int get_bufr_from_stream ( int fd, uint8_t **msg, size_t *size, struct gts_header *h, char *err );
+int bufrtotac_parse_message ( void );
+int bufrtotac_parse_stream ( void );
+int bufrtotac_parse_file ( char *filename );
+int write_all ( int fd, const void *buf, size_t n );
+int read_all ( int fd, void *buf, size_t n );
+void bufrtotac_worker_loop ( int req, int res );
+int bufrtotac_queue_get ( struct bufrtotac_queue *q, struct bufrtotac_job *j );
+int bufrtotac_send_next_file ( struct bufrtotac_worker *w, struct bufrtotac_queue *q );
+void bufrtotac_stop_workers ( struct bufrtotac_worker *w, int n );
+int bufrtotac_parse_file_to_buffer ( char *filename, char **out, size_t *len );
+void bufrtotac_write_result ( struct bufrtotac_result **r, size_t *dim, size_t *nout, size_t idx, char *out, size_t len );
+int bufrtotac_run_workers ( void );
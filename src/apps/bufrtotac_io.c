@@ -28,7 +28,7 @@ void print_usage ( void )
 {
   printf ( "%s %s\n", SELF, PACKAGE_VERSION );
   printf ( "Usage: \n" );
-  printf ( "%s -i input_file [-i input] [-I list_of_files] [-t bufrtable_dir] [-o output] [-s] [-v][-j][-x][-c][-h]\n" , SELF );
+  printf ( "%s -i input_file [-i input] [-I list_of_files] [-t bufrtable_dir] [-o output] [-P descriptors] [-s] [-v][-j][-x][-c][-w workers][-u][-h]\n" , SELF );
   printf ( "       -c. The output is in csv format\n" );
   printf ( "       -D. Print some debug info\n" );
 #ifdef USE_BUFRDC
@@ -36,15 +36,19 @@ void print_usage ( void )
 #endif
   printf ( "       -h Print this help\n" );
   printf ( "       -i Input file. Complete input path file for bufr file\n" );
+  printf ( "          If it is '-' or a FIFO then a stream of bufr messages is read and decoded as they arrive\n" );
   printf ( "       -I list_of_files. Pathname of a file with the list of files to parse, one filename per line\n" );
   printf ( "       -j. The output is in json format\n" );
   printf ( "       -n. Do not try to decode to TAC, just parse BUFR report\n" );
   printf ( "       -o output. Pathname of output file. Default is standar output\n" );
+  printf ( "       -P descriptors. Decode just these table B descriptors, as '001001/001002/012101'. Data of other elements is skipped\n" );
   printf ( "       -s prints a long output with explained sequence of descriptors\n" );
   printf ( "       -S first..last . Print only results for subsets in range first..last (First subset available is 0). Default is all subsets\n" );
   printf ( "       -t bufrtable_dir. Pathname of bufr tables directory. Ended with '/'\n" );
+  printf ( "       -u. With -w option, write the results as soon as they are available, not in the order of input files\n" );
   printf ( "       -V. Verbose output\n" );
   printf ( "       -v. Print version\n" );
+  printf ( "       -w workers. Number of workers decoding files in parallel. Default is 1\n" );
   printf ( "       -x. The output is in xml format\n" );
 }
 
@@ -67,6 +71,7 @@ int read_args ( int _argc, char * _argv[] )
   OUTPUTFILE[0] = '\0';
   LISTOFFILES[0] = '\0';
   BUFRTABLES_DIR[0] = '\0';
+  PROJECTION[0] = '\0';
   VERBOSE = 0;
   SHOW_SEQUENCE = 0;
   DEBUG = 0;
@@ -79,11 +84,13 @@ int read_args ( int _argc, char * _argv[] )
   NOTAC = 0;
   FIRST_SUBSET = 0;
   LAST_SUBSET = BUFR_LEN;
+  NWORKERS = 1;
+  UNORDERED = 0;
 
   /*
      Read input options
   */
-  while ( ( iopt = getopt ( _argc, _argv, "cDEhi:jHI:no:S:st:vVx" ) ) !=-1 )
+  while ( ( iopt = getopt ( _argc, _argv, "cDEhi:jHI:no:P:S:st:uvVw:x" ) ) !=-1 )
     switch ( iopt )
       {
       case 'i':
@@ -110,6 +117,15 @@ int read_args ( int _argc, char * _argv[] )
             strcpy ( BUFRTABLES_DIR, optarg );
           }
         break;
+      case 'P':
+        if ( strlen ( optarg ) >= 256 )
+          {
+            fprintf ( stderr, "read_args(): Too long list of descriptors in -P option\n" );
+            print_usage();
+            exit ( EXIT_FAILURE );
+          }
+        strcpy ( PROJECTION, optarg );
+        break;
       case 'D':
         DEBUG = 1;
         break;
@@ -157,6 +173,14 @@ int read_args ( int _argc, char * _argv[] )
               }
           }
         break;
+      case 'u':
+        UNORDERED = 1;
+        break;
+      case 'w':
+        NWORKERS = atoi ( optarg );
+        if ( NWORKERS < 1 )
+          NWORKERS = 1;
+        break;
       case 'x':
         XML = 1;
         break;
@@ -178,40 +202,6 @@ int read_args ( int _argc, char * _argv[] )
   return 1;
 }
 
-/* this is an interface to use bufr2tac */
-int bufrdeco_parse_subset_sequence ( struct metreport *m, struct bufr2tac_subset_state *st,
-                                     struct bufrdeco *b, char *err )
-{
-  size_t i;
-  int ksec1[40], res;
-  int *kdtlst;
-  size_t nlst = ( size_t ) b->sec3.ndesc;
-
-  // memory for kdtlst
-  if ( ( kdtlst = ( int * ) calloc ( 1, nlst * sizeof ( int ) ) ) == NULL )
-    {
-      sprintf ( err, "decobufr_parse_subset_sequence(): cannot alloc memory for kdtlst\n" );
-      return 1;
-    }
-
-  // sets descriptor as integer according to ECMWF
-  for ( i = 0; i < nlst ; i++ )
-    {
-      descriptor_to_integer ( &kdtlst[i], &b->sec3.unexpanded[i] );
-    }
-
-  // And now set only used ksec1 elements
-  ksec1[5] = b->sec1.category;
-  ksec1[6] = b->sec1.subcategory_local;
-
-  // Finaly we call to bufr2tac library
-  memset ( m, 0, sizeof ( struct metreport ) );
-  m->h = &b->header;
-  res = parse_subset_sequence ( m, &b->seq, st, kdtlst, nlst, ksec1, err );
-  free ( ( void * ) kdtlst );
-  return res;
-}
-
 /*!
   \fn char * get_bufrfile_path( char *filename, char *err)
   \brief Get bufr file names to parse
@@ -267,3 +257,128 @@ char * get_bufrfile_path ( char *filename, char *err )
       return NULL;
     }
 }
+
+/*!
+  \fn int is_stream_input ( char *filename )
+  \brief Checks if the input is a stream of bufr messages
+  \param filename pathname of input. '-' means standard input
+
+  Returns 1 if it is standard input, a FIFO, a socket or a character device. 0 otherwise
+*/
+int is_stream_input ( char *filename )
+{
+  struct stat st;
+
+  if ( strcmp ( filename, "-" ) == 0 )
+    return 1;
+
+  if ( stat ( filename, &st ) < 0 )
+    return 0;
+
+  if ( S_ISFIFO ( st.st_mode ) || S_ISSOCK ( st.st_mode ) || S_ISCHR ( st.st_mode ) )
+    return 1;
+
+  return 0;
+}
+
+/*!
+  \fn size_t read_stream ( int fd, char *err )
+  \brief Read more data from a stream into \ref STREAM buffer
+  \param fd file descriptor of stream
+  \param err string where to set the error if any
+
+  Already parsed data is discarded and the buffer is enlarged if needed. It blocks until some
+  data is available or the end of stream.
+
+  Returns the amount of bytes read
+*/
+size_t read_stream ( int fd, char *err )
+{
+  ssize_t n;
+  uint8_t *c;
+
+  // Discard parsed data
+  if ( STREAM.pos )
+    {
+      memmove ( STREAM.buf, STREAM.buf + STREAM.pos, STREAM.len - STREAM.pos );
+      STREAM.len -= STREAM.pos;
+      STREAM.pos = 0;
+    }
+
+  // Enlarge the buffer if needed
+  if ( ( STREAM.dim - STREAM.len ) < STREAM_BLOCK / 2 )
+    {
+      if ( ( c = realloc ( STREAM.buf, STREAM.dim + STREAM_BLOCK ) ) == NULL )
+        {
+          sprintf ( err, "read_stream(): Cannot allocate memory for stream buffer\n" );
+          STREAM.eof = 1;
+          return 0;
+        }
+      STREAM.buf = c;
+      STREAM.dim += STREAM_BLOCK;
+    }
+
+  do
+    {
+      n = read ( fd, STREAM.buf + STREAM.len, STREAM.dim - STREAM.len );
+    }
+  while ( n < 0 && errno == EINTR );
+
+  if ( n <= 0 )
+    {
+      if ( n < 0 )
+        sprintf ( err, "read_stream(): Error reading input stream\n" );
+      STREAM.eof = 1;
+      return 0;
+    }
+
+  STREAM.len += n;
+  return ( size_t ) n;
+}
+
+/*!
+  \fn int get_bufr_from_stream ( int fd, uint8_t **msg, size_t *size, struct gts_header *h, char *err )
+  \brief Get the next bufr message from a stream
+  \param fd file descriptor of stream
+  \param msg pointer where to set the pointer to the message in stream buffer
+  \param size pointer where to set the size of message
+  \param h pointer to a struct \ref gts_header where to set the GTS heading preceding the message, if any
+  \param err string where to set the error if any
+
+  The messages are searched with \ref bufrdeco_iterator_find in the data already read. Any data between messages
+  is skipped. A message longer than \ref BUFR_LEN or without the final '7777' at the length given in sec0 is
+  wrong, and the stream is resynced searching the next 'BUFR' mark. So we never wait for more than \ref BUFR_LEN
+  bytes of a message. The message is in the stream buffer and it is valid until next call.
+
+  Returns 1 if a message has been found. 0 at the end of stream
+*/
+int get_bufr_from_stream ( int fd, uint8_t **msg, size_t *size, struct gts_header *h, char *err )
+{
+  int res;
+  struct bufrdeco_message_iterator it;
+
+  while ( 1 )
+    {
+      bufrdeco_iterator_init_buffer ( &it, STREAM.buf + STREAM.pos, STREAM.len - STREAM.pos );
+      it.max_size = BUFR_LEN;
+      res = bufrdeco_iterator_find ( &it, ! STREAM.eof );
+      STREAM.pos += it.pos;
+      if ( res == 0 )
+        {
+          *msg = it.buf + it.offset;
+          *size = it.size;
+          *h = it.header;
+          return 1;
+        }
+      else if ( res > 0 )
+        {
+          STREAM.nerr++;
+          continue;
+        }
+
+      // No more complete messages in buffer
+      if ( STREAM.eof )
+        return 0;
+      read_stream ( fd, err );
+    }
+}
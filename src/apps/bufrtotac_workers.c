@@ -0,0 +1,501 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrtotac_workers.c
+ \brief file with the code to decode files with several workers in parallel
+
+ Every worker is a child process with its own decoder context (\ref BUFR, \ref REPORT and \ref STATE)
+ The parent reads the list of files and hands a file to every free worker through a pipe. The worker
+ writes the output for a file in a temporary file used as its standard output, and when finished
+ it sends the output back to the parent through another pipe. The parent writes the results
+ in the same order of input files or, if \ref UNORDERED, as soon as they arrive.
+ */
+
+#include "bufrtotac.h"
+
+/*!
+  \fn int write_all ( int fd, const void *buf, size_t n )
+  \brief Write \a n bytes in a file descriptor
+  \param fd file descriptor
+  \param buf pointer to data
+  \param n number of bytes to write
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int write_all ( int fd, const void *buf, size_t n )
+{
+  const char *c = buf;
+  ssize_t w;
+
+  while ( n )
+    {
+      if ( ( w = write ( fd, c, n ) ) < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+          return 1;
+        }
+      c += w;
+      n -= w;
+    }
+  return 0;
+}
+
+/*!
+  \fn int read_all ( int fd, void *buf, size_t n )
+  \brief Read \a n bytes from a file descriptor
+  \param fd file descriptor
+  \param buf pointer where to set data
+  \param n number of bytes to read
+
+  Returns 0 if all is OK, 1 on error or end of file
+*/
+int read_all ( int fd, void *buf, size_t n )
+{
+  char *c = buf;
+  ssize_t r;
+
+  while ( n )
+    {
+      if ( ( r = read ( fd, c, n ) ) <= 0 )
+        {
+          if ( r < 0 && errno == EINTR )
+            continue;
+          return 1;
+        }
+      c += r;
+      n -= r;
+    }
+  return 0;
+}
+
+/*!
+  \fn void bufrtotac_worker_loop ( int req, int res )
+  \brief The loop of a worker. It never returns
+  \param req file descriptor where to read the requests from parent
+  \param res file descriptor where to write the results to parent
+
+  A request is the index of file and its pathname. A result is the index of file and
+  the output of decode
+*/
+void bufrtotac_worker_loop ( int req, int res )
+{
+  size_t idx, len;
+  long pos;
+  ssize_t n;
+  FILE *tmp;
+  char buf[8192];
+
+  // The standard output is redirected to a temporary file
+  if ( ( tmp = tmpfile () ) == NULL )
+    _exit ( EXIT_FAILURE );
+  fflush ( stdout );
+  if ( dup2 ( fileno ( tmp ), STDOUT_FILENO ) < 0 )
+    _exit ( EXIT_FAILURE );
+
+  while ( read_all ( req, &idx, sizeof ( size_t ) ) == 0 )
+    {
+      if ( read_all ( req, &len, sizeof ( size_t ) ) || len >= sizeof ( INPUTFILE ) ||
+           read_all ( req, INPUTFILE, len ) )
+        break;
+      INPUTFILE[len] = '\0';
+
+      // Clean the output from previous file
+      if ( ftruncate ( STDOUT_FILENO, 0 ) )
+        break;
+      fseek ( stdout, 0, SEEK_SET );
+
+      bufrtotac_parse_file ( INPUTFILE );
+
+      fflush ( stdout );
+      if ( ( pos = ftell ( stdout ) ) < 0 )
+        break;
+
+      // send results
+      len = pos;
+      if ( write_all ( res, &idx, sizeof ( size_t ) ) || write_all ( res, &len, sizeof ( size_t ) ) )
+        break;
+      for ( pos = 0; ( size_t ) pos < len; pos += n )
+        {
+          if ( ( n = pread ( STDOUT_FILENO, buf, sizeof ( buf ), pos ) ) <= 0 ||
+               write_all ( res, buf, n ) )
+            _exit ( EXIT_FAILURE );
+        }
+    }
+
+  bufrdeco_close ( &BUFR );
+  _exit ( EXIT_SUCCESS );
+}
+
+/*!
+  \fn int bufrtotac_queue_get ( struct bufrtotac_queue *q, struct bufrtotac_job *j )
+  \brief Get the next file to decode
+  \param q pointer to the struct \ref bufrtotac_queue
+  \param j pointer to the struct \ref bufrtotac_job where to set the file
+
+  The files of lost workers are got first. Then the next ones in the list of input files
+
+  Returns 1 if there is a file, 0 otherwise
+*/
+int bufrtotac_queue_get ( struct bufrtotac_queue *q, struct bufrtotac_job *j )
+{
+  if ( q->nretry )
+    {
+      *j = q->retry[-- ( q->nretry )];
+      return 1;
+    }
+
+  if ( q->nomore || get_bufrfile_path ( INPUTFILE, ERR ) == NULL )
+    {
+      q->nomore = 1;
+      return 0;
+    }
+
+  NFILES++;
+  j->idx = ( q->nreq )++;
+  j->lost = 0;
+  strcpy ( j->file, INPUTFILE );
+  return 1;
+}
+
+/*!
+  \fn int bufrtotac_send_next_file ( struct bufrtotac_worker *w, struct bufrtotac_queue *q )
+  \brief Hands the next file in queue to an idle worker
+  \param w pointer to the struct \ref bufrtotac_worker
+  \param q pointer to the struct \ref bufrtotac_queue
+
+  If the request cannot be written the worker is dead. Then it is closed and the file goes back
+  to the queue for another worker. An idle worker is kept waiting, as a file of a lost worker may
+  still come back to the queue.
+
+  Returns 1 if a file has been sent to the worker, 0 otherwise
+*/
+int bufrtotac_send_next_file ( struct bufrtotac_worker *w, struct bufrtotac_queue *q )
+{
+  size_t len;
+
+  if ( w->req < 0 || w->busy || bufrtotac_queue_get ( q, & ( w->job ) ) == 0 )
+    return 0;
+
+  len = strlen ( w->job.file );
+  if ( write_all ( w->req, & ( w->job.idx ), sizeof ( size_t ) ) == 0 &&
+       write_all ( w->req, &len, sizeof ( size_t ) ) == 0 &&
+       write_all ( w->req, w->job.file, len ) == 0 )
+    {
+      w->busy = 1;
+      return 1;
+    }
+
+  // A dead worker. It had not begun to decode the file
+  q->retry[ ( q->nretry )++] = w->job;
+  close ( w->req );
+  close ( w->res );
+  w->req = -1;
+  w->res = -1;
+  return 0;
+}
+
+/*!
+  \fn void bufrtotac_stop_workers ( struct bufrtotac_worker *w, int n )
+  \brief Close the pipes of workers, so they finish, and wait for them
+  \param w pointer to the array of struct \ref bufrtotac_worker
+  \param n amount of workers in array
+*/
+void bufrtotac_stop_workers ( struct bufrtotac_worker *w, int n )
+{
+  int i;
+
+  for ( i = 0; i < n; i++ )
+    {
+      if ( w[i].req >= 0 )
+        close ( w[i].req );
+      if ( w[i].res >= 0 )
+        close ( w[i].res );
+      w[i].req = -1;
+      w[i].res = -1;
+    }
+  for ( i = 0; i < n; i++ )
+    waitpid ( w[i].pid, NULL, 0 );
+}
+
+/*!
+  \fn int bufrtotac_parse_file_to_buffer ( char *filename, char **out, size_t *len )
+  \brief Decode a file in the parent process, getting the output in memory as a worker does
+  \param filename pathname of file
+  \param out pointer where to set the allocated output. The caller must free it
+  \param len pointer where to set the length of output
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrtotac_parse_file_to_buffer ( char *filename, char **out, size_t *len )
+{
+  int fd;
+  off_t n;
+  FILE *tmp;
+
+  *out = NULL;
+  *len = 0;
+
+  fflush ( stdout );
+  if ( ( tmp = tmpfile () ) == NULL )
+    return 1;
+  if ( ( fd = dup ( STDOUT_FILENO ) ) < 0 || dup2 ( fileno ( tmp ), STDOUT_FILENO ) < 0 )
+    {
+      if ( fd >= 0 )
+        close ( fd );
+      fclose ( tmp );
+      return 1;
+    }
+
+  bufrtotac_parse_file ( filename );
+
+  // Restore the standard output
+  fflush ( stdout );
+  dup2 ( fd, STDOUT_FILENO );
+  close ( fd );
+
+  if ( ( n = lseek ( fileno ( tmp ), 0, SEEK_END ) ) > 0 &&
+       ( *out = malloc ( n ) ) != NULL &&
+       pread ( fileno ( tmp ), *out, n, 0 ) == n )
+    *len = n;
+  fclose ( tmp );
+  return ( n > 0 && *len == 0 ) ? 1 : 0;
+}
+
+/*!
+  \fn void bufrtotac_write_result ( struct bufrtotac_result **r, size_t *dim, size_t *nout, size_t idx, char *out, size_t len )
+  \brief Write the output of a file or, if not \ref UNORDERED, keep it until the output of all previous files is written
+  \param r pointer to the array of results waiting to be written. It is enlarged if needed
+  \param dim pointer to the amount of allocated items in \a r
+  \param nout pointer to the index of next file to write
+  \param idx index of file
+  \param out output of file. It can be NULL if there is no output. It is freed here
+  \param len length of \a out
+*/
+void bufrtotac_write_result ( struct bufrtotac_result **r, size_t *dim, size_t *nout, size_t idx, char *out, size_t len )
+{
+  struct bufrtotac_result *raux;
+
+  if ( UNORDERED )
+    {
+      if ( len )
+        fwrite ( out, 1, len, stdout );
+      free ( out );
+      return;
+    }
+
+  if ( idx >= *dim )
+    {
+      if ( ( raux = realloc ( *r, ( idx + 1024 ) * sizeof ( struct bufrtotac_result ) ) ) == NULL )
+        {
+          fprintf ( stderr, "%s(): Cannot allocate memory for results\n", SELF );
+          exit ( EXIT_FAILURE );
+        }
+      memset ( raux + *dim, 0, ( idx + 1024 - *dim ) * sizeof ( struct bufrtotac_result ) );
+      *r = raux;
+      *dim = idx + 1024;
+    }
+  ( *r ) [idx].out = out;
+  ( *r ) [idx].len = len;
+  ( *r ) [idx].done = 1;
+  for ( ; *nout < *dim && ( *r ) [*nout].done; ( *nout )++ )
+    {
+      if ( ( *r ) [*nout].len )
+        fwrite ( ( *r ) [*nout].out, 1, ( *r ) [*nout].len, stdout );
+      free ( ( *r ) [*nout].out );
+      ( *r ) [*nout].out = NULL;
+    }
+}
+
+/*!
+  \fn int bufrtotac_run_workers ( void )
+  \brief Decode all input files with \ref NWORKERS workers in parallel
+
+  If a worker is lost, i.e. it dies or its pipes fail, the file being decoded is reported in stderr and
+  handed to another worker. A file which has made to lose two workers is not tried again. If there
+  are no workers left, the parent decodes the remaining files.
+
+  Returns 0 if all is OK, 1 if there was an error or some worker has been lost
+*/
+int bufrtotac_run_workers ( void )
+{
+  int i, j, nbusy, res = 0, fdreq[2], fdres[2];
+  size_t dim = 0, nout = 0, idx, len;
+  struct bufrtotac_worker *w = NULL;
+  struct bufrtotac_result *r = NULL;
+  struct bufrtotac_queue q;
+  struct bufrtotac_job job;
+  struct pollfd *pfd = NULL;
+  void ( *sigpipe ) ( int );
+  char *out;
+
+  memset ( &q, 0, sizeof ( struct bufrtotac_queue ) );
+  // Every file goes to retry because a worker has been lost, so there are no more than NWORKERS
+  if ( ( w = calloc ( NWORKERS, sizeof ( struct bufrtotac_worker ) ) ) == NULL ||
+       ( pfd = calloc ( NWORKERS, sizeof ( struct pollfd ) ) ) == NULL ||
+       ( q.retry = calloc ( NWORKERS, sizeof ( struct bufrtotac_job ) ) ) == NULL )
+    {
+      fprintf ( stderr, "%s(): Cannot allocate memory for workers\n", SELF );
+      free ( w );
+      free ( pfd );
+      return 1;
+    }
+
+  // The output from parent must be written before forking
+  fflush ( stdout );
+
+  // Launch the workers
+  for ( i = 0; i < NWORKERS; i++ )
+    {
+      if ( pipe ( fdreq ) )
+        {
+          fprintf ( stderr, "%s(): Cannot create pipes for workers\n", SELF );
+          goto fail;
+        }
+      if ( pipe ( fdres ) )
+        {
+          fprintf ( stderr, "%s(): Cannot create pipes for workers\n", SELF );
+          close ( fdreq[0] );
+          close ( fdreq[1] );
+          goto fail;
+        }
+      if ( ( w[i].pid = fork () ) < 0 )
+        {
+          fprintf ( stderr, "%s(): Cannot create workers\n", SELF );
+          close ( fdreq[0] );
+          close ( fdreq[1] );
+          close ( fdres[0] );
+          close ( fdres[1] );
+          goto fail;
+        }
+      if ( w[i].pid == 0 )
+        {
+          // Child. Close parent ends, including the ones of previous workers
+          for ( j = 0; j < i; j++ )
+            {
+              close ( w[j].req );
+              close ( w[j].res );
+            }
+          close ( fdreq[1] );
+          close ( fdres[0] );
+          bufrtotac_worker_loop ( fdreq[0], fdres[1] );
+        }
+      close ( fdreq[0] );
+      close ( fdres[1] );
+      w[i].req = fdreq[1];
+      w[i].res = fdres[0];
+    }
+
+  // A lost worker must not kill the parent when writing a request
+  sigpipe = signal ( SIGPIPE, SIG_IGN );
+
+  // Hand files to idle workers and collect results while there are workers busy
+  while ( 1 )
+    {
+      for ( i = 0; i < NWORKERS; i++ )
+        bufrtotac_send_next_file ( &w[i], &q );
+
+      for ( i = 0, nbusy = 0; i < NWORKERS; i++ )
+        {
+          pfd[i].fd = w[i].busy ? w[i].res : -1;
+          pfd[i].events = POLLIN;
+          pfd[i].revents = 0;
+          nbusy += w[i].busy;
+        }
+      if ( nbusy == 0 )
+        break;
+
+      if ( poll ( pfd, NWORKERS, -1 ) < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+          fprintf ( stderr, "%s(): Error waiting for workers\n", SELF );
+          res = 1;
+          break;
+        }
+
+      for ( i = 0; i < NWORKERS; i++ )
+        {
+          if ( w[i].busy == 0 || pfd[i].revents == 0 )
+            continue;
+
+          out = NULL;
+          w[i].busy = 0;
+          if ( read_all ( w[i].res, &idx, sizeof ( size_t ) ) ||
+               read_all ( w[i].res, &len, sizeof ( size_t ) ) ||
+               ( out = malloc ( len + 1 ) ) == NULL ||
+               read_all ( w[i].res, out, len ) )
+            {
+              // A dead worker
+              free ( out );
+              close ( w[i].req );
+              close ( w[i].res );
+              w[i].req = -1;
+              w[i].res = -1;
+              res = 1;
+              w[i].job.lost++;
+              fprintf ( stderr, "%s(): Lost a worker decoding file '%s'\n", SELF, w[i].job.file );
+              if ( w[i].job.lost < 2 )
+                q.retry[ ( q.nretry )++] = w[i].job;
+              else
+                {
+                  fprintf ( stderr, "%s(): File '%s' not decoded\n", SELF, w[i].job.file );
+                  bufrtotac_write_result ( &r, &dim, &nout, w[i].job.idx, NULL, 0 );
+                }
+              continue;
+            }
+
+          bufrtotac_write_result ( &r, &dim, &nout, idx, out, len );
+        }
+    }
+
+  // If no workers are left, the parent decodes the files still in queue
+  while ( bufrtotac_queue_get ( &q, &job ) )
+    {
+      if ( bufrtotac_parse_file_to_buffer ( job.file, &out, &len ) )
+        fprintf ( stderr, "%s(): Cannot get the output of file '%s'\n", SELF, job.file );
+      bufrtotac_write_result ( &r, &dim, &nout, job.idx, out, len );
+    }
+
+  // results still waiting for a missing previous one, after an error
+  for ( ; nout < dim; nout++ )
+    {
+      if ( r[nout].done && r[nout].len )
+        fwrite ( r[nout].out, 1, r[nout].len, stdout );
+      free ( r[nout].out );
+    }
+  fflush ( stdout );
+
+  bufrtotac_stop_workers ( w, NWORKERS );
+  signal ( SIGPIPE, sigpipe );
+
+  free ( r );
+  free ( q.retry );
+  free ( pfd );
+  free ( w );
+  return res;
+
+fail:
+  bufrtotac_stop_workers ( w, i );
+  free ( q.retry );
+  free ( pfd );
+  free ( w );
+  return 1;
+}
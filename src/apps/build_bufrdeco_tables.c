@@ -31,6 +31,14 @@
 
    Following the ECMWF way to set the CodeFlag tables as C Tables, the original WMO CodeFlag Tables are named
    as C tables. Original WMO C tables with descriptors operators an A tables are no needed in this package.
+
+   With table type 'I' it reads the csv table files already built for a version and writes a binary image
+   of them, which \a bufrdeco maps in memory instead of parsing the csv files. The input file is the table B
+   csv file and the C and D files are searched in the same directory. Example
+
+   \code
+   build_bufrdeco_tables -t I -i BUFR_18_1_0_TableB_en.csv > BUFR_18_1_0_Tables_en.bin
+   \endcode
 */
 
 #include "bufrdeco.h"
@@ -57,7 +65,54 @@ void print_usage ( void )
   printf ( "%s -i input_file -t table_type [-e[-h]\n" , SELF );
   printf ( "       -h Print this help\n" );
   printf ( "       -e Source ECMWF, default WMO\n" );
-  printf ( "       -t table_type. (A = TableA, B = TableB, C = CodeFlag, D = TableD)\n" );
+  printf ( "       -t table_type. (A = TableA, B = TableB, C = CodeFlag, D = TableD, I = binary image)\n" );
+  printf ( "          With I the input is a csv table B file built by this tool. The tables C and D of same\n" );
+  printf ( "          version are read from same directory and a binary image of the three tables is written\n" );
+}
+
+/*!
+  \fn int build_tables_image ( void )
+  \brief Write in stdout the binary image of the csv tables whose table B file is \ref INPUT_FILE
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int build_tables_image ( void )
+{
+  char *c, error[1024];
+  struct bufr_tables *t = NULL;
+
+  if ( bufrdeco_init_tables ( &t ) )
+    {
+      fprintf ( stderr, "%s: Error. Cannot allocate memory for tables\n", SELF );
+      return 1;
+    }
+
+  // The names of tables C and D are the ones of table B changing the 'TableB'
+  strcpy ( t->b.path, INPUT_FILE );
+  if ( ( c = strrchr ( INPUT_FILE, '/' ) ) == NULL )
+    c = INPUT_FILE;
+  if ( ( c = strstr ( c, "TableB" ) ) == NULL )
+    {
+      fprintf ( stderr, "%s: Error. '%s' is not a table B csv file\n", SELF, INPUT_FILE );
+      bufrdeco_free_tables ( &t );
+      return 1;
+    }
+  c[5] = 'C';
+  strcpy ( t->c.path, INPUT_FILE );
+  c[5] = 'D';
+  strcpy ( t->d.path, INPUT_FILE );
+  c[5] = 'B';
+
+  if ( bufr_read_tableb_csv ( & ( t->b ), error ) || bufr_read_tablec_csv ( & ( t->c ), error ) ||
+       bufr_read_tabled_csv ( & ( t->d ), error ) || bufrdeco_write_tables_image ( t, stdout, error ) )
+    {
+      fprintf ( stderr, "%s: %s", SELF, error );
+      bufrdeco_free_tables ( &t );
+      return 1;
+    }
+
+  bufrdeco_free_tables ( &t );
+  return 0;
 }
 
 
@@ -109,6 +164,13 @@ int main ( int argc, char *argv[] )
       exit ( EXIT_FAILURE );
     }
 
+  if ( TABLE_TYPE[0] == 'I' || TABLE_TYPE[0] == 'i' )
+    {
+      if ( build_tables_image () )
+        exit ( EXIT_FAILURE );
+      exit ( EXIT_SUCCESS );
+    }
+
   if ( ( f = fopen ( INPUT_FILE, "r" ) ) == NULL )
     {
       fprintf ( stderr, "%s: Error. Cannot open file '%s'\n", SELF, INPUT_FILE );
@@ -199,7 +261,7 @@ int main ( int argc, char *argv[] )
               // Descriptor
               ix = strtoul ( &lin[0], &c, 10 );
               uint32_t_to_descriptor ( &desc, ix );
-              printf ( "\"%s\",", desc.c );
+              printf ( "\"%s\",", bufr_descriptor_to_string ( caux2, &desc ) );
 
               // detailed name and a void note
               bufr_charray_to_string ( caux, &lin[8], 64 );
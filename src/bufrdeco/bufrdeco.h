@@ -30,12 +30,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <getopt.h>
 #include <time.h>
 #include <math.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 //#define DEBUG
 
@@ -81,6 +85,19 @@
 */
 #define BUFR_MAXLINES_TABLEC (8192)
 
+/*!
+  \def BUFR_TABLEC_HASH_SIZE
+  \brief Size of the hash index of table C by descriptor and code. Power of 2 and bigger than \ref BUFR_MAXLINES_TABLEC
+*/
+#define BUFR_TABLEC_HASH_SIZE (16384)
+
+/*!
+  \def BUFR_TABLEC_BITS_SIZE
+  \brief Size of the pool of arrays by bit number (or code from 0 to 63) of table C. Descriptors not fitting in it
+  are looked up in the hash index
+*/
+#define BUFR_TABLEC_BITS_SIZE (16384)
+
 
 /*!
   \def BUFR_MAXLINES_TABLED
@@ -108,6 +125,38 @@
 */
 #define BUFR_EXPLAINED_LENGTH (256)
 
+/*!
+  \def BUFRDECO_STRING_BLOCK_SIZE
+  \brief Chars in every block of a struct \ref bufrdeco_string_arena
+*/
+#define BUFRDECO_STRING_BLOCK_SIZE (65536)
+
+/*!
+  \def BUFRDECO_SUBSET_DATA_INITIAL_DIM
+  \brief Initial dimension of array of struct \ref bufr_atom_data in a struct \ref bufrdeco_subset_sequence_data.
+  It grows as needed
+*/
+#define BUFRDECO_SUBSET_DATA_INITIAL_DIM (1024)
+
+/*!
+  \def BUFRDECO_COMPRESSED_REFS_INITIAL_DIM
+  \brief Initial dimension of array of struct \ref bufrdeco_compressed_ref in a struct \ref bufrdeco_compressed_data_references.
+  It grows as needed up to \ref BUFR_NMAXSEQ
+*/
+#define BUFRDECO_COMPRESSED_REFS_INITIAL_DIM (1024)
+
+/*!
+  \def BUFRDECO_ARENA_INITIAL_SIZE
+  \brief Bytes of the block of a struct \ref bufrdeco_arena when the memory needed by the template is still not known
+*/
+#define BUFRDECO_ARENA_INITIAL_SIZE (1024 * 1024)
+
+/*!
+  \def BUFRDECO_ARENA_ALIGN
+  \brief Alignment in bytes of every allocation in a struct \ref bufrdeco_arena
+*/
+#define BUFRDECO_ARENA_ALIGN (16)
+
 /*!
   \def CSV_MAXL
   \brief Maximum length in a string to be parsed as csv
@@ -180,6 +229,60 @@
 */
 #define DESCRIPTOR_IS_LOCAL (512)
 
+/*!
+ \def BUFR_VALUE_NUMERIC
+ \brief Kind of value of a table B descriptor: numeric, no string nor code nor flag
+*/
+#define BUFR_VALUE_NUMERIC (1)
+
+/*!
+ \def BUFR_VALUE_CCITT
+ \brief Kind of value of a table B descriptor: CCITT IA5 string
+*/
+#define BUFR_VALUE_CCITT (2)
+
+/*!
+ \def BUFR_VALUE_CODE_TABLE
+ \brief Kind of value of a table B descriptor: code table
+*/
+#define BUFR_VALUE_CODE_TABLE (3)
+
+/*!
+ \def BUFR_VALUE_FLAG_TABLE
+ \brief Kind of value of a table B descriptor: flag table
+*/
+#define BUFR_VALUE_FLAG_TABLE (4)
+
+/*!
+ \def BUFR_PLAN_VALUE
+ \brief Instruction of a compiled plan: get the data of a table B descriptor
+*/
+#define BUFR_PLAN_VALUE (1)
+
+/*!
+ \def BUFR_PLAN_REPLICATE
+ \brief Instruction of a compiled plan: begin a loop with a fixed amount of replications
+*/
+#define BUFR_PLAN_REPLICATE (2)
+
+/*!
+ \def BUFR_PLAN_DELAYED
+ \brief Instruction of a compiled plan: get the delayed replication factor and begin a loop with it
+*/
+#define BUFR_PLAN_DELAYED (3)
+
+/*!
+ \def BUFR_PLAN_END
+ \brief Instruction of a compiled plan: end of the body of a loop
+*/
+#define BUFR_PLAN_END (4)
+
+/*!
+ \def BUFR_PLAN_OPERATOR
+ \brief Instruction of a compiled plan: an operator descriptor, with f == 2
+*/
+#define BUFR_PLAN_OPERATOR (5)
+
 /*!
   \def BUFR_LEN_SEC1
   \brief Max length in bytes for a sec1
@@ -206,6 +309,20 @@
 */
 #define BUFR_MAX_EXPANDED_SEQUENCES (128)
 
+/*!
+  \def BUFR_MAX_PLAN_OPS
+  \brief Max amount of instructions in the compiled plan of a struct \ref bufrdeco_expanded_tree. Bigger templates are
+  decoded walking the tree
+*/
+#define BUFR_MAX_PLAN_OPS (4096)
+
+/*!
+  \def BUFR_MAX_PLAN_DEPTH
+  \brief Max nesting of sequences and replications in a compiled plan. It is also the max amount of replications
+  running at once in the interpreter
+*/
+#define BUFR_MAX_PLAN_DEPTH (32)
+
 /*!
   \def BUFR_MAX_QUALITY_DATA
   \brief Max amount of quality data which is maped by a struct \ref bufrdeco_bitmap_element
@@ -254,6 +371,85 @@
 */
 #define BUFRDECO_OUTPUT_XML (8)
 
+/*!
+  \def BUFRDECO_USE_MMAP
+  \brief bit mask to read bufr files mapping them in memory instead of copying them
+*/
+#define BUFRDECO_USE_MMAP (16)
+
+/*!
+  \def BUFRDECO_GTS_HEADING_LEN
+  \brief Max length of a GTS heading line preceding a BUFR message in a bulletin
+*/
+#define BUFRDECO_GTS_HEADING_LEN (64)
+
+/*!
+  \def BUFRDECO_TABLES_CACHE_SIZE
+  \brief Max amount of sets of tables kept in the process-wide cache of tables
+*/
+#define BUFRDECO_TABLES_CACHE_SIZE (16)
+
+/*!
+  \def BUFRDECO_TABLES_CACHE_BUDGET
+  \brief Default max amount of memory in bytes used by the sets of tables kept in cache
+*/
+#define BUFRDECO_TABLES_CACHE_BUDGET (64 * 1024 * 1024)
+
+/*!
+  \def BUFRDECO_TREE_CACHE_SIZE
+  \brief Max amount of descriptor trees kept in the process-wide cache of trees
+*/
+#define BUFRDECO_TREE_CACHE_SIZE (64)
+
+/*!
+  \def BUFRDECO_TREE_CACHE_BUDGET
+  \brief Default max amount of memory in bytes used by the descriptor trees kept in cache
+*/
+#define BUFRDECO_TREE_CACHE_BUDGET (32 * 1024 * 1024)
+
+/*!
+  \def BUFRDECO_COMPRESSED_COLUMNS_BUDGET
+  \brief Max amount of memory in bytes for the unpacked values of all subsets in compressed data. Bigger
+  messages are decoded subset by subset
+*/
+#define BUFRDECO_COMPRESSED_COLUMNS_BUDGET (128 * 1024 * 1024)
+
+/*!
+  \def BUFRDECO_COLUMN_NUMERIC
+  \brief Kind of a struct \ref bufrdeco_column with numeric values from table B
+*/
+#define BUFRDECO_COLUMN_NUMERIC (0)
+
+/*!
+  \def BUFRDECO_COLUMN_STRING
+  \brief Kind of a struct \ref bufrdeco_column with CCITT IA5 strings
+*/
+#define BUFRDECO_COLUMN_STRING (1)
+
+/*!
+  \def BUFRDECO_COLUMN_ASSOCIATED
+  \brief Kind of a struct \ref bufrdeco_column with associated fields (operator 2 04 YYY)
+*/
+#define BUFRDECO_COLUMN_ASSOCIATED (2)
+
+/*!
+  \def BUFRDECO_COLUMN_LOCAL
+  \brief Kind of a struct \ref bufrdeco_column with raw values of local descriptors
+*/
+#define BUFRDECO_COLUMN_LOCAL (3)
+
+/*!
+  \def BUFRDECO_TABLES_IMAGE_MAGIC
+  \brief First 8 bytes of a file with a binary image of tables
+*/
+#define BUFRDECO_TABLES_IMAGE_MAGIC "BUFRDTBL"
+
+/*!
+  \def BUFRDECO_TABLES_IMAGE_VERSION
+  \brief Version of the format of binary images of tables. Must be changed if struct \ref bufr_tables changes
+*/
+#define BUFRDECO_TABLES_IMAGE_VERSION (7)
+
 /*!
   \def BUFR_TABLEB_NAME_LENGTH
   \brief Max length (in chars) reserved for a name of variable in table B
@@ -277,7 +473,6 @@ struct bufr_descriptor
   uint8_t f; /*!< F part of descriptor, 2 bits */
   uint8_t x; /*!< X part of descriptor, 6 bits */
   uint8_t y; /*!< Y part of descriptor, 8 bits */
-  char c[8]; /*!< string with whole descriptor (6 decimal digits plus the 0x00 as the end of string */
 };
 
 /*!
@@ -301,18 +496,81 @@ struct bufr_atom_data
 {
   struct bufr_descriptor desc; /*!< struct \ref bufr_descriptor */
   uint32_t mask; /*!< Mask with for the type */
-  char name[BUFR_TABLEB_NAME_LENGTH]; /*!< String with the name of descriptor */
-  char unit[BUFR_TABLEB_UNIT_LENGTH]; /*!< String with the name of units */
   double val; /*!< Final value for the bufr descriptor data */
   int32_t escale; /*!< Scale applied to get the data */ 
   uint32_t associated; /*!< value for associated field, if any */
-  char cval[128]; /*!< String value for the bufr descriptor */
-  char ctable[BUFR_EXPLAINED_LENGTH]; /*!< Explained meaning for a code table */
-  struct bufr_sequence *seq; /*!< Pointer to the struct bufr_sequence to which this descriptor belongs to */
-  size_t ns; /*!< Element in bufr_sequence to which this descriptor belongs to */
   uint32_t is_bitmaped_by; /*!< Index of element in a struct \ref bufrdeco_subset_sequence_data which bitmap this one */ 
   uint32_t bitmap_to; /*!< Index of element in a struct \ref bufrdeco_subset_sequence_data which this one is mapping to */
   uint32_t related_to; /*!< Index of element ina struct \ref bufrdeco_subset_sequence_data which this one is related to */
+  const char *name; /*!< Name of descriptor. Usually it points to the item in table B */
+  const char *unit; /*!< Name of units. Usually it points to the item in table B */
+  const char *cval; /*!< String value for the bufr descriptor, in the strings of the decoder. "" if none */
+  const char *ctable; /*!< Explained meaning for a code or flag table, in the strings of the decoder. "" if none */
+  struct bufr_sequence *seq; /*!< Pointer to the struct bufr_sequence to which this descriptor belongs to */
+  size_t ns; /*!< Element in bufr_sequence to which this descriptor belongs to */
+};
+
+/*!
+  \struct bufrdeco_arena_chunk
+  \brief Header of memory given by a struct \ref bufrdeco_arena when its block is full. The memory follows the header
+*/
+struct bufrdeco_arena_chunk
+{
+  struct bufrdeco_arena_chunk *next; /*!< Next chunk, if any */
+  size_t size; /*!< Bytes after the header */
+};
+
+/*!
+  \struct bufrdeco_arena
+  \brief Working memory of a struct \ref bufrdeco for the current message
+
+  Memory is given by bump allocation in a single block and it is all released at once when the decoder is reset.
+  If a message needs more than the block, the rest is taken from chunks and the block is enlarged for next messages.
+*/
+struct bufrdeco_arena
+{
+  uint8_t *block; /*!< The block. NULL if still not allocated */
+  size_t size; /*!< Bytes of block */
+  size_t used; /*!< Bytes of block used */
+  size_t last; /*!< Offset in block of the latest allocation, which can grow in place */
+  size_t extra; /*!< Bytes used in chunks */
+  struct bufrdeco_arena_chunk *chunks; /*!< Chunks allocated when the block is full */
+};
+
+/*!
+  \struct bufrdeco_arena_hint
+  \brief Memory used by the latest messages decoded with an expanded tree, so next ones can allocate it all from start
+*/
+struct bufrdeco_arena_hint
+{
+  size_t bytes; /*!< Bytes used in the struct \ref bufrdeco_arena */
+  size_t atoms; /*!< Max amount of struct \ref bufr_atom_data used in a subset */
+  size_t refs; /*!< Amount of struct \ref bufrdeco_compressed_ref used */
+};
+
+/*!
+  \struct bufrdeco_string_block
+  \brief A block of memory for strings in a struct \ref bufrdeco_string_arena
+*/
+struct bufrdeco_string_block
+{
+  struct bufrdeco_string_block *next; /*!< Next block, if any */
+  size_t used; /*!< Chars used in this block */
+  char s[BUFRDECO_STRING_BLOCK_SIZE]; /*!< The chars */
+};
+
+/*!
+  \struct bufrdeco_string_arena
+  \brief The strings (string values and explained code tables) of the data of a subset
+
+  Strings are allocated one after other in blocks which are never moved nor freed until the decoder is closed,
+  so the pointers in a struct \ref bufr_atom_data keep valid until next subset is decoded.
+*/
+struct bufrdeco_string_arena
+{
+  struct bufrdeco_arena *arena; /*!< Where to allocate the blocks. If NULL they are allocated in heap */
+  struct bufrdeco_string_block *first; /*!< First block, or NULL if nothing allocated */
+  struct bufrdeco_string_block *current; /*!< Block in use. NULL if the arena is clean */
 };
 
 /*!
@@ -326,6 +584,9 @@ struct bufrdeco_subset_sequence_data
   size_t nd; /*!< number of current amount of data used in sequence */
   uint32_t ss; /*!< Index of subset in the bufr report */
   struct bufr_atom_data *sequence; /*!< the array of data associated to a expanded sequence */
+  size_t peak; /*!< Max amount of data used in a subset of current message */
+  size_t hint; /*!< Dimension to allocate first. If 0 then \ref BUFRDECO_SUBSET_DATA_INITIAL_DIM */
+  struct bufrdeco_arena *arena; /*!< Where to allocate the array. If NULL it is allocated in heap */
 };
 
 /*!
@@ -437,14 +698,52 @@ struct bufr_sequence
   char name[BUFR_EXPLAINED_LENGTH]; /*!< Name of sequence if any */
 };
 
+/*!
+  \struct bufr_plan_op
+  \brief An instruction of the compiled plan of a tree. See \ref bufrdeco_compile_plan
+
+  Data of table B are set when compiling, so when decoding there are no table lookups. Table B items are in the
+  tables of the tree, which is cached by the paths of tables.
+*/
+struct bufr_plan_op
+{
+  uint8_t op; /*!< Instruction, as \ref BUFR_PLAN_VALUE ... */
+  uint8_t kind; /*!< Kind of value, as \ref BUFR_VALUE_NUMERIC ... 0 if local descriptor or not in table B */
+  uint8_t replicated; /*!< 1 if decoded as member of a replication, 0 if as member of a sequence. Only the last ones
+                           are tagged with their sequence in the struct \ref bufr_atom_data */
+  uint16_t nbits; /*!< Width in bits from table B */
+  uint16_t ns; /*!< Index of descriptor in \a seq->lseq[] */
+  uint16_t tableb; /*!< Index of item in table B */
+  uint16_t n; /*!< Amount of loops for \ref BUFR_PLAN_REPLICATE */
+  uint16_t jump; /*!< For a loop, index of its \ref BUFR_PLAN_END. For \ref BUFR_PLAN_END, index of its loop */
+  int32_t scale; /*!< Scale from table B */
+  int32_t reference; /*!< Reference from table B */
+  struct bufr_sequence *seq; /*!< Sequence with the descriptor */
+  double factor; /*!< Multiplier to apply \a scale to values */
+};
+
+/*!
+  \struct bufr_plan
+  \brief Flat list of instructions to decode a subset of non compressed data, compiled from a tree
+*/
+struct bufr_plan
+{
+  size_t n; /*!< Amount of instructions used in \a op[]. 0 if the tree is not compiled */
+  struct bufr_plan_op op[BUFR_MAX_PLAN_OPS]; /*!< Array of instructions */
+};
+
 /*!
  \struct bufrdeco_expanded_tree
  \brief Array of structs \ref bufr_sequence
 */
 struct bufrdeco_expanded_tree
 {
+  int refcount; /*!< Number of users of this tree. A tree in cache is shared and never changed */
   size_t nseq; /*!< current number of structs */
+  uint8_t bitmap_operators; /*!< 1 if any sequence has operators 2 22 000 to 2 37 255, which use bitmaps */
+  struct bufrdeco_arena_hint hint; /*!< Memory used by messages with this tree */
   struct bufr_sequence seq[BUFR_MAX_EXPANDED_SEQUENCES]; /*!< array of structs */
+  struct bufr_plan plan; /*!< Compiled plan to decode non compressed subsets */
 };
 
 /*!
@@ -468,6 +767,11 @@ struct bufrdeco_compressed_ref
   uint32_t is_bitmaped_by; /*!< Index element in a struct \ref bufr_compressed_data_references which bitmap this one */ 
   uint32_t bitmap_to; /*!< Index element in a struct \ref bufr_compressed_data_references which this one is mapping to */
   uint32_t related_to; /*!< Index of element ina struct \ref bufr_compressed_data_references which this one is related to */
+  uint8_t unpacked; /*!< 1 if the values for all subsets are already unpacked in its column */
+  uint8_t kind; /*!< Kind of column, BUFRDECO_COLUMN_NUMERIC, BUFRDECO_COLUMN_STRING ... */
+  uint8_t value_kind; /*!< Kind of value, as \ref BUFR_VALUE_NUMERIC ... 0 for local descriptors */
+  double factor; /*!< Multiplier to apply \a escale to values */
+  size_t soffset; /*!< Offset of the column of strings in struct \ref bufrdeco_compressed_data_references member str */
 };
 
 /*!
@@ -479,6 +783,38 @@ struct bufrdeco_compressed_data_references
   size_t dim; /*!< dimension of array of compressed refs */
   size_t nd; /*!< current amount of data used */
   struct bufrdeco_compressed_ref *refs; /*!< pointer to allocated array */
+  size_t nsubsets; /*!< Subsets in every column of unpacked values. If 0 the columns are not used */
+  size_t cdim; /*!< Allocated dimension of \a val and \a missing */
+  double *val; /*!< Unpacked values. The column of ref i begins in val[i * nsubsets] */
+  uint8_t *missing; /*!< 1 if the value in \a val is missing */
+  size_t idim; /*!< Allocated dimension of \a ival */
+  uint32_t *ival; /*!< Room for the increments of a ref in all subsets when unpacking */
+  size_t sdim; /*!< Allocated dimension of \a str */
+  char *str; /*!< Unpacked strings of all CCITT refs */
+  size_t hint; /*!< Dimension of \a refs to allocate first. If 0 then \ref BUFRDECO_COMPRESSED_REFS_INITIAL_DIM */
+  struct bufrdeco_arena *arena; /*!< Where to allocate the arrays. If NULL they are allocated in heap */
+};
+
+/*!
+  \struct bufrdeco_column
+  \brief An element of the expanded template of a compressed message with its data for all subsets
+
+  The arrays point to memory in the struct \ref bufrdeco, valid until it is reset or closed.
+  Data is got as in the bits, i.e. bitmaps and quality operators are not applied.
+*/
+struct bufrdeco_column
+{
+  size_t index; /*!< Index of element in the expanded template. First is 0 */
+  size_t nsubsets; /*!< Number of subsets, i.e. dimension of arrays */
+  uint8_t kind; /*!< BUFRDECO_COLUMN_NUMERIC, BUFRDECO_COLUMN_STRING, BUFRDECO_COLUMN_ASSOCIATED or BUFRDECO_COLUMN_LOCAL */
+  struct bufr_descriptor desc; /*!< Descriptor of element */
+  const char *name; /*!< Name of descriptor */
+  const char *unit; /*!< Unit of descriptor */
+  int32_t escale; /*!< Scale of numeric values, as in table B after possible 2 02 YYY */
+  const double *val; /*!< Values for every subset. MISSING_REAL if missing. Not used for strings */
+  const uint8_t *missing; /*!< 1 if the data for a subset is missing */
+  const char *str; /*!< Strings. The one of subset ss begins at str + ss * slen */
+  size_t slen; /*!< Room for every string, including the final null char. 0 if not a string */
 };
 
 /*!
@@ -581,6 +917,7 @@ struct bufr_sec1
   uint8_t minute; /*!< minute */
   uint8_t second; /*!< second */
   uint8_t raw[BUFR_LEN_SEC1]; /*!< Raw data for sec1 as is in original BUFR file */
+  uint8_t *raw_ptr; /*!< Pointer to raw data for sec1. It points to \a raw or into a mapped or caller buffer */
 };
 
 /*!
@@ -591,6 +928,7 @@ struct bufr_sec2
 {
   uint32_t length;
   uint8_t raw[BUFR_LEN_SEC2]; /*!< Raw data for sec2 as is in original BUFR file */
+  uint8_t *raw_ptr; /*!< Pointer to raw data for sec2. It points to \a raw or into a mapped or caller buffer */
 };
 
 /*!
@@ -606,19 +944,71 @@ struct bufr_sec3
   uint32_t ndesc; /*!< Current number of unexpanded descriptors */
   struct bufr_descriptor unexpanded[BUFR_LEN_UNEXPANDED_DESCRIPTOR]; /*!< Array of unexpanded descriptors */
   uint8_t raw[BUFR_LEN_SEC3]; /*!< Raw data for sec3 as is in original BUFR file */
+  uint8_t *raw_ptr; /*!< Pointer to raw data for sec3. It points to \a raw or into a mapped or caller buffer */
+};
+
+/*!
+  \struct bufrdeco_bit_reader
+  \brief The data bits of sec4 as seen by the bit extracting functions \ref bit_reader_get_uint32_t and
+  \ref bit_reader_get_char_array
+*/
+struct bufrdeco_bit_reader
+{
+  const uint8_t *data; /*!< Pointer to first byte of data, i.e. byte 4 of sec4 */
+  size_t nbytes; /*!< Bytes which can be read since \a data, including the final '7777' */
 };
 
 /*!
   \struct bufr_sec4
   \brief Store a parsed sec4 from a bufr file
 
-  Note that member \a raw  must be initialized to allocate needed memory
+  Note that member \a raw  must be initialized to allocate needed memory. The bit readers always use
+  \a raw_ptr, which points to \a raw when the bufr has been copied or into the mapped file or caller
+  buffer when read with no copy. In both cases there are 4 bytes more ('7777') available after sec4.
 */
 struct bufr_sec4
 {
   uint32_t length; /*!< length of sec4 in bytes */
   size_t bit_offset; /*!< Offset to current first bit in raw data sec4 to parse */
   uint8_t raw[BUFR_LEN]; /*!< Pointer to a raw data for sec4 as in original BUFR file */
+  uint8_t *raw_ptr; /*!< Pointer to first byte of sec4 data being decoded */
+  struct bufrdeco_bit_reader bits; /*!< Reader of data bits. It is set with \a raw_ptr */
+};
+
+/*!
+  \struct bufrdeco_projection
+  \brief Set of table B descriptors to decode. The data of any other element is skipped
+
+  It is set with \ref bufrdeco_set_projection. If \a n is 0 all data is decoded
+*/
+struct bufrdeco_projection
+{
+  size_t n; /*!< Amount of descriptors in set. If 0 the projection is not active */
+  uint64_t set[1024]; /*!< Bit set indexed by the key of descriptor, as returned by \ref bufr_descriptor_to_key */
+};
+
+/*!
+  \struct bufrdeco_subset_index
+  \brief Bit offsets in sec4 where every subset of a non compressed message begins
+
+  It is built by \ref bufrdeco_build_subset_index just walking the widths of data, so a subset can be decoded
+  without decoding all previous ones (see \ref bufrdeco_seek_subset)
+*/
+struct bufrdeco_subset_index
+{
+  size_t n; /*!< Amount of offsets set. It is 0 if the index still is not built */
+  size_t dim; /*!< Allocated dimension of \a offset */
+  size_t *offset; /*!< offset[i] is the first data bit of subset i. The last one is the end of data */
+};
+
+/*!
+  \struct bufrdeco_input_map
+  \brief Data of a bufr file mapped in memory when using \ref BUFRDECO_USE_MMAP
+*/
+struct bufrdeco_input_map
+{
+  uint8_t *addr; /*!< Address of the mapped file. NULL if nothing is mapped */
+  size_t len; /*!< Length in bytes of mapped region */
 };
 
 /*!
@@ -627,20 +1017,18 @@ struct bufr_sec4
 */
 struct bufr_tableb_decoded_item
 {
-  uint8_t changed; /*!< flag. If 0 = not changed from table B. If 1 Changed */
   uint8_t x; /*!< x value of descriptor */
   uint8_t y; /*!< y value of descriptor */
   char key[8]; /*!< c value of descriptor */
   char name[BUFR_TABLEB_NAME_LENGTH]; /*!< name */
   char unit[BUFR_TABLEB_UNIT_LENGTH]; /*!< unit */
-  int32_t scale; /*!< escale */
-  int32_t scale_ori; /*!< escale as readed from table b */
-  int32_t reference; /*!< reference */
-  int32_t reference_ori; /*!< reference as readed from table b */
-  size_t nbits; /*!< bits */
-  size_t nbits_ori; /*!< bits as readed from table b */
-  size_t tablec_ref; /*!< item to point table c, if any */
+  int32_t scale; /*!< escale as readed from table b */
+  int32_t reference; /*!< reference as readed from table b. Changes by operator 2 03 YYY are in a \ref bufr_tableb_overlay */
+  size_t nbits; /*!< bits as readed from table b */
+  size_t tablec_ref; /*!< item to point table c, if any. Resolved when loading tables */
   size_t tabled_ref; /*!< item to point table d, if any */
+  uint8_t kind; /*!< Kind of value, as \ref BUFR_VALUE_NUMERIC ... Set from unit when reading table */
+  double factor; /*!< Multiplier to apply \a scale to values, as returned by \ref bufr_tableb_scale_factor */
 };
 
 /*!
@@ -655,7 +1043,7 @@ struct bufr_tableb
   size_t nlines; /*!< Current lines readed from file, i. e. used in array item[] */
   size_t x_start[64]; /*!< Index in array \a item[] for first x. x_start[j] is index for first descriptor which x == j */
   size_t num[64]; /*!< Amount of items for x. num[i] is the amount of items in array where x = i */
-  uint8_t y_ref[64][256]; /*!< index for y since first x. x_ref[i][j] is index since x_start[i] where y == j */
+  uint16_t dindex[64][256]; /*!< 1 + index in array \a item[] of descriptor 0 x y, as dindex[x][y]. 0 if not in table */
   struct bufr_tableb_decoded_item item[BUFR_MAXLINES_TABLEB]; /*!< Array with structs containing parsed lines readed from file */
 };
 
@@ -690,6 +1078,12 @@ struct bufr_tablec
   size_t y_ref[64][256]; /*!< index for first y since first x. x_ref[i][j] is index since x_start[i] where y == j */
   char l[BUFR_MAXLINES_TABLEC][96]; /*!< Array with lines readed from file */
   struct bufr_tablec_decoded_item item[BUFR_MAXLINES_TABLEC]; /*!< Array of decoded lines */
+  uint16_t dstart[64][256]; /*!< dstart[x][y] is 1 + index of first line or item for descriptor 0 x y. 0 if not in table */
+  uint64_t hash_key[BUFR_TABLEC_HASH_SIZE]; /*!< Keys (x, y, code) of the hash index, as built in \ref bufr_tablec_hash_key */
+  uint16_t hash_index[BUFR_TABLEC_HASH_SIZE]; /*!< 1 + index of line or item for a key in \a hash_key[]. 0 if free slot */
+  uint16_t bits_start[64][256]; /*!< 1 + offset in \a bits[] of the array of descriptor 0 x y. 0 if it has no array */
+  uint8_t bits_len[64][256]; /*!< Length of the array in \a bits[] of descriptor 0 x y, i.e. its greatest code + 1 */
+  uint16_t bits[BUFR_TABLEC_BITS_SIZE]; /*!< Pool of arrays. Item v of an array is 1 + index of line or item for bit (or code) v. 0 if it has no meaning */
 };
 
 
@@ -719,6 +1113,9 @@ struct bufr_tabled
   size_t num[64]; /*!< Amonut of lines for x. num[i] is the amount of items in array where x = i */
   char l[BUFR_MAXLINES_TABLED][128]; /*!< Array with lines readed from file */
   struct bufr_tabled_decoded_item item[BUFR_MAXLINES_TABLED];
+  struct bufr_descriptor desc[BUFR_MAXLINES_TABLED]; /*!< Element descriptor of every line in \a l[], already decoded */
+  uint16_t seq_start[64][256]; /*!< Index in \a l[] and \a desc[] of the first line of sequence 3 x y, as seq_start[x][y] */
+  uint16_t seq_num[64][256]; /*!< Amount of descriptors in sequence 3 x y, as seq_num[x][y]. 0 if not in table */
 };
 
 /*!
@@ -726,14 +1123,132 @@ struct bufr_tabled
   \brief Contains all tables needed to parse a bufr file
 
   All readed files need to be named an formed as ECMWF bufrdc package
+
+  Once loaded, the tables are not changed while decoding, so they can be shared by several
+  struct \ref bufrdeco (see \ref bufrdeco_share_tables). The changes made by operator descriptors
+  are kept in the \ref bufr_tableb_overlay of every decoder
 */
 struct bufr_tables
 {
+  int refcount; /*!< Amount of struct \ref bufrdeco using these tables. Freed when it reachs 0 */
+  struct bufrdeco_input_map image; /*!< If the tables are a mapped binary image, the mapped region. Otherwise NULL */
   struct bufr_tableb b; /*!< Table B */
   struct bufr_tablec c; /*!< Table C */
   struct bufr_tabled d; /*!< Table D */
 };
 
+/*!
+  \struct bufrdeco_tables_image_header
+  \brief Header of a file with a binary image of a struct \ref bufr_tables
+
+  The image is written by build_bufrdeco_tables and is just this header followed by the struct
+  \ref bufr_tables as is in memory, with all indexes built. It is only valid for the same version
+  of the library and the same machine architecture, what is checked with the fields of header
+*/
+struct bufrdeco_tables_image_header
+{
+  char magic[8]; /*!< \ref BUFRDECO_TABLES_IMAGE_MAGIC */
+  uint32_t version; /*!< \ref BUFRDECO_TABLES_IMAGE_VERSION */
+  uint32_t endian; /*!< 0x01020304 as written in the machine building the image */
+  uint64_t size; /*!< sizeof ( struct bufr_tables ) in the machine building the image */
+  char reserved[40]; /*!< Up to 64 bytes, so the struct \ref bufr_tables is well aligned */
+};
+
+/*!
+  \struct bufrdeco_tables_cache_entry
+  \brief A set of tables kept in the cache of tables
+*/
+struct bufrdeco_tables_cache_entry
+{
+  struct bufr_tables *t; /*!< Pointer to the tables. The cache owns a reference */
+  uint64_t last_use; /*!< Value of the cache clock when last used */
+};
+
+/*!
+  \struct bufrdeco_tables_cache
+  \brief Process-wide cache of loaded tables
+
+  The tables are keyed by the pathnames of table files, which include the directory and the master
+  table version. When the memory used is over the budget the least recently used set is released.
+*/
+struct bufrdeco_tables_cache
+{
+  volatile int lock; /*!< Spin lock, != 0 when in use */
+  size_t budget; /*!< Max amount of memory for tables in cache. 0 means the cache is not used */
+  size_t nt; /*!< Amount of sets of tables in array \a entry[] */
+  uint64_t clock; /*!< Counter incremented in every access */
+  size_t nhits; /*!< Amount of requests found in cache */
+  size_t nmiss; /*!< Amount of requests not found in cache */
+  struct bufrdeco_tables_cache_entry entry[BUFRDECO_TABLES_CACHE_SIZE]; /*!< Array of cached tables */
+};
+
+/*!
+  \struct bufrdeco_tree_cache_entry
+  \brief A descriptor tree kept in the cache of trees
+*/
+struct bufrdeco_tree_cache_entry
+{
+  uint32_t hash; /*!< Hash of the descriptors in sec3 and the paths of tables B and D */
+  char pathb[256]; /*!< Path of table B used to build the tree */
+  char pathd[256]; /*!< Path of table D used to build the tree */
+  struct bufrdeco_expanded_tree *t; /*!< Pointer to the tree. The cache owns a reference */
+  uint64_t last_use; /*!< Value of the cache clock when last used */
+};
+
+/*!
+  \struct bufrdeco_tree_cache
+  \brief Process-wide cache of parsed descriptor trees
+
+  The trees are keyed by the unexpanded descriptors in sec3 and the tables B and D used to expand them. So
+  messages with the same template share the same tree. When the memory used is over the budget the
+  least recently used tree is released.
+*/
+struct bufrdeco_tree_cache
+{
+  volatile int lock; /*!< Spin lock, != 0 when in use */
+  size_t budget; /*!< Max amount of memory for trees in cache. 0 means the cache is not used */
+  size_t nt; /*!< Amount of trees in array \a entry[] */
+  uint64_t clock; /*!< Counter incremented in every access */
+  size_t nhits; /*!< Amount of requests found in cache */
+  size_t nmiss; /*!< Amount of requests not found in cache */
+  struct bufrdeco_tree_cache_entry entry[BUFRDECO_TREE_CACHE_SIZE]; /*!< Array of cached trees */
+};
+
+/*!
+  \struct bufr_tableb_overlay
+  \brief Changes in table B made by operator 2 03 YYY while decoding a message
+
+  Only the changed items are stored, so the original values in the shared struct \ref bufr_tableb
+  are never modified. To reset it only the changed items need to be cleared.
+*/
+struct bufr_tableb_overlay
+{
+  size_t nchanged; /*!< Amount of changed items, used in array \a index[] */
+  size_t index[BUFR_MAXLINES_TABLEB]; /*!< Index in table B of changed items, in the order they were changed */
+  uint8_t changed[BUFR_MAXLINES_TABLEB]; /*!< changed[i] == 1 if item i in table B has a new reference */
+  int32_t reference[BUFR_MAXLINES_TABLEB]; /*!< New reference for item i in table B if changed[i] == 1 */
+};
+
+/*!
+  \struct bufrdeco_message_iterator
+  \brief Data to walk over a file or buffer with several BUFR messages, maybe framed as GTS bulletins
+*/
+struct bufrdeco_message_iterator
+{
+  uint8_t *buf; /*!< Pointer to the buffer with the messages */
+  size_t len; /*!< Size of buffer in bytes */
+  size_t pos; /*!< Offset in \a buf where to search the next message */
+  struct bufrdeco_input_map map; /*!< Mapped file when opened with \ref bufrdeco_iterator_open_file */
+  size_t offset; /*!< Offset in \a buf of current message */
+  size_t size; /*!< Size in bytes of current message */
+  size_t nmsg; /*!< Amount of messages found */
+  size_t nerr; /*!< Amount of wrong messages found */
+  size_t max_size; /*!< Max size in bytes of a message. Larger ones are wrong. If 0 there is no limit */
+  char heading[BUFRDECO_GTS_HEADING_LEN]; /*!< GTS heading preceding current message, if any */
+  struct gts_header header; /*!< GTS heading of current message, parsed */
+  char error[256]; /*!< String with detected errors, if any */
+};
+
 /*!
   \struct bufrdeco
   \brief This struct contains all needed data to parse and decode a BUFR file
@@ -750,12 +1265,18 @@ struct bufrdeco
   struct bufr_sec3 sec3; /*!< Parsed sec3 */
   struct bufr_sec4 sec4; /*!< Parsed sec4 */
   struct bufr_tables *tables; /*!< Pointer to a the struct containing all tables needed for a single bufr */
+  struct bufr_tableb_overlay tableb_overlay; /*!< Changes made in table B by operator descriptors in current message */
   struct bufrdeco_expanded_tree *tree; /*!< Pointer to a struct containing the parsed descriptor tree (without explansion) */
   struct bufrdeco_decoding_data_state state; /*!< Struct with data needed when parsing bufr */
   struct bufrdeco_compressed_data_references refs; /*!< struct with data references in case of compressed bufr */
   struct bufrdeco_subset_sequence_data seq; /*!< sequence with data subset after parse */
+  struct bufrdeco_string_arena strings; /*!< Strings of the data of the latest subset decoded */
+  struct bufrdeco_arena arena; /*!< Working memory for the current message */
   struct bufrdeco_bitmap_array bitmap; /*!< Stores data for bit-maps */
   struct bufrdeco_bitmap_related_vars brv; /*!< Stores data related with the aid of a bit-maps */
+  struct bufrdeco_subset_index sindex; /*!< Offsets of subsets in non compressed data */
+  struct bufrdeco_projection projection; /*!< Descriptors to decode. If not set all are decoded */
+  struct bufrdeco_input_map map; /*!< Mapped input file, if any */
   char bufrtables_dir[256]; /*!< string with the path of bufr table directories */
   char error[1024]; /*!< String with detected errors, if any */
 };
@@ -776,27 +1297,78 @@ int bufrdeco_reset ( struct bufrdeco *b );
 int bufrdeco_init_tables ( struct bufr_tables **t );
 int bufrdeco_free_tables ( struct bufr_tables **t );
 int bufrdeco_substitute_tables ( struct bufr_tables **replaced, struct bufr_tables *source, struct bufrdeco *b );
+int bufrdeco_share_tables ( struct bufrdeco *b, struct bufr_tables *source );
+int bufrdeco_tables_loaded ( struct bufr_tables *t, const char *pathb, const char *pathc, const char *pathd );
+int bufrdeco_prepare_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd );
+int bufrdeco_init_expanded_tree ( struct bufrdeco_expanded_tree **t );
+int bufrdeco_free_expanded_tree ( struct bufrdeco_expanded_tree **t );
+int bufrdeco_arena_reserve ( struct bufrdeco_arena *a, size_t size );
+void * bufrdeco_arena_alloc ( struct bufrdeco_arena *a, size_t size );
+void * bufrdeco_arena_realloc ( struct bufrdeco_arena *a, void *p, size_t old, size_t size );
+void bufrdeco_arena_free ( struct bufrdeco_arena *a, void *p );
+int bufrdeco_clean_arena ( struct bufrdeco_arena *a );
+int bufrdeco_free_arena ( struct bufrdeco_arena *a );
+int bufrdeco_prepare_arena ( struct bufrdeco *b );
 int bufrdeco_init_subset_sequence_data ( struct bufrdeco_subset_sequence_data *ba );
 int bufrdeco_clean_subset_sequence_data ( struct bufrdeco_subset_sequence_data *ba );
 int bufrdeco_free_subset_sequence_data ( struct bufrdeco_subset_sequence_data *ba );
 int bufrdeco_free_compressed_data_references ( struct bufrdeco_compressed_data_references *rf );
 int bufrdeco_init_compressed_data_references ( struct bufrdeco_compressed_data_references *rf );
+int bufrdeco_init_compressed_columns ( struct bufrdeco_compressed_data_references *rf, size_t nsubsets );
 int bufrdeco_increase_data_array ( struct bufrdeco_subset_sequence_data *s );
+int bufrdeco_increase_compressed_ref_array ( struct bufrdeco_compressed_data_references *r );
+int bufrdeco_init_atom_strings ( struct bufr_atom_data *a, size_t n );
+char * bufrdeco_string_arena_alloc ( struct bufrdeco_string_arena *sa, size_t len );
+const char * bufrdeco_string_arena_copy ( struct bufrdeco_string_arena *sa, const char *src );
+int bufrdeco_clean_string_arena ( struct bufrdeco_string_arena *sa );
+int bufrdeco_free_string_arena ( struct bufrdeco_string_arena *sa );
 
 // Read bufr functions
 int bufrdeco_read_bufr ( struct bufrdeco *b,  char *filename );
 int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size );
-int get_ecmwf_tablenames ( struct bufrdeco *b );
+int bufrdeco_read_buffer_view ( struct bufrdeco *b,  uint8_t *bufrx, size_t size );
+int bufrdeco_unmap_input ( struct bufrdeco *b );
+
+// Iterate over several messages
+int bufrdeco_iterator_init_buffer ( struct bufrdeco_message_iterator *it, uint8_t *buf, size_t len );
+int bufrdeco_iterator_open_file ( struct bufrdeco_message_iterator *it, char *filename );
+int bufrdeco_iterator_close ( struct bufrdeco_message_iterator *it );
+int bufrdeco_iterator_find ( struct bufrdeco_message_iterator *it, int more );
+int bufrdeco_iterator_next ( struct bufrdeco_message_iterator *it, struct bufrdeco *b );
+int bufrdeco_parse_gts_heading ( struct gts_header *h, char *heading, uint8_t *text, size_t len );
+
+// Cache of tables
+struct bufr_tables * bufrdeco_tables_cache_get ( const char *pathb, const char *pathc, const char *pathd );
+int bufrdeco_tables_cache_add ( struct bufr_tables *t );
+int bufrdeco_tables_cache_set_budget ( size_t budget );
+int bufrdeco_tables_cache_clear ( void );
+int bufrdeco_use_cached_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd );
+int bufrdeco_resolve_tables_dir ( struct bufrdeco *b, const char *dir1, const char *dir2 );
+
+// Cache of descriptor trees
+struct bufrdeco_expanded_tree * bufrdeco_tree_cache_get ( struct bufrdeco *b );
+int bufrdeco_tree_cache_add ( struct bufrdeco *b );
+int bufrdeco_tree_cache_set_budget ( size_t budget );
+int bufrdeco_tree_cache_clear ( void );
+
+// Binary images of tables
+int bufrdeco_tables_image_path ( char *image, const char *pathb );
+int bufrdeco_write_tables_image ( struct bufr_tables *t, FILE *f, char *error );
+int bufrdeco_map_tables_image ( struct bufr_tables **t, const char *image, char *error );
+int bufrdeco_load_tables_image ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd );
+int get_ecmwf_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd );
 int bufr_read_tables_ecmwf ( struct bufrdeco *b );
 int bufr_read_tableb ( struct bufr_tableb *tb, char *error );
 int bufr_read_tablec ( struct bufr_tablec *tc, char *error );
 int bufr_read_tabled ( struct bufr_tabled *td, char *error );
 
 // Read bufr WMO csv
-int get_wmo_tablenames ( struct bufrdeco *b );
+int get_wmo_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd );
 int bufr_read_tableb_csv ( struct bufr_tableb *tb, char *error );
 int bufr_read_tablec_csv ( struct bufr_tablec *tc, char *error );
 int bufr_read_tabled_csv ( struct bufr_tabled *td, char *error );
+int bufr_tabled_build_index ( struct bufr_tabled *td );
+int bufr_find_tabled_index ( size_t *index, struct bufr_tabled *td, uint16_t key );
 int bufr_read_tables_wmo ( struct bufrdeco *b );
 char * csv_quoted_string ( char *out, char *in );
 int parse_csv_line ( int *nt, char *tk[], char *lin );
@@ -836,11 +1408,15 @@ char * get_formatted_value_from_escale ( char *fmt, int32_t escale, double val )
 
 // To parse. General
 int bufrdeco_parse_tree ( struct bufrdeco *b );
+int bufrdeco_compile_plan ( struct bufrdeco *b );
 int bufrdeco_decode_data_subset ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco_compressed_data_references *r, struct bufrdeco *b );
 int bufrdeco_decode_subset_data_recursive ( struct bufrdeco_subset_sequence_data *s, struct bufr_sequence *l, struct bufrdeco *b );
+int bufrdeco_decode_subset_data_plan ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco *b );
 int bufrdeco_decode_replicated_subsequence ( struct bufrdeco_subset_sequence_data *s,
     struct bufr_replicator *r, struct bufrdeco *b );
 int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, struct bufr_descriptor *d, struct bufrdeco *b );
+int bufrdeco_build_subset_index ( struct bufrdeco *b );
+int bufrdeco_seek_subset ( struct bufrdeco *b, size_t ss );
 
 // To parse compressed bufr
 int bufrdeco_parse_compressed ( struct bufrdeco_compressed_data_references *r, struct bufrdeco *b );
@@ -853,10 +1429,24 @@ int bufrdeco_parse_f2_compressed ( struct bufrdeco_compressed_data_references *r
 int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrdeco *b, struct bufr_descriptor *d, int mode );
 int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a, struct bufrdeco_compressed_ref *r,
     size_t subset, struct bufrdeco *b );
+int32_t bufrdeco_compressed_ref_reference ( const struct bufrdeco_compressed_ref *r );
+int bufrdeco_unpack_compressed_column ( double *val, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b );
+int bufrdeco_unpack_compressed_strings ( char *str, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b );
 
 // To get parsed data
 struct bufrdeco_subset_sequence_data * bufrdeco_get_subset_sequence_data ( struct bufrdeco *b );
 
+// Columns of compressed data
+int bufrdeco_columns_count ( size_t *n, struct bufrdeco *b );
+int bufrdeco_get_column ( struct bufrdeco_column *c, size_t index, struct bufrdeco *b );
+int bufrdeco_get_column_int32 ( int32_t *v, size_t index, struct bufrdeco *b );
+int bufrdeco_search_column ( size_t *index, const struct bufr_descriptor *d, size_t from, struct bufrdeco *b );
+
+// To decode just some descriptors
+int bufrdeco_set_projection ( struct bufrdeco *b, const char *list );
+int bufrdeco_clear_projection ( struct bufrdeco *b );
+int bufrdeco_projection_skip ( struct bufrdeco *b, const struct bufr_descriptor *d );
+
 // To get bits functions
 uint32_t two_bytes_to_uint32 ( const uint8_t *source );
 uint32_t three_bytes_to_uint32 ( const uint8_t *source );
@@ -864,6 +1454,12 @@ size_t get_bits_as_uint32_t ( uint32_t *target, uint8_t *has_data, uint8_t *sour
                               size_t bit_length );
 size_t get_bits_as_char_array ( char *target, uint8_t *has_data, uint8_t *source, size_t *bit0_offset,
                                 size_t bit_length );
+size_t bit_reader_get_uint32_t ( uint32_t *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r,
+                                 size_t *bit0_offset, size_t bit_length );
+size_t bit_reader_get_char_array ( char *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r,
+                                   size_t *bit0_offset, size_t bit_length );
+size_t bit_reader_get_uint32_array ( uint32_t *target, const struct bufrdeco_bit_reader *r, size_t bit0_offset,
+                                    size_t bit_length, size_t n );
 
 // Utilities for tables
 char * bufrdeco_explained_table_val ( char *expl, size_t dim, struct bufr_tablec *tc, size_t *index,
@@ -874,13 +1470,26 @@ char * bufrdeco_explained_table_csv_val ( char *expl, size_t dim, struct bufr_ta
     struct bufr_descriptor *d, uint32_t ival );
 char * bufrdeco_explained_flag_csv_val ( char *expl, size_t dim, struct bufr_tablec *tc, struct bufr_descriptor *d,
     uint64_t ival, uint8_t nbits );
-int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b,
-    const char *key );
 int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d );
-int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, const char *key );
+int bufrdeco_tableb_item_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i, uint8_t kind );
+int bufrdeco_tableb_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d );
+int bufrdeco_tableb_item_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i, uint8_t kind );
+uint8_t bufr_tableb_value_kind ( const char *unit );
+double bufr_tableb_scale_factor ( int32_t escale );
+int bufr_tableb_set_metadata ( struct bufr_tableb *tb );
+int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, uint16_t key );
+int bufr_restore_original_tableb_item ( struct bufr_tableb *tb, struct bufrdeco *b, uint8_t mode, uint16_t key );
+int bufrdeco_tableb_reference ( int32_t *reference, struct bufrdeco *b, size_t i );
+int bufrdeco_tableb_change_reference ( struct bufrdeco *b, size_t i, int32_t reference );
+int bufrdeco_reset_tableb_overlay ( struct bufrdeco *b );
 int get_table_b_reference_from_uint32_t ( int32_t *target, uint8_t bits, uint32_t source );
-int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, const char *key );
-int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tablec *tc, const char *key, uint32_t code );
+int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, uint16_t key );
+int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tablec *tc, uint16_t key, uint32_t code );
+int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, uint16_t key );
+uint64_t bufr_tablec_hash_key ( uint32_t x, uint32_t y, uint32_t code );
+int bufr_tablec_build_index ( struct bufr_tablec *tc );
+int bufr_tablec_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t code );
+int bufr_tablec_bit_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t bit );
 
 // utilities for bitmaps
 int bufrdeco_allocate_bitmap ( struct bufrdeco *b );
@@ -891,6 +1500,10 @@ int bufrdeco_add_to_bitmap ( struct bufrdeco_bitmap *bm, uint32_t index_to, uint
 // utilities for descriptors
 int two_bytes_to_descriptor ( struct bufr_descriptor *d, const uint8_t *source );
 int uint32_t_to_descriptor ( struct bufr_descriptor *d, uint32_t id );
+uint16_t bufr_descriptor_to_key ( const struct bufr_descriptor *d );
+int bufr_key_to_descriptor ( struct bufr_descriptor *d, uint16_t key );
+char * bufr_descriptor_to_string ( char *target, const struct bufr_descriptor *d );
+char * bufr_key_to_string ( char *target, uint16_t key );
 int is_a_delayed_descriptor ( struct bufr_descriptor *d );
 int is_a_local_descriptor ( struct bufr_descriptor *d );
 int is_a_short_delayed_descriptor ( struct bufr_descriptor *d );
@@ -0,0 +1,235 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_columns.c
+ \brief This file has the code to get the data of compressed messages by columns
+
+ In a compressed message every element of the expanded template has its data for all subsets packed
+ together. Here such data is got as a column, i.e. an array with the value for every subset, which is what
+ is needed to read a few variables of many subsets, as in satellite or AMDAR reports.
+*/
+#include "bufrdeco.h"
+
+/*!
+  \fn static int bufrdeco_columns_prepare ( struct bufrdeco *b )
+  \brief Parse the compressed refs of current message if still not done and check the columns can be used
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+static int bufrdeco_columns_prepare ( struct bufrdeco *b )
+{
+  if ( b->sec3.compressed == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_columns_prepare(): Data is not compressed\n" );
+      return 1;
+    }
+
+  if ( b->tree == NULL || b->tree->nseq == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_columns_prepare(): Try to get columns without parsed tree\n" );
+      return 1;
+    }
+
+  if ( b->refs.nd == 0 && bufrdeco_parse_compressed ( & ( b->refs ), b ) )
+    {
+      return 1;
+    }
+
+  if ( b->refs.nsubsets == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_columns_prepare(): Cannot get memory for %lu columns of %u subsets\n",
+                ( unsigned long ) b->refs.nd, b->sec3.subsets );
+      return 1;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_columns_count ( size_t *n, struct bufrdeco *b )
+  \brief Get the number of columns, i.e. elements of the expanded template, of a compressed message
+  \param n where to set the result
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_columns_count ( size_t *n, struct bufrdeco *b )
+{
+  if ( bufrdeco_columns_prepare ( b ) )
+    return 1;
+
+  *n = b->refs.nd;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_get_column ( struct bufrdeco_column *c, size_t index, struct bufrdeco *b )
+  \brief Get the data for all subsets of an element in a compressed message
+  \param c pointer to the struct \ref bufrdeco_column where to set the results
+  \param index index of element. First is 0
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  The data is unpacked just the first time a column is requested, for this call or for the decoding of subsets with
+  \ref bufrdeco_get_subset_sequence_data. The arrays in \a c are valid until \a b is reset or closed.
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_get_column ( struct bufrdeco_column *c, size_t index, struct bufrdeco *b )
+{
+  struct bufrdeco_compressed_data_references *rf = & ( b->refs );
+  struct bufrdeco_compressed_ref *r;
+  double *val;
+  uint8_t *missing;
+
+  if ( bufrdeco_columns_prepare ( b ) )
+    return 1;
+
+  if ( index >= rf->nd )
+    {
+      sprintf ( b->error, "bufrdeco_get_column(): There is no column %lu. The message has %lu\n",
+                ( unsigned long ) index, ( unsigned long ) rf->nd );
+      return 1;
+    }
+
+  r = & ( rf->refs[index] );
+  val = rf->val + index * rf->nsubsets;
+  missing = rf->missing + index * rf->nsubsets;
+
+  if ( r->unpacked == 0 )
+    {
+      if ( r->kind == BUFRDECO_COLUMN_STRING )
+        {
+          if ( bufrdeco_unpack_compressed_strings ( rf->str + r->soffset, missing, r, b ) )
+            return 1;
+        }
+      else if ( bufrdeco_unpack_compressed_column ( val, missing, r, b ) )
+        {
+          return 1;
+        }
+      r->unpacked = 1;
+    }
+
+  c->index = index;
+  c->nsubsets = rf->nsubsets;
+  c->kind = r->kind;
+  memcpy ( & ( c->desc ), & ( r->desc ), sizeof ( struct bufr_descriptor ) );
+  c->name = r->name;
+  c->unit = r->unit;
+  c->escale = r->escale;
+  c->missing = missing;
+  if ( r->kind == BUFRDECO_COLUMN_STRING )
+    {
+      c->val = NULL;
+      c->str = rf->str + r->soffset;
+      c->slen = r->bits / 8 + 1;
+    }
+  else
+    {
+      c->val = val;
+      c->str = NULL;
+      c->slen = 0;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_get_column_int32 ( int32_t *v, size_t index, struct bufrdeco *b )
+  \brief Get the data for all subsets of a non string element in a compressed message as scaled integers
+  \param v array with room for b->sec3.subsets values where to set the results
+  \param index index of element. First is 0
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  Every value is the integer in the bits plus the reference, so the numeric value is v[ss] * 10^(-escale), with
+  the escale of the column got with \ref bufrdeco_get_column. Associated fields and local descriptors get their
+  values as in the column of doubles. A missing value is set as \ref MISSING_INTEGER.
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_get_column_int32 ( int32_t *v, size_t index, struct bufrdeco *b )
+{
+  size_t ss, n;
+  int32_t ref;
+  struct bufrdeco_column c;
+  struct bufrdeco_compressed_ref *r;
+
+  if ( bufrdeco_get_column ( &c, index, b ) )
+    return 1;
+
+  if ( c.kind == BUFRDECO_COLUMN_STRING )
+    {
+      sprintf ( b->error, "bufrdeco_get_column_int32(): Column %lu is a string\n", ( unsigned long ) index );
+      return 1;
+    }
+
+  r = & ( b->refs.refs[index] );
+  ref = bufrdeco_compressed_ref_reference ( r );
+  n = c.nsubsets;
+
+  if ( r->inc_bits == 0 )
+    {
+      for ( ss = 0; ss < n; ss++ )
+        v[ss] = c.missing[ss] ? MISSING_INTEGER : ref + ( int32_t ) r->ref0;
+      return 0;
+    }
+
+  // The increments again from the bits. The missing flags are already in the column
+  if ( bit_reader_get_uint32_array ( ( uint32_t * ) v, & ( b->sec4.bits ), r->bit0 + r->bits + 6, r->inc_bits, n ) == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_get_column_int32(): Cannot get inc_bits from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
+      return 1;
+    }
+  for ( ss = 0; ss < n; ss++ )
+    v[ss] = c.missing[ss] ? MISSING_INTEGER : ref + ( int32_t ) ( r->ref0 + ( uint32_t ) v[ss] );
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_search_column ( size_t *index, const struct bufr_descriptor *d, size_t from, struct bufrdeco *b )
+  \brief Search the first column of a descriptor in a compressed message
+  \param index where to set the index of column found
+  \param d pointer to the descriptor to search
+  \param from index of first column to check. To get next column of a replicated descriptor use the latest found + 1
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  Associated fields have the descriptor of the element they are associated to, so they are not returned.
+
+  Returns 0 if found, 1 otherwise
+*/
+int bufrdeco_search_column ( size_t *index, const struct bufr_descriptor *d, size_t from, struct bufrdeco *b )
+{
+  size_t i;
+  uint16_t key;
+  struct bufrdeco_compressed_ref *r;
+
+  if ( bufrdeco_columns_prepare ( b ) )
+    return 1;
+
+  key = bufr_descriptor_to_key ( d );
+  for ( i = from; i < b->refs.nd; i++ )
+    {
+      r = & ( b->refs.refs[i] );
+      if ( r->kind != BUFRDECO_COLUMN_ASSOCIATED && bufr_descriptor_to_key ( & ( r->desc ) ) == key )
+        {
+          *index = i;
+          return 0;
+        }
+    }
+  return 1;
+}
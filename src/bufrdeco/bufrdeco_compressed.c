@@ -58,10 +58,41 @@ int bufrdeco_parse_compressed ( struct bufrdeco_compressed_data_references *r, s
       return 1;
     }
 
+  // Values of every subset are unpacked by columns when first needed, if there is memory
+  bufrdeco_init_compressed_columns ( r, b->sec3.subsets );
+
   // all is OK
   return 0;
 }
 
+/*!
+  \fn int bufrdeco_increase_compressed_ref_array ( struct bufrdeco_compressed_data_references *r )
+  \brief doubles the allocated space for refs in a struct \ref bufrdeco_compressed_data_references, up to \ref BUFR_NMAXSEQ
+  \param r pointer to the target struct
+
+  Return 0 when success, otherwise return 1 and the struct is unmodified
+*/
+int bufrdeco_increase_compressed_ref_array ( struct bufrdeco_compressed_data_references *r )
+{
+  size_t n = r->dim * 2;
+  struct bufrdeco_compressed_ref *k;
+
+  if ( r->dim >= BUFR_NMAXSEQ ) // check if reached the limit
+    return 1;
+
+  if ( n > BUFR_NMAXSEQ )
+    n = BUFR_NMAXSEQ;
+
+  if ( ( k = ( struct bufrdeco_compressed_ref * ) bufrdeco_arena_realloc ( r->arena, r->refs, r->dim * sizeof ( struct bufrdeco_compressed_ref ),
+             n * sizeof ( struct bufrdeco_compressed_ref ) ) ) == NULL )
+    return 1;
+
+  memset ( k + r->dim, 0, ( n - r->dim ) * sizeof ( struct bufrdeco_compressed_ref ) );
+  r->refs = k;
+  r->dim = n;
+  return 0;
+}
+
 
 /*!
   \fn int bufrdeco_parse_compressed_recursive ( struct bufrdeco_compressed_data_references *r, struct bufr_sequence *l, struct bufrdeco *b )
@@ -158,7 +189,7 @@ int bufrdeco_parse_compressed_recursive ( struct bufrdeco_compressed_data_refere
                 }
             }
 
-          if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+          if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
             {
               r->nd += 1;
             }
@@ -180,7 +211,7 @@ int bufrdeco_parse_compressed_recursive ( struct bufrdeco_compressed_data_refere
             {
               // print_bufrdeco_compressed_ref ( rf );
               // associated field read with success
-              if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+              if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                 {
                   r->nd += 1;
                 }
@@ -233,7 +264,9 @@ int bufrdeco_parse_compressed_recursive ( struct bufrdeco_compressed_data_refere
                 }
 
               //print_bufrdeco_compressed_ref ( rf );
-              if ( r->nd < ( BUFR_NMAXSEQ -1 ) )
+              replicator.nloops = ( size_t ) rf->ref0;
+
+              if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                 {
                   r->nd += 1;
                 }
@@ -243,8 +276,6 @@ int bufrdeco_parse_compressed_recursive ( struct bufrdeco_compressed_data_refere
                   return 1;
                 }
 
-              replicator.nloops = ( size_t ) rf->ref0;
-
               // Check if this replicator is for a bit-map defining
               if ( b->state.bitmaping )
                 {
@@ -401,7 +432,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                 }
 
               //print_bufrdeco_compressed_ref ( rf );
-              if ( r->nd < ( BUFR_NMAXSEQ -1 ) )
+              if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                 {
                   r->nd += 1;
                 }
@@ -422,7 +453,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                 {
                   //print_bufrdeco_compressed_ref ( rf );
                   // associated field read with success
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -462,7 +493,8 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                       return 1;
                     }
                   //print_bufrdeco_compressed_ref ( rf );
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  replicator.nloops = ( size_t ) rf->ref0;
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -471,7 +503,6 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                       sprintf ( b->error, "bufrdeco_decode_replicated_subsequence_compressed(): Reached limit. Consider increas BUFR_NMAXSEQ\n" );
                       return 1;
                     }
-                  replicator.nloops = ( size_t ) rf->ref0;
                 }
 
               bufrdeco_decode_replicated_subsequence_compressed ( r, &replicator, b );
@@ -503,7 +534,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                     }
                   rf->related_to = b->bitmap.bmap[b->bitmap.nba - 1]->bitmap_to[ixloop];
 
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -530,7 +561,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                     }
 
                   rf->related_to = b->bitmap.bmap[b->bitmap.nba - 1]->bitmap_to[ixloop];
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -568,7 +599,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                       return 1;
                     }
                   rf->related_to = b->bitmap.bmap[b->bitmap.nba - 1]->bitmap_to[ixloop];
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -614,7 +645,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
                   rf->ref = - ( ( int32_t ) 1 << rf->bits );
                   rf->bits++;
                   rf->related_to = b->bitmap.bmap[b->bitmap.nba - 1]->bitmap_to[ixloop];
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -627,7 +658,7 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
 
               if ( l->lseq[i].x == 5 ) // cases wich produces a new ref
                 {
-                  if ( r->nd < ( BUFR_NMAXSEQ - 1 ) )
+                  if ( r->nd < ( r->dim - 1 ) || bufrdeco_increase_compressed_ref_array ( r ) == 0 )
                     {
                       r->nd += 1;
                     }
@@ -656,6 +687,149 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
   return 0;
 }
 
+/*!
+  \fn int32_t bufrdeco_compressed_ref_reference ( const struct bufrdeco_compressed_ref *r )
+  \brief Get the reference to add to the raw values of a ref in compressed data
+  \param r pointer to the struct \ref bufrdeco_compressed_ref
+
+  It is as in \ref bufrdeco_get_atom_data_from_compressed_data_ref. Local descriptors get the raw value and
+  associated fields have no reference when all the subsets have the same value.
+
+  Returns the reference
+*/
+int32_t bufrdeco_compressed_ref_reference ( const struct bufrdeco_compressed_ref *r )
+{
+  if ( r->kind == BUFRDECO_COLUMN_LOCAL )
+    return 0;
+  else if ( r->kind == BUFRDECO_COLUMN_ASSOCIATED )
+    return r->inc_bits ? r->ref : 0;
+  return r->ref;
+}
+
+/*!
+  \fn int bufrdeco_unpack_compressed_column ( double *val, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+  \brief Get the numeric values of a ref in compressed data for all subsets at once
+  \param val array of b->sec3.subsets doubles where to set the values, already with reference and scale applied
+  \param missing array of b->sec3.subsets flags where to set 1 if value is missing, 0 otherwise
+  \param r pointer to the struct \ref bufrdeco_compressed_ref. It must not be a string
+  \param b basic container struct \ref bufrdeco. Its member refs.ival must have room for all subsets
+
+  The increments are unpacked with \ref bit_reader_get_uint32_array and then converted in a loop without calls,
+  as done for a single subset in \ref bufrdeco_get_atom_data_from_compressed_data_ref. Associated fields are not
+  scaled and local descriptors get the raw value, never missing.
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_unpack_compressed_column ( double *val, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+{
+  size_t ss, n = b->sec3.subsets;
+  uint32_t *ival = b->refs.ival, ones;
+  int32_t ref = bufrdeco_compressed_ref_reference ( r );
+  double f = ( r->kind == BUFRDECO_COLUMN_NUMERIC ) ? r->factor : 1.0;
+
+  if ( ( r->has_data == 0 && r->kind != BUFRDECO_COLUMN_LOCAL ) || r->inc_bits == 0 )
+    {
+      // All the same
+      for ( ss = 0; ss < n; ss++ )
+        {
+          missing[ss] = ( r->has_data == 0 && r->kind != BUFRDECO_COLUMN_LOCAL );
+          val[ss] = missing[ss] ? MISSING_REAL : ( double ) ( ref + ( int32_t ) r->ref0 ) * f;
+        }
+      return 0;
+    }
+
+  if ( ival == NULL || b->refs.idim < n ||
+       bit_reader_get_uint32_array ( ival, & ( b->sec4.bits ), r->bit0 + r->bits + 6, r->inc_bits, n ) == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_unpack_compressed_column(): Cannot get inc_bits from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
+      return 1;
+    }
+
+  ones = ( r->kind == BUFRDECO_COLUMN_LOCAL ) ? 0 : 0xFFFFFFFFU >> ( 32 - r->inc_bits );
+  for ( ss = 0; ss < n; ss++ )
+    {
+      missing[ss] = ( ones && ival[ss] == ones );
+      val[ss] = missing[ss] ? MISSING_REAL : ( double ) ( ref + ( int32_t ) ( r->ref0 + ival[ss] ) ) * f;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_unpack_compressed_strings ( char *str, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+  \brief Get the strings of a CCITT ref in compressed data for all subsets
+  \param str where to set the strings. Every one takes r->bits / 8 + 1 chars
+  \param missing array of b->sec3.subsets flags where to set 1 if string is missing, 0 otherwise
+  \param r pointer to the struct \ref bufrdeco_compressed_ref with a string
+  \param b basic container struct \ref bufrdeco
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_unpack_compressed_strings ( char *str, uint8_t *missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+{
+  size_t ss, n = b->sec3.subsets, len = r->bits / 8 + 1, bit_offset, nc;
+  uint8_t has_data;
+
+  for ( ss = 0; ss < n; ss++, str += len )
+    {
+      if ( r->has_data == 0 )
+        {
+          str[0] = '\0';
+          missing[ss] = 1;
+        }
+      else if ( r->inc_bits == 0 )
+        {
+          // case of all data same, so copy the local ref
+          if ( ( nc = strlen ( r->cref0 ) ) >= len )
+            nc = len - 1;
+          memcpy ( str, r->cref0, nc );
+          str[nc] = '\0';
+          missing[ss] = 0;
+        }
+      else
+        {
+          bit_offset = r->bit0 + r->bits + 6 + r->inc_bits * 8 * ss;
+          if ( ( size_t ) r->inc_bits + 1 > len ||
+               bit_reader_get_char_array ( str, &has_data, & ( b->sec4.bits ), & bit_offset, r->inc_bits * 8 ) == 0 )
+            {
+              sprintf ( b->error, "bufrdeco_unpack_compressed_strings(): Cannot get uchars from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
+              return 1;
+            }
+          missing[ss] = ( has_data == 0 );
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn static int bufrdeco_compressed_column ( double **val, uint8_t **missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+  \brief Get the column with the numeric values of a ref for all subsets, unpacking it if still not done
+  \param val where to set the pointer to the values
+  \param missing where to set the pointer to the missing flags
+  \param r pointer to a numeric struct \ref bufrdeco_compressed_ref in b->refs
+  \param b basic container struct \ref bufrdeco
+
+  Returns 0 if succeeded, 1 if the columns are not used
+*/
+static int bufrdeco_compressed_column ( double **val, uint8_t **missing, struct bufrdeco_compressed_ref *r, struct bufrdeco *b )
+{
+  size_t i;
+  struct bufrdeco_compressed_data_references *rf = & ( b->refs );
+
+  if ( rf->nsubsets == 0 || r < rf->refs || r >= ( rf->refs + rf->nd ) )
+    return 1;
+
+  i = r - rf->refs;
+  if ( r->unpacked == 0 )
+    {
+      if ( bufrdeco_unpack_compressed_column ( rf->val + i * rf->nsubsets, rf->missing + i * rf->nsubsets, r, b ) )
+        return 1;
+      r->unpacked = 1;
+    }
+  *val = rf->val + i * rf->nsubsets;
+  *missing = rf->missing + i * rf->nsubsets;
+  return 0;
+}
+
 /*!
 
   \fn int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a, struct bufrdeco_compressed_ref *r, size_t subset, struct bufrdeco *b )
@@ -670,25 +844,30 @@ int bufrdeco_decode_replicated_subsequence_compressed ( struct bufrdeco_compress
 int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a, struct bufrdeco_compressed_ref *r,
     size_t subset, struct bufrdeco *b )
 {
-  size_t i, bit_offset;
+  size_t i, bit_offset, tablec_ref;
   uint8_t has_data;
   uint32_t ival, ival0;
-  int32_t ivals;
+  int32_t ivals = 0;
+  double *col = NULL;
+  uint8_t *miss;
+  char *cval, ctable[BUFR_EXPLAINED_LENGTH];
   struct bufr_tableb *tb;
 
   if ( is_a_local_descriptor ( & ( r->desc ) ) )
     {
       a->mask = DESCRIPTOR_IS_LOCAL;
       memcpy ( & ( a->desc ), & ( r->desc ), sizeof ( struct bufr_descriptor ) );
-      strcpy ( a->name, "LOCAL DESCRIPTOR" );
-      strcpy ( a->unit, "UNKNOWN" );
+      a->name = "LOCAL DESCRIPTOR";
+      a->unit = "UNKNOWN";
+      a->cval = "";
+      a->ctable = "";
       if ( r->inc_bits )
         {
           bit_offset = r->bit0 + r->bits + 6 + r->inc_bits * subset;
           // extract inc_bits data
-          if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & bit_offset, r->inc_bits ) == 0 )
+          if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & bit_offset, r->inc_bits ) == 0 )
             {
-              sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get associated bits from '%s'\n", r->desc.c );
+              sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get associated bits from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
               return 1;
             }
           a->val = ival + r->ref0;
@@ -700,16 +879,22 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
 
   // some utils pointers
   tb = & ( b->tables->b );
-  i = tb->x_start[r->desc.x] + tb->y_ref[r->desc.x][r->desc.y];
+  if ( bufr_find_tableb_index ( &i, tb, bufr_descriptor_to_key ( & ( r->desc ) ) ) )
+    {
+      sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): descriptor '%u%02u%03u' not found in table B\n",
+                r->desc.f, r->desc.x, r->desc.y );
+      return 1;
+    }
 
   a->mask = 0;
 
   // descriptor
   memcpy ( & ( a->desc ), & ( r->desc ), sizeof ( struct bufr_descriptor ) );
-  // name
-  strcpy ( a->name, r->name );
-  //unit
-  strcpy ( a->unit, r->unit );
+  // name and unit, kept in ref
+  a->name = r->name;
+  a->unit = r->unit;
+  a->cval = "";
+  a->ctable = "";
   //scale
   a->escale = r->escale;
 
@@ -732,7 +917,7 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
 
 
   // First we check about string fields
-  if ( strstr ( a->unit, "CCITT" ) != NULL )
+  if ( r->value_kind == BUFR_VALUE_CCITT )
     {
       if ( r->has_data == 0 )
         {
@@ -742,8 +927,8 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
 
       if ( r->inc_bits == 0 )
         {
-          // case of all data same, so copy the local ref
-          strcpy ( a->cval, r->cref0 );
+          // case of all data same, so just the local ref
+          a->cval = r->cref0;
           a->mask |= DESCRIPTOR_HAVE_STRING_VALUE;
         }
       else
@@ -751,11 +936,17 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
           // we have to extract chars from section data
           // compute the bit_offset
           bit_offset = r->bit0 + r->bits + 6 + r->inc_bits * 8 * subset;
-          if ( get_bits_as_char_array ( a->cval, &has_data, &b->sec4.raw[4], & bit_offset, r->inc_bits * 8 ) == 0 )
+          if ( ( cval = bufrdeco_string_arena_alloc ( & ( b->strings ), r->inc_bits + 1 ) ) == NULL )
             {
-              sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get uchars from '%s'\n", r->desc.c );
+              sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot allocate a string for '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
               return 1;
             }
+          if ( bit_reader_get_char_array ( cval, &has_data, & ( b->sec4.bits ), & bit_offset, r->inc_bits * 8 ) == 0 )
+            {
+              sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get uchars from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
+              return 1;
+            }
+          a->cval = cval;
           if ( has_data == 0 )
             {
               a->mask |= DESCRIPTOR_VALUE_MISSING;
@@ -771,8 +962,8 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
   // now we check for associated data
   if ( r->is_associated )
     {
-      strcpy ( a->name, "Associated value" );
-      strcpy ( a->unit, "Associated unit" );
+      a->name = "Associated value";
+      a->unit = "Associated unit";
       if ( r->has_data == 0 )
         {
           a->associated = MISSING_INTEGER;
@@ -789,9 +980,9 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
               // compute the bit_offset
               bit_offset = r->bit0 + r->bits + 6 + r->inc_bits * subset;
               // extract inc_bits data
-              if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & bit_offset, r->inc_bits ) == 0 )
+              if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & bit_offset, r->inc_bits ) == 0 )
                 {
-                  sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get associated bits from '%s'\n", r->desc.c );
+                  sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get associated bits from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
                   return 1;
                 }
               // finally get the associated data
@@ -820,15 +1011,25 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
     {
       ivals = r->ref + ( int32_t ) r->ref0;
     }
+  else if ( bufrdeco_compressed_column ( &col, &miss, r, b ) == 0 )
+    {
+      // Already unpacked for all subsets
+      if ( miss[subset] )
+        {
+          a->val = MISSING_REAL;
+          a->mask |= DESCRIPTOR_VALUE_MISSING;
+          return 0;
+        }
+    }
   else
     {
       // read inc_bits data
       // compute the bit_offset
       bit_offset = r->bit0 + r->bits + 6 + r->inc_bits * subset;
       // extract inc_bits data
-      if ( get_bits_as_uint32_t ( &ival0, &has_data, &b->sec4.raw[4], & bit_offset, r->inc_bits ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival0, &has_data, & ( b->sec4.bits ), & bit_offset, r->inc_bits ) == 0 )
         {
-          sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get inc_bits from '%s'\n", r->desc.c );
+          sprintf ( b->error, "get_bufr_atom_data_from_compressed_data_ref(): Cannot get inc_bits from '%u%02u%03u'\n", r->desc.f, r->desc.x, r->desc.y );
           return 1;
         }
 
@@ -845,24 +1046,30 @@ int bufrdeco_get_atom_data_from_compressed_data_ref ( struct bufr_atom_data *a,
     }
 
   // Get a numeric number
-  a->val = ( double ) ( ivals ) * pow10 ( ( double ) ( - r->escale ) );
+  if ( col != NULL )
+    a->val = col[subset];
+  else
+    a->val = ( double ) ( ivals ) * r->factor;
 
   //printf("ival = %lf\n", a->val);
-  if ( strstr ( a->unit, "CODE TABLE" ) == a->unit  || strstr ( a->unit, "Code table" ) == a->unit )
+  if ( r->value_kind == BUFR_VALUE_CODE_TABLE )
     {
       ival = ( uint32_t ) ( a->val + 0.5 );
       a->mask |= DESCRIPTOR_IS_CODE_TABLE;
-      if ( bufrdeco_explained_table_val ( a->ctable, 256, & ( b->tables->c ), & ( tb->item[i].tablec_ref ), & ( a->desc ), ival ) != NULL )
+      tablec_ref = tb->item[i].tablec_ref; // a copy, table B is not changed when decoding
+      if ( bufrdeco_explained_table_val ( ctable, BUFR_EXPLAINED_LENGTH, & ( b->tables->c ), &tablec_ref, & ( a->desc ), ival ) != NULL &&
+           ( a->ctable = bufrdeco_string_arena_copy ( & ( b->strings ), ctable ) ) != NULL )
         {
           a->mask |= DESCRIPTOR_HAVE_CODE_TABLE_STRING;
         }
     }
-  else if ( strstr ( a->unit,"FLAG" ) == a->unit || strstr ( a->unit,"Flag" ) == a->unit )
+  else if ( r->value_kind == BUFR_VALUE_FLAG_TABLE )
     {
       ival = ( uint32_t ) ( a->val + 0.5 );
       a->mask |= DESCRIPTOR_IS_FLAG_TABLE;
 
-      if ( bufrdeco_explained_flag_val ( a->ctable, 256, & ( b->tables->c ), & ( a->desc ), ival, r->bits ) != NULL )
+      if ( bufrdeco_explained_flag_val ( ctable, BUFR_EXPLAINED_LENGTH, & ( b->tables->c ), & ( a->desc ), ival, r->bits ) != NULL &&
+           ( a->ctable = bufrdeco_string_arena_copy ( & ( b->strings ), ctable ) ) != NULL )
         {
           a->mask |= DESCRIPTOR_HAVE_FLAG_TABLE_STRING;
         }
@@ -903,6 +1110,10 @@ int bufr_decode_subset_data_compressed ( struct bufrdeco_subset_sequence_data *s
   // then get sequence
   for ( i = 0; i < r->nd; i++ )
     {
+      // Data not wanted is not set
+      if ( bufrdeco_projection_skip ( b, & ( r->refs[i].desc ) ) )
+        continue;
+
       if ( bufrdeco_get_atom_data_from_compressed_data_ref ( & ( s->sequence[s->nd] ) , & ( r->refs[i] ), b->state.subset, b ) )
         return 1;
 
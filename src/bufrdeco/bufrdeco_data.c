@@ -74,6 +74,9 @@ int bufrdeco_decode_data_subset ( struct bufrdeco_subset_sequence_data *s, struc
       return 1;
     }
 
+  // and the strings of data from prior subset
+  bufrdeco_clean_string_arena ( & ( b->strings ) );
+
   // also we clean the possible defined bitmaps in prior subsets
   if ( bufrdeco_clean_bitmaps ( b ) )
     {
@@ -96,6 +99,14 @@ int bufrdeco_decode_data_subset ( struct bufrdeco_subset_sequence_data *s, struc
           return 1;
         }
     }
+  else if ( b->tree->plan.n )
+    {
+      // The tree is compiled
+      if ( bufrdeco_decode_subset_data_plan ( s, b ) )
+        {
+          return 1;
+        }
+    }
   else
     {
       if ( bufrdeco_decode_subset_data_recursive ( s, NULL, b ) )
@@ -116,22 +127,27 @@ int bufrdeco_decode_data_subset ( struct bufrdeco_subset_sequence_data *s, struc
   \param s pointer to source struct \ref bufrdeco_subset_sequence_data
 
   The amount of data in a bufr must be huge. In a first moment, the dimension of a sequence of structs
-  \ref bufr_atom_data is \ref BUFR_NMAXSEQ but may be increased. This function task is try to double the
+  \ref bufr_atom_data is \ref BUFRDECO_SUBSET_DATA_INITIAL_DIM but may be increased. This function task is try to double the
   allocated dimension and reallocate it.
 
   Return 0 when success, otherwise return 1 and the struct is unmodified
 */
 int bufrdeco_increase_data_array ( struct bufrdeco_subset_sequence_data *s )
 {
+  struct bufr_atom_data *k;
+
   if ( s->dim < ( BUFR_NMAXSEQ * 8 ) ) // check if reached the limit
     {
-      if ( ( s->sequence = ( struct bufr_atom_data * ) realloc ( ( void * ) s->sequence,
-                           s->dim * 2 * sizeof ( struct bufr_atom_data ) ) ) == NULL )
+      if ( ( k = ( struct bufr_atom_data * ) bufrdeco_arena_realloc ( s->arena, s->sequence, s->dim * sizeof ( struct bufr_atom_data ),
+                 s->dim * 2 * sizeof ( struct bufr_atom_data ) ) ) == NULL )
         {
           return 1;
         }
       else
         {
+          s->sequence = k;
+          memset ( s->sequence + s->dim, 0, s->dim * sizeof ( struct bufr_atom_data ) );
+          bufrdeco_init_atom_strings ( s->sequence + s->dim, s->dim );
           s->dim *= 2;
           return 0;
         }
@@ -142,6 +158,48 @@ int bufrdeco_increase_data_array ( struct bufrdeco_subset_sequence_data *s )
     }
 }
 
+/*!
+  \fn static void bufrdeco_init_subset_state ( struct bufrdeco *b )
+  \brief Set the decoding state as at the begin of a subset. Subset index and bit offset are not changed
+  \param b pointer to the base struct \ref bufrdeco
+*/
+static void bufrdeco_init_subset_state ( struct bufrdeco *b )
+{
+  b->state.added_bit_length = 0;
+  b->state.added_scale = 0;
+  b->state.added_reference = 0;
+  b->state.assoc_bits = 0;
+  b->state.changing_reference = 255;
+  b->state.fixed_ccitt = 0;
+  b->state.local_bit_reserved = 0;
+  b->state.factor_reference = 1;
+  b->state.quality_active = 0;
+  b->state.subs_active = 0;
+  b->state.retained_active = 0;
+  b->state.stat1_active = 0;
+  b->state.dstat_active = 0;
+  b->state.bitmaping = 0;
+  b->state.bitmap = NULL;
+}
+
+/*!
+  \fn static void bufrdeco_begin_subset ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco *b )
+  \brief Prepare the decoding of current subset of non compressed data
+  \param s pointer to the target struct \ref bufrdeco_subset_sequence_data
+  \param b pointer to the base struct \ref bufrdeco
+*/
+static void bufrdeco_begin_subset ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco *b )
+{
+  s->nd = 0;
+  s->ss = b->state.subset;
+  if ( b->state.subset == 0 )
+    {
+      b->state.bit_offset = 0;
+    }
+  // also reset reference and bits inc
+  bufrdeco_init_subset_state ( b );
+}
+
 /*!
   \fn int bufrdeco_decode_subset_data_recursive ( struct bufrdeco_subset_sequence_data *s, struct bufr_sequence *l, struct bufrdeco *b )
   \brief decode the data from a subset in a recursive way
@@ -161,29 +219,8 @@ int bufrdeco_decode_subset_data_recursive ( struct bufrdeco_subset_sequence_data
   if ( l == NULL )
     {
       //memset ( s, 0, sizeof ( struct bufr_subset_sequence_data ) );
-      s->nd = 0;
-      s->ss = b->state.subset;
       seq = & ( b->tree->seq[0] );
-      if ( b->state.subset == 0 )
-        {
-          b->state.bit_offset = 0;
-        }
-      // also reset reference and bits inc
-      b->state.added_bit_length = 0;
-      b->state.added_scale = 0;
-      b->state.added_reference = 0;
-      b->state.assoc_bits = 0;
-      b->state.changing_reference = 255;
-      b->state.fixed_ccitt = 0;
-      b->state.local_bit_reserved = 0;
-      b->state.factor_reference = 1;
-      b->state.quality_active = 0;
-      b->state.subs_active = 0;
-      b->state.retained_active = 0;
-      b->state.stat1_active = 0;
-      b->state.dstat_active = 0;
-      b->state.bitmaping = 0;
-      b->state.bitmap = NULL;
+      bufrdeco_begin_subset ( s, b );
     }
   else
     {
@@ -196,6 +233,16 @@ int bufrdeco_decode_subset_data_recursive ( struct bufrdeco_subset_sequence_data
       switch ( seq->lseq[i].f )
         {
         case 0:
+          if ( bufrdeco_projection_skip ( b, & ( seq->lseq[i] ) ) )
+            {
+              // Not wanted. Just skip its data
+              if ( bufrdeco_tableb_skip ( & ( s->sequence[s->nd] ), b, & ( seq->lseq[i] ) ) )
+                {
+                  return 1;
+                }
+              break;
+            }
+
           // Get data from table B
           if ( bufrdeco_tableb_val ( & ( s->sequence[s->nd] ), b, & ( seq->lseq[i] ) ) )
             {
@@ -303,19 +350,23 @@ int bufrdeco_decode_subset_data_recursive ( struct bufrdeco_subset_sequence_data
                   b->state.bitmaping = replicator.nloops; // set it properly
                 }
 
-              if ( s->nd < ( s->dim - 1 ) )
-                {
-                  ( s->nd ) ++;
-                }
-              else if ( bufrdeco_increase_data_array ( s ) == 0 )
-                {
-                  ( s->nd ) ++;
-                }
-              else
+              // The factor is kept only if wanted
+              if ( bufrdeco_projection_skip ( b, & ( seq->lseq[i + 1] ) ) == 0 )
                 {
+                  if ( s->nd < ( s->dim - 1 ) )
+                    {
+                      ( s->nd ) ++;
+                    }
+                  else if ( bufrdeco_increase_data_array ( s ) == 0 )
+                    {
+                      ( s->nd ) ++;
+                    }
+                  else
+                    {
 
-                  sprintf ( b->error, "bufr_decode_data_subset_recursive(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
-                  return 1;
+                      sprintf ( b->error, "bufr_decode_data_subset_recursive(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
+                      return 1;
+                    }
                 }
               bufrdeco_decode_replicated_subsequence ( s, &replicator, b );
 
@@ -379,6 +430,16 @@ int bufrdeco_decode_replicated_subsequence ( struct bufrdeco_subset_sequence_dat
           switch ( l->lseq[i].f )
             {
             case 0:
+              if ( bufrdeco_projection_skip ( b, & ( l->lseq[i] ) ) )
+                {
+                  // Not wanted. Just skip its data
+                  if ( bufrdeco_tableb_skip ( & ( s->sequence[s->nd] ), b, & ( l->lseq[i] ) ) )
+                    {
+                      return 1;
+                    }
+                  break;
+                }
+
               // Get data from table B
               if ( bufrdeco_tableb_val ( & ( s->sequence[s->nd] ), b, & ( l->lseq[i] ) ) )
                 {
@@ -495,18 +556,22 @@ int bufrdeco_decode_replicated_subsequence ( struct bufrdeco_subset_sequence_dat
                       return 1;
                     }
                   replicator.nloops = ( size_t ) s->sequence[s->nd].val;
-                  if ( s->nd < ( s->dim - 1 ) )
-                    {
-                      ( s->nd ) ++;
-                    }
-                  else if ( bufrdeco_increase_data_array ( s ) == 0 )
-                    {
-                      ( s->nd ) ++;
-                    }
-                  else
+                  // The factor is kept only if wanted
+                  if ( bufrdeco_projection_skip ( b, & ( l->lseq[i + 1] ) ) == 0 )
                     {
-                      sprintf ( b->error, "bufrdeco_decode_replicated_subsequence(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
-                      return 1;
+                      if ( s->nd < ( s->dim - 1 ) )
+                        {
+                          ( s->nd ) ++;
+                        }
+                      else if ( bufrdeco_increase_data_array ( s ) == 0 )
+                        {
+                          ( s->nd ) ++;
+                        }
+                      else
+                        {
+                          sprintf ( b->error, "bufrdeco_decode_replicated_subsequence(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
+                          return 1;
+                        }
                     }
                   bufrdeco_decode_replicated_subsequence ( s, &replicator, b );
                   ixd += replicator.ndesc + 1; // update ixd properly
@@ -676,3 +741,428 @@ int bufrdeco_decode_replicated_subsequence ( struct bufrdeco_subset_sequence_dat
     }
   return 0;
 }
+
+/*!
+  \fn static int bufrdeco_plan_plain_state ( struct bufrdeco *b )
+  \brief Check if the data of table B descriptors are as in table B, i.e. no operator is changing them
+  \param b pointer to the base struct \ref bufrdeco
+
+  Returns 1 if so, 0 otherwise
+*/
+static int bufrdeco_plan_plain_state ( struct bufrdeco *b )
+{
+  return b->state.added_bit_length == 0 && b->state.added_scale == 0 && b->state.added_reference == 0 &&
+         b->state.factor_reference == 1 && b->state.assoc_bits == 0 && b->state.changing_reference == 255 &&
+         b->state.dstat_active == 0 && b->tableb_overlay.nchanged == 0;
+}
+
+/*!
+  \fn static int bufrdeco_plan_val ( struct bufr_atom_data *a, const struct bufr_plan_op *o, int plain, struct bufrdeco *b )
+  \brief Get the data of a table B descriptor in a compiled plan
+  \param a pointer to a struct \ref bufr_atom_data where to set the results
+  \param o pointer to the instruction
+  \param plain 1 if no operator is changing the data of table B, as returned by \ref bufrdeco_plan_plain_state
+  \param b pointer to the base struct \ref bufrdeco
+
+  Numeric values are got here with the width, reference and multiplier in the instruction, unless an operator is
+  changing them. Other cases go through \ref bufrdeco_tableb_item_val, or \ref bufrdeco_tableb_val for local
+  descriptors and those not found in table B.
+
+  Return 0 if success, 1 otherwise
+*/
+static int bufrdeco_plan_val ( struct bufr_atom_data *a, const struct bufr_plan_op *o, int plain, struct bufrdeco *b )
+{
+  uint32_t ival;
+  uint8_t has_data;
+  struct bufr_descriptor *d = & ( o->seq->lseq[o->ns] );
+
+  if ( o->kind == 0 )
+    {
+      return bufrdeco_tableb_val ( a, b, d );
+    }
+
+  if ( plain == 0 || o->kind != BUFR_VALUE_NUMERIC )
+    {
+      return bufrdeco_tableb_item_val ( a, b, d, o->tableb, o->kind );
+    }
+
+  a->desc = *d;
+  a->mask = 0;
+  a->name = b->tables->b.item[o->tableb].name;
+  a->unit = b->tables->b.item[o->tableb].unit;
+  a->cval = "";
+  a->ctable = "";
+  a->escale = o->scale;
+  a->associated = MISSING_INTEGER;
+
+  if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), o->nbits ) == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_plan_val(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
+      return 1;
+    }
+
+  // Delayed descriptors allways have data
+  if ( has_data || d->x == 31 )
+    {
+      a->val = ( double ) ( ( int32_t ) ival + o->reference ) * o->factor;
+    }
+  else
+    {
+      a->val = MISSING_REAL;
+      a->mask |= DESCRIPTOR_VALUE_MISSING;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_decode_subset_data_plan ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco *b )
+  \brief Decode the data of current subset running the plan compiled from the tree
+  \param s pointer to the target struct \ref bufrdeco_subset_sequence_data
+  \param b pointer to the base struct \ref bufrdeco, with a compiled plan in \a b->tree->plan
+
+  The instructions made by \ref bufrdeco_compile_plan are run in order. The replications are loops kept in a stack,
+  so there is no recursion. Results are the same as with \ref bufrdeco_decode_subset_data_recursive. As there, a
+  wrong replication is abandoned and the decoding goes on after it.
+
+  Return 0 in case of success, 1 otherwise
+*/
+int bufrdeco_decode_subset_data_plan ( struct bufrdeco_subset_sequence_data *s, struct bufrdeco *b )
+{
+  size_t pc, depth = 0, nloops = 0;
+  size_t loop[BUFR_MAX_PLAN_DEPTH], left[BUFR_MAX_PLAN_DEPTH];
+  int plain, res;
+  struct bufr_plan_op *o;
+  struct bufr_plan *p = & ( b->tree->plan );
+
+  bufrdeco_begin_subset ( s, b );
+  plain = bufrdeco_plan_plain_state ( b );
+
+  for ( pc = 0; pc < p->n; pc++ )
+    {
+      o = & ( p->op[pc] );
+      res = 0;
+      switch ( o->op )
+        {
+        case BUFR_PLAN_VALUE:
+          if ( bufrdeco_projection_skip ( b, & ( o->seq->lseq[o->ns] ) ) )
+            {
+              // Not wanted. Just skip its data
+              if ( o->kind == 0 )
+                res = bufrdeco_tableb_val ( & ( s->sequence[s->nd] ), b, & ( o->seq->lseq[o->ns] ) );
+              else
+                res = bufrdeco_tableb_item_skip ( & ( s->sequence[s->nd] ), b, & ( o->seq->lseq[o->ns] ), o->tableb, o->kind );
+              break;
+            }
+          if ( ( res = bufrdeco_plan_val ( & ( s->sequence[s->nd] ), o, plain, b ) ) )
+            {
+              break;
+            }
+          if ( o->replicated == 0 )
+            {
+              s->sequence[s->nd].seq = o->seq;
+              s->sequence[s->nd].ns = o->ns;
+            }
+          if ( s->nd < ( s->dim - 1 ) || bufrdeco_increase_data_array ( s ) == 0 )
+            {
+              ( s->nd ) ++;
+            }
+          else
+            {
+              sprintf ( b->error, "bufrdeco_decode_subset_data_plan(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
+              res = 1;
+            }
+          break;
+
+        case BUFR_PLAN_DELAYED:
+          if ( ( res = bufrdeco_plan_val ( & ( s->sequence[s->nd] ), o, plain, b ) ) )
+            {
+              break;
+            }
+          if ( o->replicated == 0 )
+            {
+              s->sequence[s->nd].seq = o->seq;
+              s->sequence[s->nd].ns = o->ns;
+            }
+          nloops = ( size_t ) ( s->sequence[s->nd].val );
+
+          // The factor is kept only if wanted
+          if ( bufrdeco_projection_skip ( b, & ( o->seq->lseq[o->ns] ) ) == 0 )
+            {
+              if ( s->nd < ( s->dim - 1 ) || bufrdeco_increase_data_array ( s ) == 0 )
+                {
+                  ( s->nd ) ++;
+                }
+              else
+                {
+                  sprintf ( b->error, "bufrdeco_decode_subset_data_plan(): No more bufr_atom_data available. Check BUFR_NMAXSEQ\n" );
+                  res = 1;
+                  break;
+                }
+            }
+          break;
+
+        case BUFR_PLAN_REPLICATE:
+          nloops = o->n;
+          break;
+
+        case BUFR_PLAN_END:
+          if ( -- ( left[depth - 1] ) )
+            {
+              // Next loop
+              pc = loop[depth - 1];
+            }
+          else
+            {
+              depth--;
+            }
+          break;
+
+        case BUFR_PLAN_OPERATOR:
+          res = bufrdeco_parse_f2_descriptor ( s, & ( o->seq->lseq[o->ns] ), b );
+          plain = bufrdeco_plan_plain_state ( b );
+          break;
+
+        default:
+          sprintf ( b->error, "bufrdeco_decode_subset_data_plan(): Bad instruction in plan\n" );
+          res = 1;
+          break;
+        }
+
+      if ( res )
+        {
+          if ( depth == 0 )
+            {
+              return 1;
+            }
+          // Abandon the innermost replication
+          depth--;
+          pc = p->op[loop[depth]].jump;
+        }
+      else if ( o->op == BUFR_PLAN_REPLICATE || o->op == BUFR_PLAN_DELAYED )
+        {
+          if ( nloops == 0 )
+            {
+              // Nothing to replicate. Go to its end
+              pc = o->jump;
+            }
+          else
+            {
+              loop[depth] = pc;
+              left[depth] = nloops;
+              depth++;
+            }
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn static int bufrdeco_skip_subset_data_recursive ( struct bufr_atom_data *a, struct bufr_sequence *l, size_t i0, size_t n, size_t nbits, struct bufrdeco *b )
+  \brief Skip the data of some descriptors of a sequence in non compressed data, in a recursive way
+  \param a pointer to a struct \ref bufr_atom_data used as scratch
+  \param l pointer to the source struct \ref bufr_sequence
+  \param i0 index of first descriptor in \a l->lseq[] to skip
+  \param n amount of descriptors to skip
+  \param nbits length of data in sec4 in bits
+  \param b pointer to the base struct \ref bufrdeco
+
+  This is \ref bufrdeco_decode_subset_data_recursive just updating the bit offset. Only the delayed replication
+  factors are decoded. Operators which need bitmaps or the data itself, as 2 03 YYY or 2 22 000 to 2 37 255, are not
+  supported here.
+
+  Return 0 in case of success, 1 otherwise
+*/
+static int bufrdeco_skip_subset_data_recursive ( struct bufr_atom_data *a, struct bufr_sequence *l, size_t i0, size_t n,
+    size_t nbits, struct bufrdeco *b )
+{
+  size_t i, ixloop, nloops, ndesc;
+
+  for ( i = i0; i < ( i0 + n ) && i < l->ndesc; i++ )
+    {
+      switch ( l->lseq[i].f )
+        {
+        case 0:
+          if ( bufrdeco_tableb_skip ( a, b, & ( l->lseq[i] ) ) )
+            {
+              return 1;
+            }
+          break;
+
+        case 1:
+          ndesc = l->lseq[i].x;
+          if ( l->lseq[i].y != 0 )
+            {
+              nloops = l->lseq[i].y;
+            }
+          else
+            {
+              // case of delayed. Here we need the value
+              i++;
+              if ( bufrdeco_tableb_val ( a, b, & ( l->lseq[i] ) ) )
+                {
+                  return 1;
+                }
+              if ( a->val == MISSING_REAL )
+                {
+                  sprintf ( b->error, "bufrdeco_skip_subset_data_recursive(): Missing delayed replication factor\n" );
+                  return 1;
+                }
+              nloops = ( size_t ) a->val;
+            }
+          for ( ixloop = 0; ixloop < nloops; ixloop++ )
+            {
+              if ( b->state.bit_offset > nbits )
+                {
+                  sprintf ( b->error, "bufrdeco_skip_subset_data_recursive(): Data beyond the end of sec4\n" );
+                  return 1;
+                }
+              if ( bufrdeco_skip_subset_data_recursive ( a, l, i + 1, ndesc, nbits, b ) )
+                {
+                  return 1;
+                }
+            }
+          i += ndesc;
+          break;
+
+        case 2:
+          if ( l->lseq[i].x == 5 )
+            {
+              // YYY characters inserted as data
+              b->state.bit_offset += 8 * l->lseq[i].y;
+            }
+          else if ( l->lseq[i].x >= 1 && l->lseq[i].x <= 8 && l->lseq[i].x != 3 )
+            {
+              if ( bufrdeco_parse_f2_descriptor ( NULL, & ( l->lseq[i] ), b ) )
+                {
+                  return 1;
+                }
+            }
+          else
+            {
+              sprintf ( b->error, "bufrdeco_skip_subset_data_recursive(): Operator '%u%02u%03u' not supported\n",
+                        l->lseq[i].f, l->lseq[i].x, l->lseq[i].y );
+              return 1;
+            }
+          break;
+
+        case 3:
+          if ( bufrdeco_skip_subset_data_recursive ( a, l->sons[i], 0, l->sons[i]->ndesc, nbits, b ) )
+            {
+              return 1;
+            }
+          break;
+
+        default:
+          sprintf ( b->error, "bufrdeco_skip_subset_data_recursive(): Found bad 'f' in descriptor\n" );
+          return 1;
+          break;
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_build_subset_index ( struct bufrdeco *b )
+  \brief Set the bit offset where every subset begins in non compressed data
+  \param b pointer to the base struct \ref bufrdeco with the tree already parsed
+
+  The widths of data are walked from first subset to last one with \ref bufrdeco_skip_subset_data_recursive,
+  which is much faster than decoding the subsets. The results are set in b->sindex. The decoding state is
+  not changed.
+
+  Return 0 in case of success, 1 otherwise. In such case the subsets still can be decoded one after other
+*/
+int bufrdeco_build_subset_index ( struct bufrdeco *b )
+{
+  size_t ss, nbits;
+  struct bufr_atom_data a;
+  struct bufrdeco_decoding_data_state state;
+
+  if ( b->sindex.n )
+    {
+      return 0;
+    }
+
+  if ( b->tree == NULL || b->tree->nseq == 0 )
+    {
+      sprintf ( b->error, "bufrdeco_build_subset_index(): Try to index subsets without parsed tree\n" );
+      return 1;
+    }
+
+  if ( b->sec3.compressed )
+    {
+      sprintf ( b->error, "bufrdeco_build_subset_index(): Compressed data does not need an index of subsets\n" );
+      return 1;
+    }
+
+  if ( b->sindex.dim < ( b->sec3.subsets + 1 ) )
+    {
+      bufrdeco_arena_free ( & ( b->arena ), b->sindex.offset );
+      b->sindex.dim = 0;
+      if ( ( b->sindex.offset = ( size_t * ) bufrdeco_arena_alloc ( & ( b->arena ), ( b->sec3.subsets + 1 ) * sizeof ( size_t ) ) ) == NULL )
+        {
+          sprintf ( b->error, "bufrdeco_build_subset_index(): Cannot allocate memory for the index of subsets\n" );
+          return 1;
+        }
+      b->sindex.dim = b->sec3.subsets + 1;
+    }
+
+  nbits = ( b->sec4.length > 4 ) ? 8 * ( ( size_t ) b->sec4.length - 4 ) : 0;
+  state = b->state;
+  b->state.bit_offset = 0;
+  for ( ss = 0; ss < b->sec3.subsets; ss++ )
+    {
+      b->sindex.offset[ss] = b->state.bit_offset;
+      b->state.subset = ss;
+      bufrdeco_init_subset_state ( b );
+      // Strings of data decoded while skipping are not needed
+      bufrdeco_clean_string_arena ( & ( b->strings ) );
+      if ( bufrdeco_skip_subset_data_recursive ( &a, & ( b->tree->seq[0] ), 0, b->tree->seq[0].ndesc, nbits, b ) )
+        {
+          b->state = state;
+          return 1;
+        }
+      if ( b->state.bit_offset > nbits )
+        {
+          sprintf ( b->error, "bufrdeco_build_subset_index(): Data of subset %lu beyond the end of sec4\n", ( unsigned long ) ss );
+          b->state = state;
+          return 1;
+        }
+    }
+  b->sindex.offset[ss] = b->state.bit_offset;
+  b->sindex.n = ss + 1;
+  b->state = state;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_seek_subset ( struct bufrdeco *b, size_t ss )
+  \brief Set the subset to decode in the next call to \ref bufrdeco_get_subset_sequence_data
+  \param b pointer to the base struct \ref bufrdeco with the tree already parsed
+  \param ss index of subset. First is 0
+
+  In case of compressed data just the subset counter is set. Otherwise the offset of subset is got from
+  b->sindex, building it with \ref bufrdeco_build_subset_index if still not done. If the index cannot be built
+  the decoding state is not changed, so the caller can still decode the subsets one after other.
+
+  Return 0 in case of success, 1 otherwise
+*/
+int bufrdeco_seek_subset ( struct bufrdeco *b, size_t ss )
+{
+  if ( ss >= b->sec3.subsets )
+    {
+      sprintf ( b->error, "bufrdeco_seek_subset(): There is no subset %lu. The message has %u\n", ( unsigned long ) ss, b->sec3.subsets );
+      return 1;
+    }
+
+  if ( b->sec3.compressed == 0 )
+    {
+      if ( bufrdeco_build_subset_index ( b ) )
+        {
+          return 1;
+        }
+      b->state.bit_offset = b->sindex.offset[ss];
+    }
+  b->state.subset = ss;
+  return 0;
+}
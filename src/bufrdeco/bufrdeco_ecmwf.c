@@ -30,10 +30,12 @@ const char DEFAULT_BUFRTABLES_ECMWF_DIR1[] = "/usr/local/lib/bufrtables/";
 const char DEFAULT_BUFRTABLES_ECMWF_DIR2[] = "/usr/lib/bufrtables/";
 
 /*!
-  \fn int get_ecmwf_tablenames ( struct bufrdeco *b, const char *bufrtables_dir)
+  \fn int get_ecmwf_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd )
   \brief Get the complete pathnames for EMCWF table files needed by a bufr message
-  \param bufrtables_dir string with path to bufr file tables dir
   \param b pointer for a struct \ref bufrdeco
+  \param pathb string where to set the pathname of table B
+  \param pathc string where to set the pathname of table C
+  \param pathd string where to set the pathname of table D
 
   In ECMWF library the name of a table file is Kssswwwwwxxxxxyyyzzz.TXT , where
        - K - type of table, i.e, 'B', 'C', or 'D'
@@ -43,110 +45,87 @@ const char DEFAULT_BUFRTABLES_ECMWF_DIR2[] = "/usr/lib/bufrtables/";
        - yyy - Version number of master table used
        - zzz - Version number of local table used
 */
-int get_ecmwf_tablenames ( struct bufrdeco *b )
+int get_ecmwf_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd )
 {
   struct stat st;
   char aux[128];
 
-  if ( b->bufrtables_dir[0] == '\0' )
+  // The directory is guessed just once
+  if ( bufrdeco_resolve_tables_dir ( b, DEFAULT_BUFRTABLES_ECMWF_DIR1, DEFAULT_BUFRTABLES_ECMWF_DIR2 ) )
     {
-      // try to guess directory
-      if ( stat ( DEFAULT_BUFRTABLES_ECMWF_DIR1, &st ) )
-        {
-          if ( stat ( DEFAULT_BUFRTABLES_ECMWF_DIR2, &st ) )
-            {
-              return 1;
-            }
-          else
-            {
-              if ( S_ISDIR ( st.st_mode ) )
-                {
-                  strcpy ( aux,DEFAULT_BUFRTABLES_ECMWF_DIR2 );
-                }
-            }
-        }
-      else
-        {
-          if ( S_ISDIR ( st.st_mode ) )
-            {
-              strcpy ( aux,DEFAULT_BUFRTABLES_ECMWF_DIR1 );
-            }
-        }
-    }
-  else
-    {
-      strcpy ( aux, b->bufrtables_dir );
+      return 1;
     }
+  strcpy ( aux, b->bufrtables_dir );
 
-  sprintf ( b->tables->b.path,"%sB%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+  sprintf ( pathb,"%sB%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
-  sprintf ( b->tables->c.path,"%sC%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+  sprintf ( pathc,"%sC%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
-  sprintf ( b->tables->d.path,"%sD%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+  sprintf ( pathd,"%sD%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
 
   /* check for table b, if problems then we try alternative */
-  if ( stat ( b->tables->b.path, &st ) )
+  if ( stat ( pathb, &st ) )
     {
       // here we set originating centre xxxxx to 00000 for WMO tables
       if ( b->sec1.master != 0 ) // case of not WMO tables
         {
-          sprintf ( b->tables->b.path,"%sB%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+          sprintf ( pathb,"%sB%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
                     b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
-          sprintf ( b->tables->c.path,"%sC%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+          sprintf ( pathc,"%sC%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
                     b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
-          sprintf ( b->tables->d.path,"%sD%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
+          sprintf ( pathd,"%sD%03d%05d%05d%03d%03d.TXT", aux, b->sec1.master,
                     b->sec1.subcentre, b->sec1.centre, b->sec1.master_version, b->sec1.master_local );
         }
       else
         {
-          sprintf ( b->tables->b.path,"%sB000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
+          sprintf ( pathb,"%sB000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
                     b->sec1.master_version, b->sec1.master_local );
-          sprintf ( b->tables->c.path,"%sC000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
+          sprintf ( pathc,"%sC000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
                     b->sec1.master_version, b->sec1.master_local );
-          sprintf ( b->tables->d.path,"%sD000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
+          sprintf ( pathd,"%sD000%05d00000%03d%03d.TXT", aux, b->sec1.subcentre,
                     b->sec1.master_version, b->sec1.master_local );
         }
 
-      if ( stat ( b->tables->b.path, &st ) )
+      if ( stat ( pathb, &st ) )
         {
           // Another chance. Set local zzz to 000
           if ( b->sec1.master != 0 ) // case of not WMO tables
             {
-              sprintf ( b->tables->b.path,"%sB%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+              sprintf ( pathb,"%sB%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                         b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
-              sprintf ( b->tables->c.path,"%sC%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+              sprintf ( pathc,"%sC%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                         b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
-              sprintf ( b->tables->d.path,"%sD%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+              sprintf ( pathd,"%sD%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                         b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
             }
           else
             {
-              sprintf ( b->tables->b.path,"%sB000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
+              sprintf ( pathb,"%sB000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
                         b->sec1.master_version );
-              sprintf ( b->tables->c.path,"%sC000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
+              sprintf ( pathc,"%sC000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
                         b->sec1.master_version );
-              sprintf ( b->tables->d.path,"%sD000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
+              sprintf ( pathd,"%sD000%05d00000%03d000.TXT", aux, b->sec1.subcentre,
                         b->sec1.master_version );
             }
 
-          if ( stat ( b->tables->b.path, &st ) )
+          if ( stat ( pathb, &st ) )
             {
               // Another chance. Set subcentre wwwww to 00000
               if ( b->sec1.master != 0 ) // case of not WMO tables
                 {
-                  sprintf ( b->tables->b.path,"%sB%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+                  sprintf ( pathb,"%sB%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
-                  sprintf ( b->tables->c.path,"%sC%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+                  sprintf ( pathc,"%sC%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
-                  sprintf ( b->tables->d.path,"%sD%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
+                  sprintf ( pathd,"%sD%03d%05d%05d%03d000.TXT", aux, b->sec1.master,
                             b->sec1.subcentre, b->sec1.centre, b->sec1.master_version );
                 }
               else
                 {
-                  sprintf ( b->tables->b.path,"%sB0000000000000%03d000.TXT", aux, b->sec1.master_version );
-                  sprintf ( b->tables->c.path,"%sC0000000000000%03d000.TXT", aux, b->sec1.master_version );
-                  sprintf ( b->tables->d.path,"%sD0000000000000%03d000.TXT", aux, b->sec1.master_version );
+                  sprintf ( pathb,"%sB0000000000000%03d000.TXT", aux, b->sec1.master_version );
+                  sprintf ( pathc,"%sC0000000000000%03d000.TXT", aux, b->sec1.master_version );
+                  sprintf ( pathd,"%sD0000000000000%03d000.TXT", aux, b->sec1.master_version );
                 }
             }
         }
@@ -163,18 +142,26 @@ int get_ecmwf_tablenames ( struct bufrdeco *b )
 */
 int bufr_read_tables_ecmwf ( struct bufrdeco *b )
 {
+  size_t i;
+  char pathb[256], pathc[256], pathd[256];
+  struct bufr_tableb *tb;
 
   // get tablenames
-  if ( get_ecmwf_tablenames ( b ) )
+  if ( get_ecmwf_tablenames ( b, pathb, pathc, pathd ) )
     {
       sprintf ( b->error, "bufrdeco_read_tables_ecmwf(): Cannot find bufr tables\n" );
       return 1;
     }
 
-  // If tables still not initialized then do it
-  if ( b->tables == NULL && bufrdeco_init_tables ( & ( b->tables ) ) )
+  // If the same tables are already loaded, or are in cache, there is nothing to do
+  if ( bufrdeco_tables_loaded ( b->tables, pathb, pathc, pathd ) ||
+       bufrdeco_use_cached_tables ( b, pathb, pathc, pathd ) )
+    {
+      return 0;
+    }
+
+  if ( bufrdeco_prepare_tables ( b, pathb, pathc, pathd ) )
     {
-      sprintf ( b->error, "bufrdeco_read_tables_ecmwf(): Cannot allocate memory for tables\n" );
       return 1;
     }
 
@@ -191,5 +178,21 @@ int bufr_read_tables_ecmwf ( struct bufrdeco *b )
     {
       return 1;
     }
+
+  // Resolve now where to find table C lines for code tables, so the tables are
+  // not changed when decoding
+  tb = & ( b->tables->b );
+  for ( i = 0; i < tb->nlines; i++ )
+    {
+      if ( tb->item[i].kind == BUFR_VALUE_CODE_TABLE &&
+           bufr_find_tablec_index ( & ( tb->item[i].tablec_ref ), & ( b->tables->c ),
+                                   ( uint16_t ) ( ( tb->item[i].x << 8 ) | tb->item[i].y ) ) )
+        {
+          tb->item[i].tablec_ref = 0;
+        }
+    }
+
+  // Keep them for other messages and decoders
+  bufrdeco_tables_cache_add ( b->tables );
   return 0;
 }
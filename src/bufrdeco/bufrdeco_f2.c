@@ -37,6 +37,7 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
   size_t nbits;
   struct bufr_atom_data *a;
   uint8_t has_data;
+  char *cval;
 
   if ( d->f != 2 )
     {
@@ -81,7 +82,14 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
       // by coding this operator with YYY = 255. Negative
       // reference values shall be represented by a positive
       // integer with the left-most bit (bit 1) set to 1.
-      b->state.changing_reference = d->y;
+      // YYY = 000 cancels all the new reference values
+      if ( d->y == 0 )
+        {
+          bufrdeco_reset_tableb_overlay ( b );
+          b->state.changing_reference = 255;
+        }
+      else
+        b->state.changing_reference = d->y;
       break;
 
     case 4:
@@ -96,13 +104,26 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
       // YYY characters (CCITT International Alphabet No. 5) are
       // inserted as a data field of YYY x 8 bits in length.
       nbits = 8 * d->y;
+      if ( bufrdeco_projection_skip ( b, d ) )
+        {
+          // Not wanted. Just skip the chars
+          b->state.bit_offset += nbits;
+          break;
+        }
       a = & ( s->sequence[s->nd] );
       memcpy ( &a->desc, d, sizeof ( struct bufr_descriptor ) );
-      if ( get_bits_as_char_array ( a->cval, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), nbits ) == 0 )
+      if ( ( cval = bufrdeco_string_arena_alloc ( & ( b->strings ), nbits / 8 + 1 ) ) == NULL )
         {
-          sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Cannot get %u uchars from '%s'\n", d->y, d->c );
+          sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Cannot allocate a string for '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
+      if ( bit_reader_get_char_array ( cval, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), nbits ) == 0 )
+        {
+          sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Cannot get %u uchars from '%u%02u%03u'\n", d->y, d->f, d->x, d->y );
+          return 1;
+        }
+      a->cval = cval;
+      a->ctable = "";
       if ( has_data == 0 )
         {
           a->mask |= DESCRIPTOR_VALUE_MISSING;
@@ -111,8 +132,8 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
         {
           a->mask |= DESCRIPTOR_HAVE_STRING_VALUE;
         }
-      strcpy ( a->name, "SIGNIFY CHARACTER" );
-      strcpy ( a->unit, "CCITTIA5" ); // unit
+      a->name = "SIGNIFY CHARACTER";
+      a->unit = "CCITTIA5"; // unit
       if ( s->nd < ( s->dim - 1 ) )
         {
           ( s->nd ) ++;
@@ -150,8 +171,8 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
             b->state.factor_reference = pow10pos_int[d->y];
           else
             {
-              sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Too much %u increase bits for operator '%s'", d->y,
-                        d->c );
+              sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Too much %u increase bits for operator '%u%02u%03u'", d->y,
+                        d->f, d->x, d->y );
               return 1;
             }
           b->state.added_bit_length = ( int8_t ) ( ( 10.0 * d->y + 2.0 ) / 3.0 );
@@ -298,8 +319,8 @@ int bufrdeco_parse_f2_descriptor ( struct bufrdeco_subset_sequence_data *s, stru
       break;
 
     default:
-      sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Still no proccessed descriptor '%s' in "
-                "current library version\n", d->c );
+      sprintf ( b->error, "bufrdeco_parse_f2_descriptor(): Still no proccessed descriptor '%u%02u%03u' in "
+                "current library version\n", d->f, d->x, d->y );
       return 1;
     }
   return 0;
@@ -365,7 +386,14 @@ int bufrdeco_parse_f2_compressed ( struct bufrdeco_compressed_data_references *r
       // by coding this operator with YYY = 255. Negative
       // reference values shall be represented by a positive
       // integer with the left-most bit (bit 1) set to 1.
-      b->state.changing_reference = d->y;
+      // YYY = 000 cancels all the new reference values
+      if ( d->y == 0 )
+        {
+          bufrdeco_reset_tableb_overlay ( b );
+          b->state.changing_reference = 255;
+        }
+      else
+        b->state.changing_reference = d->y;
       break;
 
     case 4:
@@ -381,24 +409,25 @@ int bufrdeco_parse_f2_compressed ( struct bufrdeco_compressed_data_references *r
       // inserted as a data field of YYY x 8 bits in length.
       nbits = 8 * d->y;
       rf = & ( r->refs[r->nd] );
-      if ( get_bits_as_char_array ( rf->cref0, &rf->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), nbits ) == 0 )
+      if ( bit_reader_get_char_array ( rf->cref0, &rf->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), nbits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Cannot get %u uchars from '%s'\n", d->y, d->c );
+          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Cannot get %u uchars from '%u%02u%03u'\n", d->y, d->f, d->x, d->y );
           return 1;
         }
       strcpy ( rf->name, "SIGNIFY CHARACTER" );
       strcpy ( rf->unit, "CCITTIA5" ); // unit
+      rf->value_kind = BUFR_VALUE_CCITT;
 
       // Is suppossed all data will have same length in all subsets
       // extracting inc_bits from next 6 bits
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), 6 ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), 6 ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Cannot get 6 bits for inc_bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Cannot get 6 bits for inc_bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       if ( ival != d->y )
         {
-          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Bad length in inc_bits for a 2 05 YYY descriptor from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Bad length in inc_bits for a 2 05 YYY descriptor from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       rf->inc_bits = ival;
@@ -436,8 +465,8 @@ int bufrdeco_parse_f2_compressed ( struct bufrdeco_compressed_data_references *r
             b->state.factor_reference = pow10pos_int[d->y];
           else
             {
-              sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Too much %u increase bits for operator '%s'", d->y,
-                        d->c );
+              sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Too much %u increase bits for operator '%u%02u%03u'", d->y,
+                        d->f, d->x, d->y );
               return 1;
             }
           b->state.added_bit_length = ( int8_t ) ( ( 10.0 * d->y + 2.0 ) / 3.0 );
@@ -585,8 +614,8 @@ int bufrdeco_parse_f2_compressed ( struct bufrdeco_compressed_data_references *r
       break;
 
     default:
-      sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Still no proccessed descriptor '%s' in "
-                "current library version\n", d->c );
+      sprintf ( b->error, "bufrdeco_parse_f2_compressed(): Still no proccessed descriptor '%u%02u%03u' in "
+                "current library version\n", d->f, d->x, d->y );
       return 1;
     }
   return 0;
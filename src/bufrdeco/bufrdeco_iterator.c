@@ -0,0 +1,308 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_iterator.c
+ \brief This file has the code to walk over files or buffers with several BUFR messages
+
+ A file or buffer can have any amount of BUFR messages, concatenated one after other or
+ framed as GTS bulletins as in NOAA *.bin files
+
+ <pre>
+ ****NNNNNNN****
+ ISMD01 EGRR 121200
+ BUFR ..... 7777
+ </pre>
+
+ Every message is handed to decoder in place, without copying it.
+*/
+#include "bufrdeco.h"
+
+/*!
+  \fn int bufrdeco_iterator_init_buffer ( struct bufrdeco_message_iterator *it, uint8_t *buf, size_t len )
+  \brief Inits a struct \ref bufrdeco_message_iterator to walk over a memory buffer
+  \param it pointer to the struct \ref bufrdeco_message_iterator to init
+  \param buf pointer to the buffer with the messages. It must be kept by caller until the last message is decoded
+  \param len size of buffer in bytes
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrdeco_iterator_init_buffer ( struct bufrdeco_message_iterator *it, uint8_t *buf, size_t len )
+{
+  if ( it == NULL )
+    return 1;
+
+  memset ( it, 0, sizeof ( struct bufrdeco_message_iterator ) );
+  it->buf = buf;
+  it->len = len;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_iterator_open_file ( struct bufrdeco_message_iterator *it, char *filename )
+  \brief Inits a struct \ref bufrdeco_message_iterator to walk over a file, mapping it in memory
+  \param it pointer to the struct \ref bufrdeco_message_iterator to init
+  \param filename complete path of file
+
+  The file is released calling \ref bufrdeco_iterator_close
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrdeco_iterator_open_file ( struct bufrdeco_message_iterator *it, char *filename )
+{
+  int fd;
+  struct stat st;
+  void *m;
+
+  if ( bufrdeco_iterator_init_buffer ( it, NULL, 0 ) )
+    return 1;
+
+  if ( ( fd = open ( filename, O_RDONLY ) ) < 0 )
+    {
+      sprintf ( it->error, "bufrdeco_iterator_open_file(): cannot open file '%s'\n", filename );
+      return 1;
+    }
+
+  if ( fstat ( fd, &st ) < 0 || ! S_ISREG ( st.st_mode ) )
+    {
+      sprintf ( it->error, "bufrdeco_iterator_open_file(): '%s' is not a regular file\n", filename );
+      close ( fd );
+      return 1;
+    }
+
+  // A void file is not an error. Just there are no messages
+  if ( st.st_size == 0 )
+    {
+      close ( fd );
+      return 0;
+    }
+
+  m = mmap ( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close ( fd );
+  if ( m == MAP_FAILED )
+    {
+      sprintf ( it->error, "bufrdeco_iterator_open_file(): cannot map file '%s'\n", filename );
+      return 1;
+    }
+
+  // We will walk the file just once
+  madvise ( m, st.st_size, MADV_SEQUENTIAL );
+
+  it->map.addr = ( uint8_t * ) m;
+  it->map.len = st.st_size;
+  it->buf = it->map.addr;
+  it->len = it->map.len;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_iterator_close ( struct bufrdeco_message_iterator *it )
+  \brief Release the resources of a struct \ref bufrdeco_message_iterator
+  \param it pointer to the struct \ref bufrdeco_message_iterator
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrdeco_iterator_close ( struct bufrdeco_message_iterator *it )
+{
+  int res = 0;
+
+  if ( it->map.addr != NULL )
+    {
+      if ( munmap ( it->map.addr, it->map.len ) )
+        res = 1;
+      it->map.addr = NULL;
+      it->map.len = 0;
+    }
+  it->buf = NULL;
+  it->len = 0;
+  it->pos = 0;
+  return res;
+}
+
+/*!
+  \fn int bufrdeco_parse_gts_heading ( struct gts_header *h, char *heading, uint8_t *text, size_t len )
+  \brief Search the abbreviated GTS heading of a bulletin in the text preceding a BUFR message
+  \param h pointer to a struct \ref gts_header where to set the results
+  \param heading string where to copy the heading line as found
+  \param text pointer to the text preceding the BUFR message
+  \param len length of \a text
+
+  The heading is the latest line in \a text in the form 'TTAAii CCCC YYGGgg [BBB]'
+
+  Returns 1 if found, 0 otherwise
+*/
+int bufrdeco_parse_gts_heading ( struct gts_header *h, char *heading, uint8_t *text, size_t len )
+{
+  size_t i, j, k;
+  char line[BUFRDECO_GTS_HEADING_LEN], t[4][16];
+  int n;
+
+  i = len;
+  while ( i > 0 )
+    {
+      // skip line terminators and other control chars
+      while ( i > 0 && text[i - 1] < ' ' )
+        i--;
+      if ( i == 0 )
+        break;
+
+      // search the begin of line
+      j = i;
+      while ( j > 0 && text[j - 1] >= ' ' )
+        j--;
+
+      if ( ( i - j ) < ( BUFRDECO_GTS_HEADING_LEN - 1 ) )
+        {
+          k = i - j;
+          memcpy ( line, &text[j], k );
+          line[k] = '\0';
+          t[3][0] = '\0';
+          n = sscanf ( line, "%15s %15s %15s %15s", t[0], t[1], t[2], t[3] );
+          if ( n >= 3 && strlen ( t[0] ) == 6 && strlen ( t[1] ) == 4 &&
+               strlen ( t[2] ) == 6 && strspn ( t[2], "0123456789" ) == 6 && strlen ( t[3] ) < 8 )
+            {
+              strcpy ( heading, line );
+              strcpy ( h->bname, t[0] );
+              strcpy ( h->center, t[1] );
+              strcpy ( h->dtrel, t[2] );
+              strcpy ( h->order, t[3] );
+              return 1;
+            }
+        }
+      i = j;
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_iterator_find ( struct bufrdeco_message_iterator *it, int more )
+  \brief Search the next BUFR message in the buffer of a struct \ref bufrdeco_message_iterator, without reading it
+  \param it pointer to the struct \ref bufrdeco_message_iterator
+  \param more if != 0 more bytes can be appended to the buffer later, as when reading a stream
+
+  A message begins with 'BUFR', has the length given in sec0 (not greater than \a it->max_size if set) and ends with
+  '7777'. Any data between messages is skipped, but if there is a GTS heading before the message it is set in
+  it->heading and it->header. When found, the message is at it->offset with it->size bytes.
+
+  If a message is wrong the search goes on after its 'BUFR' mark in next call, so the input is resynced.
+
+  If \a more != 0 a message not complete in buffer is not wrong. Then it->pos is set where the search must be
+  done again when there are more bytes in buffer. The text before it is kept, as it may have the GTS heading.
+
+  Returns 0 if a message has been found, 1 if a wrong message has been found (reason in it->error) and -1 if
+  there are no more messages in buffer
+*/
+int bufrdeco_iterator_find ( struct bufrdeco_message_iterator *it, int more )
+{
+  uint8_t *c, *m;
+  size_t o, size, keep = it->len;
+
+  it->offset = 0;
+  it->size = 0;
+  it->heading[0] = '\0';
+  memset ( & ( it->header ), 0, sizeof ( struct gts_header ) );
+
+  while ( it->pos < it->len )
+    {
+      if ( ( c = memmem ( &it->buf[it->pos], it->len - it->pos, "BUFR", 4 ) ) == NULL )
+        break;
+
+      o = c - it->buf;
+      if ( o + 8 > it->len )
+        {
+          keep = o;
+          break;
+        }
+
+      size = three_bytes_to_uint32 ( &c[4] );
+      if ( c[7] >= 2 && size >= 12 && ( it->max_size == 0 || size <= it->max_size ) )
+        {
+          if ( ( o + size ) > it->len && more )
+            {
+              // Still not complete
+              keep = o;
+              break;
+            }
+
+          if ( ( o + size ) <= it->len && memcmp ( &c[size - 4], "7777", 4 ) == 0 )
+            {
+              // The GTS heading, if any, is between the latest message and this one
+              m = &it->buf[it->pos];
+              bufrdeco_parse_gts_heading ( & ( it->header ), it->heading, m, c - m );
+
+              it->offset = o;
+              it->size = size;
+              it->pos = o + size;
+              it->nmsg++;
+              return 0;
+            }
+        }
+
+      // A false mark or a broken message. Go on after the 'BUFR'
+      sprintf ( it->error, "bufrdeco_iterator_find(): Bad bufr message at offset %lu\n", ( unsigned long ) o );
+      it->offset = o;
+      it->pos = o + 4;
+      it->nerr++;
+      return 1;
+    }
+
+  if ( more )
+    {
+      // Keep the text which can have the GTS heading or the begin of a 'BUFR' mark
+      if ( keep > it->pos + BUFRDECO_GTS_HEADING_LEN + 3 )
+        it->pos = keep - BUFRDECO_GTS_HEADING_LEN - 3;
+    }
+  else
+    it->pos = it->len;
+  return -1;
+}
+
+/*!
+  \fn int bufrdeco_iterator_next ( struct bufrdeco_message_iterator *it, struct bufrdeco *b )
+  \brief Search the next BUFR message with \ref bufrdeco_iterator_find and read it in place with \ref bufrdeco_read_buffer_view
+  \param it pointer to the struct \ref bufrdeco_message_iterator
+  \param b pointer to struct \ref bufrdeco where to read the message
+
+  If there is a GTS heading before the message it is set in b->header and it->heading. Before calling again
+  this function the caller should have finished with the message and called to \ref bufrdeco_reset
+
+  Returns 0 if a message has been read, 1 if a message has been found but cannot be read (reason
+  in b->error) and -1 if there are no more messages
+*/
+int bufrdeco_iterator_next ( struct bufrdeco_message_iterator *it, struct bufrdeco *b )
+{
+  int res;
+
+  if ( ( res = bufrdeco_iterator_find ( it, 0 ) ) != 0 )
+    {
+      if ( res > 0 )
+        strcpy ( b->error, it->error );
+      return res;
+    }
+
+  if ( it->heading[0] )
+    b->header = it->header;
+
+  if ( bufrdeco_read_buffer_view ( b, &it->buf[it->offset], it->size ) )
+    {
+      it->nerr++;
+      return 1;
+    }
+  return 0;
+}
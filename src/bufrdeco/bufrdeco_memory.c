@@ -28,36 +28,124 @@
   \brief Init a struct \ref bufr_tables allocating space
   \param t pointer to the target pointer to struct \ref bufr_tables
 
+  If \a *t already points to some tables, they are released first with \ref bufrdeco_free_tables
+
   Returns 0 if succeeded, 1 otherwise
 */
 int bufrdeco_init_tables ( struct bufr_tables **t )
 {
-  if ( *t != NULL )
-    free ( ( void * ) *t );
+  bufrdeco_free_tables ( t );
 
   if ( ( *t = ( struct bufr_tables * ) calloc ( 1, sizeof ( struct bufr_tables ) ) ) == NULL )
     return 1;
+  ( *t )->refcount = 1;
   return 0;
 }
 
 
 /*!
   \fn int bufrdeco_free_tables ( struct bufr_tables **t )
-  \brief Frees the allocated space for a struct \ref bufr_tables
+  \brief Release a reference to a struct \ref bufr_tables
   \param t pointer to the target pointer to struct \ref bufr_tables
 
+  The allocated space is freed only when no other struct \ref bufrdeco is using the tables
+
   Returns 0 and \a *t is set to NULL
 */
 int bufrdeco_free_tables ( struct bufr_tables **t )
 {
   if ( *t != NULL )
     {
-      free ( ( void * ) *t );
+      if ( __sync_sub_and_fetch ( & ( ( *t )->refcount ), 1 ) <= 0 )
+        {
+          if ( ( *t )->image.addr != NULL )
+            munmap ( ( *t )->image.addr, ( *t )->image.len ); // a binary image of tables
+          else
+            free ( ( void * ) *t );
+        }
       *t = NULL;
     }
   return 0;
 }
 
+/*!
+  \fn int bufrdeco_share_tables ( struct bufrdeco *b, struct bufr_tables *source )
+  \brief Use in a struct \ref bufrdeco the tables already loaded by another one
+  \param b pointer to the target struct \ref bufrdeco
+  \param source pointer to the struct \ref bufr_tables to share, as b->tables of another decoder
+
+  The tables previously used by \a b are released. The shared tables are never changed while decoding, so
+  several decoders, in different threads, can use them at the same time. If a decoder needs other tables
+  it gets its own copy and the shared ones are kept unchanged. The memory is freed when the last decoder
+  using the tables calls \ref bufrdeco_close
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_share_tables ( struct bufrdeco *b, struct bufr_tables *source )
+{
+  if ( b == NULL || source == NULL )
+    return 1;
+
+  if ( b->tables == source )
+    return 0;
+
+  __sync_add_and_fetch ( & ( source->refcount ), 1 );
+  bufrdeco_free_tables ( & ( b->tables ) );
+  b->tables = source;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tables_loaded ( struct bufr_tables *t, const char *pathb, const char *pathc, const char *pathd )
+  \brief Check if a struct \ref bufr_tables has already loaded the given table files
+  \param t pointer to the struct \ref bufr_tables. Can be NULL
+  \param pathb pathname of table B file
+  \param pathc pathname of table C file
+  \param pathd pathname of table D file
+
+  Returns 1 if the three tables are loaded, 0 otherwise
+*/
+int bufrdeco_tables_loaded ( struct bufr_tables *t, const char *pathb, const char *pathc, const char *pathd )
+{
+  if ( t == NULL )
+    return 0;
+
+  if ( strcmp ( t->b.old_path, pathb ) || strcmp ( t->c.old_path, pathc ) || strcmp ( t->d.old_path, pathd ) )
+    return 0;
+
+  return 1;
+}
+
+/*!
+  \fn int bufrdeco_prepare_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+  \brief Prepare the struct \ref bufr_tables of a decoder to load other table files
+  \param b pointer to the target struct \ref bufrdeco
+  \param pathb pathname of table B file
+  \param pathc pathname of table C file
+  \param pathd pathname of table D file
+
+  If the current tables are shared with other decoders they are not changed. The decoder releases them
+  and allocates its own tables
+
+  Returns 0 if succeeded, 1 otherwise
+*/
+int bufrdeco_prepare_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+{
+  if ( b->tables != NULL && __atomic_load_n ( & ( b->tables->refcount ), __ATOMIC_ACQUIRE ) > 1 )
+    bufrdeco_free_tables ( & ( b->tables ) );
+
+  if ( b->tables == NULL && bufrdeco_init_tables ( & ( b->tables ) ) )
+    {
+      sprintf ( b->error, "bufrdeco_prepare_tables(): Cannot allocate memory for tables\n" );
+      return 1;
+    }
+
+  strcpy ( b->tables->b.path, pathb );
+  strcpy ( b->tables->c.path, pathc );
+  strcpy ( b->tables->d.path, pathd );
+  return 0;
+}
+
 /*!
   \fn int bufrdeco_init_expanded_tree ( struct bufrdeco_expanded_tree **t )
   \brief Init a struct \ref bufrdeco_expanded_tree allocating space
@@ -67,26 +155,29 @@ int bufrdeco_free_tables ( struct bufr_tables **t )
 */
 int bufrdeco_init_expanded_tree ( struct bufrdeco_expanded_tree **t )
 {
-  if ( *t != NULL )
-    free ( ( void * ) *t );
+  bufrdeco_free_expanded_tree ( t );
 
   if ( ( *t = ( struct bufrdeco_expanded_tree * ) calloc ( 1, sizeof ( struct bufrdeco_expanded_tree ) ) ) == NULL )
     return 1;
+  ( *t )->refcount = 1;
   return 0;
 }
 
 /*!
   \fn int bufrdeco_free_expanded_tree ( struct bufrdeco_expanded_tree **t )
-  \brief Frees the allocated space for a struct \ref bufrdeco_expanded_tree
+  \brief Release a reference to a struct \ref bufrdeco_expanded_tree
   \param t pointer to the target pointer to struct \ref bufrdeco_expanded_tree
 
+  The allocated space is freed only when neither the cache of trees nor any struct \ref bufrdeco is using it
+
   Returns 0 and \a *t is set to NULL
 */
 int bufrdeco_free_expanded_tree ( struct bufrdeco_expanded_tree **t )
 {
   if ( *t != NULL )
     {
-      free ( ( void * ) *t );
+      if ( __sync_sub_and_fetch ( & ( ( *t )->refcount ), 1 ) <= 0 )
+        free ( ( void * ) *t );
       *t = NULL;
     }
   return 0;
@@ -111,7 +202,8 @@ int bufrdeco_substitute_tables ( struct bufr_tables **replaced, struct bufr_tabl
   *replaced = b->tables;
   if ( source == NULL )
     {
-      // allocate memory for table
+      // allocate memory for table. The replaced one is kept for the caller
+      b->tables = NULL;
       return bufrdeco_init_tables ( & ( b->tables ) );
     }
   else
@@ -119,6 +211,369 @@ int bufrdeco_substitute_tables ( struct bufr_tables **replaced, struct bufr_tabl
   return 0;
 }
 
+/*!
+  \fn int bufrdeco_arena_reserve ( struct bufrdeco_arena *a, size_t size )
+  \brief Assure the block of a struct \ref bufrdeco_arena has at least \a size bytes
+  \param a pointer to the arena
+  \param size bytes needed
+
+  The block is only changed when nothing is allocated in the arena. The pages of the block are not touched
+  here, just when used.
+
+  Returns 0 if the block has the size, 1 otherwise
+*/
+int bufrdeco_arena_reserve ( struct bufrdeco_arena *a, size_t size )
+{
+  if ( a->size >= size )
+    return 0;
+
+  if ( a->used || a->chunks != NULL )
+    return 1;
+
+  free ( ( void * ) a->block );
+  a->size = 0;
+  if ( ( a->block = ( uint8_t * ) malloc ( size ) ) == NULL )
+    return 1;
+  a->size = size;
+  return 0;
+}
+
+/*!
+  \fn void * bufrdeco_arena_alloc ( struct bufrdeco_arena *a, size_t size )
+  \brief Get memory from a struct \ref bufrdeco_arena
+  \param a pointer to the arena. If NULL the memory is allocated in heap
+  \param size bytes needed
+
+  The memory is not initialized and lasts until the arena is cleaned with \ref bufrdeco_clean_arena
+
+  Returns a pointer to the memory, NULL if problems
+*/
+void * bufrdeco_arena_alloc ( struct bufrdeco_arena *a, size_t size )
+{
+  struct bufrdeco_arena_chunk *k;
+  size_t o;
+
+  if ( a == NULL )
+    return malloc ( size );
+
+  // The template is still unknown
+  if ( a->block == NULL )
+    bufrdeco_arena_reserve ( a, size > BUFRDECO_ARENA_INITIAL_SIZE ? size : BUFRDECO_ARENA_INITIAL_SIZE );
+
+  o = ( a->used + BUFRDECO_ARENA_ALIGN - 1 ) & ~ ( ( size_t ) BUFRDECO_ARENA_ALIGN - 1 );
+  if ( a->block != NULL && o <= a->size && size <= a->size - o )
+    {
+      a->last = o;
+      a->used = o + size;
+      return ( void * ) ( a->block + o );
+    }
+
+  // The block is full. Take a chunk and remember it to enlarge the block when cleaned
+  if ( ( k = ( struct bufrdeco_arena_chunk * ) malloc ( sizeof ( struct bufrdeco_arena_chunk ) + size ) ) == NULL )
+    return NULL;
+  k->next = a->chunks;
+  k->size = size;
+  a->chunks = k;
+  a->extra += size + BUFRDECO_ARENA_ALIGN;
+  return ( void * ) ( k + 1 );
+}
+
+/*!
+  \fn void * bufrdeco_arena_realloc ( struct bufrdeco_arena *a, void *p, size_t old, size_t size )
+  \brief Enlarge memory got from a struct \ref bufrdeco_arena
+  \param a pointer to the arena. If NULL the memory is reallocated in heap
+  \param p pointer to the memory to enlarge. If NULL it is as \ref bufrdeco_arena_alloc
+  \param old bytes of memory in \a p
+  \param size bytes needed
+
+  The latest allocation in block grows in place if there is room. Otherwise the content is copied to new memory.
+  Old memory is not released until the arena is cleaned
+
+  Returns a pointer to the memory, NULL if problems. In such case \a p is still valid
+*/
+void * bufrdeco_arena_realloc ( struct bufrdeco_arena *a, void *p, size_t old, size_t size )
+{
+  void *n;
+
+  if ( a == NULL )
+    return realloc ( p, size );
+
+  if ( p != NULL && a->block != NULL && ( uint8_t * ) p == ( a->block + a->last ) && size <= ( a->size - a->last ) )
+    {
+      a->used = a->last + size;
+      return p;
+    }
+
+  if ( ( n = bufrdeco_arena_alloc ( a, size ) ) != NULL && p != NULL )
+    memcpy ( n, p, old < size ? old : size );
+  return n;
+}
+
+/*!
+  \fn void bufrdeco_arena_free ( struct bufrdeco_arena *a, void *p )
+  \brief Release memory got with \ref bufrdeco_arena_alloc
+  \param a pointer to the arena. If NULL the memory is freed in heap
+  \param p pointer to the memory
+
+  Memory from an arena is only released when the arena is cleaned, so nothing is done in such case
+*/
+void bufrdeco_arena_free ( struct bufrdeco_arena *a, void *p )
+{
+  if ( a == NULL )
+    free ( p );
+}
+
+/*!
+  \fn int bufrdeco_clean_arena ( struct bufrdeco_arena *a )
+  \brief Release all the memory got from a struct \ref bufrdeco_arena at once
+  \param a pointer to the arena
+
+  If chunks were needed, the block is enlarged so all memory used fits in for next messages
+
+  Returns 0
+*/
+int bufrdeco_clean_arena ( struct bufrdeco_arena *a )
+{
+  struct bufrdeco_arena_chunk *k;
+  size_t used = a->used + a->extra;
+
+  while ( a->chunks != NULL )
+    {
+      k = a->chunks->next;
+      free ( ( void * ) a->chunks );
+      a->chunks = k;
+    }
+  a->used = 0;
+  a->last = 0;
+  a->extra = 0;
+  bufrdeco_arena_reserve ( a, used );
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_free_arena ( struct bufrdeco_arena *a )
+  \brief Free all the memory of a struct \ref bufrdeco_arena
+  \param a pointer to the arena
+
+  Returns 0
+*/
+int bufrdeco_free_arena ( struct bufrdeco_arena *a )
+{
+  bufrdeco_clean_arena ( a );
+  free ( ( void * ) a->block );
+  a->block = NULL;
+  a->size = 0;
+  return 0;
+}
+
+/*!
+  \fn static void bufrdeco_arena_hint_max ( size_t *h, size_t v )
+  \brief Set \a *h to \a v if greater. The tree with the hint may be shared with decoders in other threads
+*/
+static void bufrdeco_arena_hint_max ( size_t *h, size_t v )
+{
+  size_t old;
+
+  while ( ( old = *h ) < v && ! __sync_bool_compare_and_swap ( h, old, v ) )
+    ;
+}
+
+/*!
+  \fn static void bufrdeco_update_arena_hint ( struct bufrdeco *b )
+  \brief Note in the expanded tree the memory used by the current message of a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco
+*/
+static void bufrdeco_update_arena_hint ( struct bufrdeco *b )
+{
+  struct bufrdeco_arena_hint *h = & ( b->tree->hint );
+
+  bufrdeco_arena_hint_max ( & ( h->bytes ), b->arena.used + b->arena.extra );
+  bufrdeco_arena_hint_max ( & ( h->atoms ), b->seq.nd > b->seq.peak ? b->seq.nd : b->seq.peak );
+  bufrdeco_arena_hint_max ( & ( h->refs ), b->refs.nd );
+}
+
+/*!
+  \fn int bufrdeco_prepare_arena ( struct bufrdeco *b )
+  \brief Size the working memory of a struct \ref bufrdeco for a message as used by prior ones with the same tree
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+
+  So the arrays of data and refs are allocated just once and the whole message fits in the block of the arena
+
+  Returns 0 if the arena is ready, 1 otherwise. It is not an error, the memory is got as needed anyway
+*/
+int bufrdeco_prepare_arena ( struct bufrdeco *b )
+{
+  struct bufrdeco_arena_hint *h;
+
+  if ( b->tree == NULL )
+    return 1;
+
+  h = & ( b->tree->hint );
+  b->seq.hint = h->atoms ? h->atoms + 1 : 0;
+  b->refs.hint = h->refs ? h->refs + 1 : 0;
+  return bufrdeco_arena_reserve ( & ( b->arena ), h->bytes );
+}
+
+/*!
+  \fn static void bufrdeco_release_working_memory ( struct bufrdeco *b )
+  \brief Release at once all the memory used for the current message of a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco
+
+  All the arrays are in arena, so here they are just forgotten
+*/
+static void bufrdeco_release_working_memory ( struct bufrdeco *b )
+{
+  b->seq.sequence = NULL;
+  b->seq.dim = 0;
+  b->seq.nd = 0;
+  b->seq.peak = 0;
+  b->seq.hint = 0;
+
+  b->refs.refs = NULL;
+  b->refs.dim = 0;
+  b->refs.nd = 0;
+  b->refs.hint = 0;
+  b->refs.val = NULL;
+  b->refs.missing = NULL;
+  b->refs.cdim = 0;
+  b->refs.ival = NULL;
+  b->refs.idim = 0;
+  b->refs.str = NULL;
+  b->refs.sdim = 0;
+  b->refs.nsubsets = 0;
+
+  b->strings.first = NULL;
+  b->strings.current = NULL;
+
+  memset ( & ( b->bitmap ), 0, sizeof ( struct bufrdeco_bitmap_array ) );
+
+  b->sindex.offset = NULL;
+  b->sindex.dim = 0;
+  b->sindex.n = 0;
+
+  bufrdeco_clean_arena ( & ( b->arena ) );
+}
+
+/*!
+  \fn int bufrdeco_init_atom_strings ( struct bufr_atom_data *a, size_t n )
+  \brief Set void strings in an array of struct \ref bufr_atom_data, so they can be always read
+  \param a pointer to the first struct \ref bufr_atom_data
+  \param n number of elements
+
+  Returns 0
+*/
+int bufrdeco_init_atom_strings ( struct bufr_atom_data *a, size_t n )
+{
+  size_t i;
+
+  for ( i = 0; i < n; i++ )
+    {
+      a[i].name = "";
+      a[i].unit = "";
+      a[i].cval = "";
+      a[i].ctable = "";
+    }
+  return 0;
+}
+
+/*!
+  \fn char * bufrdeco_string_arena_alloc ( struct bufrdeco_string_arena *sa, size_t len )
+  \brief Get room for a string in a struct \ref bufrdeco_string_arena
+  \param sa pointer to the arena
+  \param len chars needed, including the final null char
+
+  Returns a pointer to the room for the string, NULL if problems
+*/
+char * bufrdeco_string_arena_alloc ( struct bufrdeco_string_arena *sa, size_t len )
+{
+  struct bufrdeco_string_block *k;
+  char *c;
+
+  if ( len > BUFRDECO_STRING_BLOCK_SIZE )
+    return NULL;
+
+  if ( sa->current == NULL )
+    {
+      if ( sa->first == NULL )
+        {
+          if ( ( sa->first = ( struct bufrdeco_string_block * ) bufrdeco_arena_alloc ( sa->arena, sizeof ( struct bufrdeco_string_block ) ) ) == NULL )
+            return NULL;
+          sa->first->next = NULL;
+        }
+      sa->current = sa->first;
+      sa->current->used = 0;
+    }
+
+  // Blocks already allocated are reused
+  while ( sa->current->used + len > BUFRDECO_STRING_BLOCK_SIZE )
+    {
+      if ( sa->current->next == NULL )
+        {
+          if ( ( k = ( struct bufrdeco_string_block * ) bufrdeco_arena_alloc ( sa->arena, sizeof ( struct bufrdeco_string_block ) ) ) == NULL )
+            return NULL;
+          k->next = NULL;
+          sa->current->next = k;
+        }
+      sa->current = sa->current->next;
+      sa->current->used = 0;
+    }
+
+  c = sa->current->s + sa->current->used;
+  sa->current->used += len;
+  return c;
+}
+
+/*!
+  \fn const char * bufrdeco_string_arena_copy ( struct bufrdeco_string_arena *sa, const char *src )
+  \brief Copy a string in a struct \ref bufrdeco_string_arena
+  \param sa pointer to the arena
+  \param src the string to copy
+
+  Returns a pointer to the copy, NULL if problems
+*/
+const char * bufrdeco_string_arena_copy ( struct bufrdeco_string_arena *sa, const char *src )
+{
+  size_t len = strlen ( src ) + 1;
+  char *c;
+
+  if ( ( c = bufrdeco_string_arena_alloc ( sa, len ) ) == NULL )
+    return NULL;
+  memcpy ( c, src, len );
+  return c;
+}
+
+/*!
+  \fn int bufrdeco_clean_string_arena ( struct bufrdeco_string_arena *sa )
+  \brief Mark all strings in a struct \ref bufrdeco_string_arena as free. Memory is kept to be reused
+
+  Returns 0
+*/
+int bufrdeco_clean_string_arena ( struct bufrdeco_string_arena *sa )
+{
+  sa->current = NULL;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_free_string_arena ( struct bufrdeco_string_arena *sa )
+  \brief Free all the memory of a struct \ref bufrdeco_string_arena
+
+  Returns 0
+*/
+int bufrdeco_free_string_arena ( struct bufrdeco_string_arena *sa )
+{
+  struct bufrdeco_string_block *k;
+
+  while ( sa->first != NULL )
+    {
+      k = sa->first->next;
+      bufrdeco_arena_free ( sa->arena, sa->first );
+      sa->first = k;
+    }
+  sa->current = NULL;
+  return 0;
+}
+
 /*!
    \fn int bufrdeco_init_subset_sequence_data ( struct bufrdeco_subset_sequence_data *ba )
    \brief Init a struct \ref bufrdeco_subset_sequence_data
@@ -127,17 +582,26 @@ int bufrdeco_substitute_tables ( struct bufr_tables **replaced, struct bufr_tabl
    It is supossed that no memory is allocated for sequence. If we are not sure better use
    function \ref bufrdeco_clean_subset_sequence_data
 
+   The array is allocated in \a ba->arena with \a ba->hint elements, if set.
+
    Returns 0 if succeeded, 1 otherwise
 */
 int bufrdeco_init_subset_sequence_data ( struct bufrdeco_subset_sequence_data *ba )
 {
-  memset ( ba, 0, sizeof ( struct bufrdeco_subset_sequence_data ) );
-  if ( ( ba->sequence = ( struct bufr_atom_data * ) calloc ( 1, BUFR_NMAXSEQ * sizeof ( struct bufr_atom_data ) ) ) == NULL )
+  size_t n = ba->hint ? ba->hint : BUFRDECO_SUBSET_DATA_INITIAL_DIM;
+
+  ba->dim = 0;
+  ba->nd = 0;
+  ba->ss = 0;
+  ba->peak = 0;
+  if ( ( ba->sequence = ( struct bufr_atom_data * ) bufrdeco_arena_alloc ( ba->arena, n * sizeof ( struct bufr_atom_data ) ) ) == NULL )
     {
       fprintf ( stderr,"bufr_init_subset_sequence_data():Cannot allocate memory for atom data array\n" );
       return 1;
     }
-  ba->dim = BUFR_NMAXSEQ;
+  memset ( ba->sequence, 0, n * sizeof ( struct bufr_atom_data ) );
+  ba->dim = n;
+  bufrdeco_init_atom_strings ( ba->sequence, ba->dim );
   return 0;
 }
 
@@ -154,6 +618,8 @@ int bufrdeco_clean_subset_sequence_data ( struct bufrdeco_subset_sequence_data *
 {
   if ( ba->sequence != NULL )
     {
+      if ( ba->nd > ba->peak )
+        ba->peak = ba->nd;
       ba->nd = 0;
       return 0;
     }
@@ -172,8 +638,9 @@ int bufrdeco_free_subset_sequence_data ( struct bufrdeco_subset_sequence_data *b
 {
   if ( ba->sequence != NULL )
     {
-      free ( ( void * ) ba->sequence );
+      bufrdeco_arena_free ( ba->arena, ba->sequence );
       ba->sequence = NULL;
+      ba->dim = 0;
     }
   return 0;
 }
@@ -184,25 +651,30 @@ int bufrdeco_free_subset_sequence_data ( struct bufrdeco_subset_sequence_data *b
   \param rf pointer ti the target struct
 
   If already memory is allocated for array of references then just adjust the used index to zero. Otherwise
-  it allocate the needed memory and init the struct
+  it allocate the needed memory in \a rf->arena, with \a rf->hint elements if set, and init the struct
 
   If succeeded return 0, otherwise 1
 */
 int bufrdeco_init_compressed_data_references ( struct bufrdeco_compressed_data_references *rf )
 {
+  size_t n = rf->hint ? rf->hint : BUFRDECO_COMPRESSED_REFS_INITIAL_DIM;
+
   if ( rf->refs != NULL && rf->dim != 0 )
     {
       rf->nd = 0;
     }
   else if ( rf->refs == NULL )
     {
-      if ( ( rf->refs = ( struct bufrdeco_compressed_ref * ) calloc ( 1, BUFR_NMAXSEQ * sizeof ( struct bufrdeco_compressed_ref ) ) ) == NULL )
+      if ( n > BUFR_NMAXSEQ )
+        n = BUFR_NMAXSEQ;
+      if ( ( rf->refs = ( struct bufrdeco_compressed_ref * ) bufrdeco_arena_alloc ( rf->arena, n * sizeof ( struct bufrdeco_compressed_ref ) ) ) == NULL )
         {
           fprintf ( stderr,"bufr_init_compressed_data_references():Cannot allocate memory for bufrdeco_compressed_ref array\n" );
           return 1;
         }
+      memset ( rf->refs, 0, n * sizeof ( struct bufrdeco_compressed_ref ) );
       rf->nd = 0;
-      rf->dim = BUFR_NMAXSEQ;
+      rf->dim = n;
     }
   return 0;
 }
@@ -231,9 +703,105 @@ int bufrdeco_free_compressed_data_references ( struct bufrdeco_compressed_data_r
 {
   if ( rf->refs != NULL )
     {
-      free ( ( void * ) rf->refs );
+      bufrdeco_arena_free ( rf->arena, rf->refs );
       rf->refs = NULL;
+      rf->dim = 0;
+      rf->nd = 0;
     }
+  bufrdeco_arena_free ( rf->arena, rf->val );
+  bufrdeco_arena_free ( rf->arena, rf->missing );
+  bufrdeco_arena_free ( rf->arena, rf->ival );
+  bufrdeco_arena_free ( rf->arena, rf->str );
+  rf->val = NULL;
+  rf->missing = NULL;
+  rf->ival = NULL;
+  rf->str = NULL;
+  rf->cdim = 0;
+  rf->idim = 0;
+  rf->sdim = 0;
+  rf->nsubsets = 0;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_init_compressed_columns ( struct bufrdeco_compressed_data_references *rf, size_t nsubsets )
+  \brief Prepare the columns where to unpack the values of all subsets of every ref in compressed data
+  \param rf pointer to the struct \ref bufrdeco_compressed_data_references, already parsed
+  \param nsubsets number of subsets
+
+  The kind of every ref is also set here. Strings of CCITT refs have their own room in \a rf->str.
+
+  The memory is got from \a rf->arena. If the columns need more memory than \ref BUFRDECO_COMPRESSED_COLUMNS_BUDGET
+  then they are not used and \a rf->nsubsets is set to 0.
+
+  Returns 0 if the columns can be used, 1 otherwise
+*/
+int bufrdeco_init_compressed_columns ( struct bufrdeco_compressed_data_references *rf, size_t nsubsets )
+{
+  size_t i, n, ns = 0;
+  struct bufrdeco_compressed_ref *r;
+
+  rf->nsubsets = 0;
+  for ( i = 0; i < rf->nd; i++ )
+    {
+      r = & ( rf->refs[i] );
+      r->unpacked = 0;
+      r->soffset = 0;
+      if ( is_a_local_descriptor ( & ( r->desc ) ) )
+        r->kind = BUFRDECO_COLUMN_LOCAL;
+      else if ( r->value_kind == BUFR_VALUE_CCITT )
+        {
+          r->kind = BUFRDECO_COLUMN_STRING;
+          r->soffset = ns;
+          ns += ( r->bits / 8 + 1 ) * nsubsets;
+        }
+      else if ( r->is_associated )
+        r->kind = BUFRDECO_COLUMN_ASSOCIATED;
+      else
+        r->kind = BUFRDECO_COLUMN_NUMERIC;
+    }
+
+  n = rf->nd * nsubsets;
+  if ( nsubsets == 0 || n > BUFRDECO_COMPRESSED_COLUMNS_BUDGET / ( sizeof ( double ) + sizeof ( uint8_t ) ) ||
+       ns > BUFRDECO_COMPRESSED_COLUMNS_BUDGET - n * ( sizeof ( double ) + sizeof ( uint8_t ) ) )
+    return 1;
+
+  if ( rf->cdim < n )
+    {
+      bufrdeco_arena_free ( rf->arena, rf->val );
+      bufrdeco_arena_free ( rf->arena, rf->missing );
+      rf->cdim = 0;
+      rf->val = ( double * ) bufrdeco_arena_alloc ( rf->arena, n * sizeof ( double ) );
+      rf->missing = ( uint8_t * ) bufrdeco_arena_alloc ( rf->arena, n * sizeof ( uint8_t ) );
+      if ( rf->val == NULL || rf->missing == NULL )
+        {
+          bufrdeco_arena_free ( rf->arena, rf->val );
+          bufrdeco_arena_free ( rf->arena, rf->missing );
+          rf->val = NULL;
+          rf->missing = NULL;
+          return 1;
+        }
+      rf->cdim = n;
+    }
+
+  if ( rf->idim < nsubsets )
+    {
+      bufrdeco_arena_free ( rf->arena, rf->ival );
+      rf->idim = 0;
+      if ( ( rf->ival = ( uint32_t * ) bufrdeco_arena_alloc ( rf->arena, nsubsets * sizeof ( uint32_t ) ) ) == NULL )
+        return 1;
+      rf->idim = nsubsets;
+    }
+
+  if ( rf->sdim < ns )
+    {
+      bufrdeco_arena_free ( rf->arena, rf->str );
+      rf->sdim = 0;
+      if ( ( rf->str = ( char * ) bufrdeco_arena_alloc ( rf->arena, ns ) ) == NULL )
+        return 1;
+      rf->sdim = ns;
+    }
+  rf->nsubsets = nsubsets;
   return 0;
 }
 
@@ -263,15 +831,64 @@ int bufrdeco_init ( struct bufrdeco *b )
       return 1;
     }
 
-  // allocate memory for expanded tree of descriptors
-  if ( bufrdeco_init_expanded_tree ( &b->tree ) )
+  // The expanded tree is got from cache or allocated when parsed. The working memory for a message
+  // is got from arena, sized when the template is known
+  b->seq.arena = & ( b->arena );
+  b->refs.arena = & ( b->arena );
+  b->strings.arena = & ( b->arena );
+
+  return 0;
+}
+
+/*!
+  \fn static void bufrdeco_clean_sections ( struct bufrdeco *b )
+  \brief Clean the sections of the latest message read in a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco
+
+  The raw arrays are only written when the message is copied, and just up to the length of their section. So
+  only such a part is set to zero, not the whole arrays. It is the same for the unexpanded descriptors in sec3.
+*/
+static void bufrdeco_clean_sections ( struct bufrdeco *b )
+{
+  size_t n;
+
+  memset ( & ( b->sec0 ), 0, sizeof ( struct bufr_sec0 ) );
+
+  if ( b->sec1.raw_ptr == b->sec1.raw )
     {
-      sprintf ( b->error,"bufrdeco_init(): Cannot allocate space for expanded tree of descriptors\n" );
-      return 1;
+      n = ( b->sec1.length < BUFR_LEN_SEC1 ) ? b->sec1.length : BUFR_LEN_SEC1;
+      memset ( b->sec1.raw, 0, n );
     }
+  memset ( & ( b->sec1 ), 0, offsetof ( struct bufr_sec1, raw ) );
+  b->sec1.raw_ptr = NULL;
 
+  if ( b->sec2.raw_ptr == b->sec2.raw )
+    {
+      n = ( b->sec2.length < BUFR_LEN_SEC2 ) ? b->sec2.length : BUFR_LEN_SEC2;
+      memset ( b->sec2.raw, 0, n );
+    }
+  b->sec2.length = 0;
+  b->sec2.raw_ptr = NULL;
 
-  return 0;
+  if ( b->sec3.raw_ptr == b->sec3.raw )
+    {
+      n = ( b->sec3.length < BUFR_LEN_SEC3 ) ? b->sec3.length : BUFR_LEN_SEC3;
+      memset ( b->sec3.raw, 0, n );
+    }
+  n = ( b->sec3.ndesc < BUFR_LEN_UNEXPANDED_DESCRIPTOR ) ? b->sec3.ndesc : BUFR_LEN_UNEXPANDED_DESCRIPTOR;
+  memset ( b->sec3.unexpanded, 0, n * sizeof ( struct bufr_descriptor ) );
+  memset ( & ( b->sec3 ), 0, offsetof ( struct bufr_sec3, unexpanded ) );
+  b->sec3.raw_ptr = NULL;
+
+  // The 4 bytes of '7777' are also copied
+  if ( b->sec4.raw_ptr == b->sec4.raw )
+    {
+      n = ( ( size_t ) b->sec4.length + 4 < BUFR_LEN ) ? ( size_t ) b->sec4.length + 4 : BUFR_LEN;
+      memset ( b->sec4.raw, 0, n );
+    }
+  memset ( & ( b->sec4 ), 0, offsetof ( struct bufr_sec4, raw ) );
+  b->sec4.raw_ptr = NULL;
+  memset ( & ( b->sec4.bits ), 0, sizeof ( struct bufrdeco_bit_reader ) );
 }
 
 /*!
@@ -281,19 +898,29 @@ int bufrdeco_init ( struct bufrdeco *b )
 
    This function must be called when parsing another bufrfile without callimg
    \ref bufrdeco_close and \ref bufrdeco_init.
+
+   Only the memory used by the latest message is cleaned, so the cost does not depend on the size of arrays.
 */
 int bufrdeco_reset ( struct bufrdeco *b )
 {
+  bufrdeco_unmap_input ( b );
   memset ( & ( b->header ), 0, sizeof ( struct gts_header ) );
-  memset ( & ( b->sec0 ), 0, sizeof ( struct bufr_sec0 ) );
-  memset ( & ( b->sec1 ), 0, sizeof ( struct bufr_sec1 ) );
-  memset ( & ( b->sec2 ), 0, sizeof ( struct bufr_sec2 ) );
-  memset ( & ( b->sec3 ), 0, sizeof ( struct bufr_sec3 ) );
-  memset ( & ( b->sec4 ), 0, sizeof ( struct bufr_sec4 ) );
-  memset ( b->tree, 0, sizeof ( struct bufrdeco_expanded_tree ) );
+  bufrdeco_clean_sections ( b );
+  // A tree shared with the cache is never changed, just released. A private one is reused
+  if ( b->tree != NULL && __atomic_load_n ( & ( b->tree->refcount ), __ATOMIC_ACQUIRE ) > 1 )
+    {
+      // Next messages with this tree will get the memory at once
+      bufrdeco_update_arena_hint ( b );
+      bufrdeco_free_expanded_tree ( & ( b->tree ) );
+    }
+  else if ( b->tree != NULL )
+    {
+      b->tree->nseq = 0;
+      memset ( & ( b->tree->hint ), 0, sizeof ( struct bufrdeco_arena_hint ) );
+    }
   memset ( & ( b->state ), 0, sizeof ( struct bufrdeco_decoding_data_state ) );
-  b->refs.nd = 0;
-  b->seq.nd = 0;
+  bufrdeco_reset_tableb_overlay ( b );
+  bufrdeco_release_working_memory ( b );
   return 0;
 }
 
@@ -307,11 +934,17 @@ int bufrdeco_reset ( struct bufrdeco *b )
 int bufrdeco_close ( struct bufrdeco *b )
 {
   // first deallocate all memory
+  bufrdeco_unmap_input ( b );
   bufrdeco_free_subset_sequence_data ( & ( b->seq ) );
+  bufrdeco_free_string_arena ( & ( b->strings ) );
   bufrdeco_free_compressed_data_references ( & ( b->refs ) );
   bufrdeco_free_expanded_tree ( & ( b->tree ) );
   bufrdeco_free_tables ( & ( b->tables ) );
   bufrdeco_free_bitmap_array ( & ( b->bitmap ) );
+  b->sindex.offset = NULL;
+  b->sindex.dim = 0;
+  b->sindex.n = 0;
+  bufrdeco_free_arena ( & ( b->arena ) );
   return 0;
 }
 
@@ -321,16 +954,16 @@ int bufrdeco_allocate_bitmap ( struct bufrdeco *b )
 
   if ( nba < BUFR_MAX_BITMAPS )
     {
-      if ( b->bitmap.bmap[nba] != NULL )
-        {
-          // the bitmap already is allocated
-          return 0;
-        }
-      // let's try to allocate it!
-      if ( ( b->bitmap.bmap[nba] = ( struct bufrdeco_bitmap * ) calloc ( 1, sizeof ( struct bufrdeco_bitmap ) ) ) == NULL )
+      // If the bitmap is already allocated, it has been cleaned in bufrdeco_clean_bitmaps()
+      if ( b->bitmap.bmap[nba] == NULL )
         {
-          sprintf ( b->error,"bufrdeco_allocate_bitmap(): Cannot allocate space for struct bufrdeco_bitmap\n" );
-          return 1;
+          // let's try to allocate it!
+          if ( ( b->bitmap.bmap[nba] = ( struct bufrdeco_bitmap * ) bufrdeco_arena_alloc ( & ( b->arena ), sizeof ( struct bufrdeco_bitmap ) ) ) == NULL )
+            {
+              sprintf ( b->error,"bufrdeco_allocate_bitmap(): Cannot allocate space for struct bufrdeco_bitmap\n" );
+              return 1;
+            }
+          memset ( b->bitmap.bmap[nba], 0, sizeof ( struct bufrdeco_bitmap ) );
         }
       // Update de counter
       ( b->bitmap.nba )++;
@@ -345,6 +978,30 @@ int bufrdeco_allocate_bitmap ( struct bufrdeco *b )
 
 
 
+/*!
+  \fn static void bufrdeco_clean_bitmap ( struct bufrdeco_bitmap *bm )
+  \brief Set a struct \ref bufrdeco_bitmap to zero as when allocated
+  \param bm pointer to the bitmap
+
+  The big arrays are only written by \ref bufrdeco_add_to_bitmap up to \a bm->nb, so just the part used is cleaned
+*/
+static void bufrdeco_clean_bitmap ( struct bufrdeco_bitmap *bm )
+{
+  memset ( bm->bitmap_to, 0, bm->nb * sizeof ( uint32_t ) );
+  memset ( bm->bitmaped_by, 0, bm->nb * sizeof ( uint32_t ) );
+  bm->nb = 0;
+  bm->nq = 0;
+  memset ( bm->quality, 0, sizeof ( bm->quality ) );
+  bm->subs = 0;
+  bm->retain = 0;
+  bm->ns1 = 0;
+  memset ( bm->stat1, 0, sizeof ( bm->stat1 ) );
+  memset ( bm->stat1_desc, 0, sizeof ( bm->stat1_desc ) );
+  bm->nds = 0;
+  memset ( bm->dstat, 0, sizeof ( bm->dstat ) );
+  memset ( bm->dstat_desc, 0, sizeof ( bm->dstat_desc ) );
+}
+
 // Clean all allocated bitmaps, but still is in memory
 int bufrdeco_clean_bitmaps ( struct bufrdeco *b )
 {
@@ -354,26 +1011,17 @@ int bufrdeco_clean_bitmaps ( struct bufrdeco *b )
     {
       if ( b->bitmap.bmap[i] == NULL )
         continue;
-      memset ( b->bitmap.bmap[i] , 0 , sizeof ( struct bufrdeco_bitmap ) );
+      bufrdeco_clean_bitmap ( b->bitmap.bmap[i] );
     }
   b->bitmap.nba = 0;  
   return 0;
 }
 
 
+// Bitmaps are in the arena of struct bufrdeco, so they are just forgotten
 int bufrdeco_free_bitmap_array ( struct bufrdeco_bitmap_array *a )
 {
-  size_t i;
-
-  for ( i = 0; i < a->nba ; i++ )
-    {
-      if ( a->bmap[i] == NULL )
-        continue;
-
-      free ( ( void* ) a->bmap[i] );
-      a->bmap[i] = NULL;
-    }
-  a->nba = 0;
+  memset ( a, 0, sizeof ( struct bufrdeco_bitmap_array ) );
   return 0;
 }
 
@@ -246,7 +246,7 @@ int bufrdeco_fprint_tree_recursive ( FILE *f, struct bufrdeco *b, struct bufr_se
         {
           if ( l->lseq[i].f == 0 )
             {
-              if ( bufr_find_tableb_index ( &k, & ( b->tables->b ), l->lseq[i].c ) )
+              if ( bufr_find_tableb_index ( &k, & ( b->tables->b ), bufr_descriptor_to_key ( & l->lseq[i] ) ) )
                 fprintf ( f , "\n" );
               else if ( is_a_delayed_descriptor ( & l->lseq[i] ) ||
                         is_a_short_delayed_descriptor ( & l->lseq[i] ) )
@@ -470,7 +470,7 @@ void bufrdeco_print_subset_sequence_data ( struct bufrdeco_subset_sequence_data
 */
 void fprint_bufrdeco_compressed_ref ( FILE *f, struct bufrdeco_compressed_ref *r )
 {
-  fprintf ( f, "%s -> A=%u, D=%u, ",r->desc.c,r->is_associated,r->has_data );
+  fprintf ( f, "%u%02u%03u -> A=%u, D=%u, ",r->desc.f,r->desc.x,r->desc.y,r->is_associated,r->has_data );
   if ( r->cref0[0] == '\0' )
     {
       fprintf ( f, "bits=%2u, ref=%10d, escale=%3d,",  r->bits, r->ref, r->escale );
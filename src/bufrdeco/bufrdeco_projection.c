@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_projection.c
+ \brief This file has the code to decode just a set of descriptors
+
+ Most of users need a few elements of every subset. When a projection is set, the data of any other element
+ is skipped just by its width, so no name, unit, value nor code table explanation is set for it.
+*/
+#include "bufrdeco.h"
+
+/*!
+  \fn int bufrdeco_clear_projection ( struct bufrdeco *b )
+  \brief Remove the projection of a struct \ref bufrdeco, so all data is decoded again
+  \param b pointer to the struct \ref bufrdeco
+
+  Returns 0
+*/
+int bufrdeco_clear_projection ( struct bufrdeco *b )
+{
+  memset ( & ( b->projection ), 0, sizeof ( struct bufrdeco_projection ) );
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_set_projection ( struct bufrdeco *b, const char *list )
+  \brief Set the descriptors to decode in a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco
+  \param list string with the descriptors as FXXYYY, separated by '/', ',' or blanks. As example '001001/001002/012101'.
+         If NULL or void then the projection is cleared
+
+  The projection is kept after \ref bufrdeco_reset, so it is used for all next messages. Only descriptors with
+  f == 0 can be set. Replicators, operators and sequences are always processed, but the characters inserted
+  by operator 2 05 YYY are skipped. In messages using bitmaps (operators
+  2 22 000 to 2 37 255) all data is decoded, because the bitmaps refer to every element in subset.
+
+  Returns 0 if all is OK, 1 otherwise. In such case the projection is cleared
+*/
+int bufrdeco_set_projection ( struct bufrdeco *b, const char *list )
+{
+  char aux[8];
+  const char *c;
+  size_t n;
+  uint32_t id;
+  uint16_t key;
+  struct bufr_descriptor d;
+
+  bufrdeco_clear_projection ( b );
+  if ( list == NULL )
+    return 0;
+
+  c = list;
+  while ( *c )
+    {
+      // Skip separators
+      if ( strchr ( "/, \t\n", *c ) != NULL )
+        {
+          c++;
+          continue;
+        }
+
+      n = strspn ( c, "0123456789" );
+      if ( n != 6 || ( c[n] && strchr ( "/, \t\n", c[n] ) == NULL ) )
+        {
+          sprintf ( b->error, "bufrdeco_set_projection(): Bad descriptor in '%s'\n", list );
+          bufrdeco_clear_projection ( b );
+          return 1;
+        }
+      memcpy ( aux, c, 6 );
+      aux[6] = '\0';
+      c += 6;
+
+      id = strtoul ( aux, NULL, 10 );
+      if ( aux[0] != '0' || ( id % 100000 ) / 1000 > 63 || id % 1000 > 255 )
+        {
+          sprintf ( b->error, "bufrdeco_set_projection(): '%s' is not a table B descriptor\n", aux );
+          bufrdeco_clear_projection ( b );
+          return 1;
+        }
+      uint32_t_to_descriptor ( &d, id );
+      key = bufr_descriptor_to_key ( &d );
+      if ( ( b->projection.set[key >> 6] & ( ( uint64_t ) 1 << ( key & 63 ) ) ) == 0 )
+        {
+          b->projection.set[key >> 6] |= ( ( uint64_t ) 1 << ( key & 63 ) );
+          b->projection.n++;
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_projection_skip ( struct bufrdeco *b, const struct bufr_descriptor *d )
+  \brief Check if the data of a descriptor must be skipped because of the projection set in a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco with the tree already parsed
+  \param d pointer to the descriptor
+
+  Returns 1 if the data must be skipped, 0 if it must be decoded
+*/
+int bufrdeco_projection_skip ( struct bufrdeco *b, const struct bufr_descriptor *d )
+{
+  uint16_t key;
+
+  if ( b->projection.n == 0 || b->tree->bitmap_operators )
+    return 0;
+
+  // Characters inserted by operator 2 05 YYY are never wanted. Other operators, replicators and sequences are
+  // always processed
+  if ( d->f == 2 && d->x == 5 )
+    return 1;
+  else if ( d->f != 0 )
+    return 0;
+
+  key = bufr_descriptor_to_key ( d );
+  return ( b->projection.set[key >> 6] & ( ( uint64_t ) 1 << ( key & 63 ) ) ) == 0;
+}
@@ -37,15 +37,22 @@
   - Splits and parse the BUFR sections (without expanding descriptors nor parsing data)
   - Reads the needed Table files and store them in memory.
 
+  If \ref BUFRDECO_USE_MMAP is set in b->mask the file is mapped in memory and the sections are
+  not copied but read in place. The mapping is kept until next call, \ref bufrdeco_reset or \ref bufrdeco_close
+
   Returns 0 if all is OK, 1 otherwise
  */
 int bufrdeco_read_bufr ( struct bufrdeco *b,  char *filename )
 {
-  int aux, res;
+  int fd, res;
   uint8_t *bufrx = NULL; /*!< pointer to a memory buffer where we write raw bufr file */
   size_t n = 0;
   FILE *fp;
   struct stat st;
+  void *m;
+
+  // Release a previous mapped file, if any
+  bufrdeco_unmap_input ( b );
 
   /* Stat input file */
   if ( stat ( filename, &st ) < 0 )
@@ -54,26 +61,53 @@ int bufrdeco_read_bufr ( struct bufrdeco *b,  char *filename )
       return 1;
     }
 
-  /* Alloc nedeed memory for bufr */
-  if ( S_ISREG ( st.st_mode ) || S_ISLNK ( st.st_mode ) )
+  if ( ! S_ISREG ( st.st_mode ) && ! S_ISLNK ( st.st_mode ) )
+    {
+      sprintf ( b->error, "bufrdeco_read_bufr(): '%s' is not a regular file nor symbolic link\n", filename );
+      return 1;
+    }
+
+  if ( b->mask & BUFRDECO_USE_MMAP )
     {
-      if ( ( bufrx = ( uint8_t * ) calloc ( 1, st.st_size + 4 ) ) == NULL )
+      if ( st.st_size < 8 )
         {
-          sprintf ( b->error, "bufrdeco_read_bufr(): cannot alloc memory for file '%s'\n", filename );
+          sprintf ( b->error, "bufrdeco_read_bufr(): Too few bytes in file '%s'\n", filename );
           return 1;
         }
-    }
-  else
-    {
-      sprintf ( b->error, "bufrdeco_read_bufr(): '%s' is not a regular file nor symbolic link\n", filename );
-      return 1;
+
+      if ( ( fd = open ( filename, O_RDONLY ) ) < 0 )
+        {
+          sprintf ( b->error, "bufrdeco_read_bufr(): cannot open file '%s'\n", filename );
+          return 1;
+        }
+
+      m = mmap ( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      // the mapping is still valid after closing the descriptor
+      close ( fd );
+      if ( m == MAP_FAILED )
+        {
+          sprintf ( b->error, "bufrdeco_read_bufr(): cannot map file '%s'\n", filename );
+          return 1;
+        }
+      b->map.addr = ( uint8_t * ) m;
+      b->map.len = st.st_size;
+
+      if ( ( res = bufrdeco_read_buffer_view ( b, b->map.addr, b->map.len ) ) )
+        bufrdeco_unmap_input ( b );
+      return res;
     }
 
   /* Inits bufr struct */
   if ( ( st.st_size + 4 ) >= BUFR_LEN )
     {
       sprintf ( b->error, "File '%s' too large. Consider increase BUFR_LEN\n", filename );
-      free ( ( void * ) bufrx );
+      return 1;
+    }
+
+  /* Alloc nedeed memory for bufr */
+  if ( ( bufrx = ( uint8_t * ) calloc ( 1, st.st_size + 4 ) ) == NULL )
+    {
+      sprintf ( b->error, "bufrdeco_read_bufr(): cannot alloc memory for file '%s'\n", filename );
       return 1;
     }
 
@@ -85,8 +119,7 @@ int bufrdeco_read_bufr ( struct bufrdeco *b,  char *filename )
       return 1;
     }
 
-  while ( ( aux = fgetc ( fp ) ) != EOF && ( int ) n < st.st_size )
-    bufrx[n++] = ( uint8_t ) aux;
+  n = fread ( bufrx, 1, st.st_size, fp );
 
   // close the file
   fclose ( fp );
@@ -97,29 +130,40 @@ int bufrdeco_read_bufr ( struct bufrdeco *b,  char *filename )
 }
 
 /*!
-  \fn int bufrdeco_read_buffer ( struct bufrdeco *b, uint8_t *bufrx, size_t size  )
-  \brief Read a memory buffer and does preliminary and first decode pass
+  \fn int bufrdeco_unmap_input ( struct bufrdeco *b )
+  \brief Release the memory mapped file, if any, used in a previous call to \ref bufrdeco_read_bufr
   \param b pointer to struct \ref bufrdeco
-  \param bufrx buffer already allocated by caller
-  \param size size of BUFR in buffer
-
-  This function does the folowing tasks:
-  - Splits and parse the BUFR sections (without expanding descriptors nor parsing data)
-  - Reads the needed Table files and store them in memory.
 
   Returns 0 if all is OK, 1 otherwise
  */
-int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
+int bufrdeco_unmap_input ( struct bufrdeco *b )
 {
-  uint8_t *c;
-  size_t ix, ud;
+  int res = 0;
 
-  // Some fast checks
-  if ( ( size + 4 ) >= BUFR_LEN )
+  if ( b->map.addr != NULL )
     {
-      sprintf ( b->error, "bufrdeco_init_buffer(): Buffer provided too large. Consider increase BUFR_LEN\n" );
-      return 1;
+      if ( munmap ( b->map.addr, b->map.len ) )
+        res = 1;
+      b->map.addr = NULL;
+      b->map.len = 0;
     }
+  return res;
+}
+
+/*!
+  \fn int bufrdeco_split_sections ( struct bufrdeco *b, uint8_t *bufrx, size_t size, int copy )
+  \brief Splits and parse the sections of a BUFR in a buffer
+  \param b pointer to struct \ref bufrdeco
+  \param bufrx buffer with a single bufr message
+  \param size size of BUFR in buffer
+  \param copy if != 0 raw sections are copied into \a b. Otherwise the raw pointers of sections point into \a bufrx
+
+  Returns 0 if all is OK, 1 otherwise
+ */
+static int bufrdeco_split_sections ( struct bufrdeco *b,  uint8_t *bufrx, size_t size, int copy )
+{
+  uint8_t *c, *end;
+  size_t ix, ud;
 
   if ( size < 8 )
     {
@@ -167,8 +211,17 @@ int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
   // raw
   memcpy ( &b->sec0.raw[0], &bufrx[0], 8 );
 
+  // Bytes after the latest section. The final '7777' is not included
+  end = bufrx + size - 4;
+
   /******************* section 1 *****************************/
   c = &bufrx[8]; // pointer to begin of sec1
+  if ( ( c + 22 ) > end )
+    {
+      sprintf ( b->error, "bufrdeco_read_buffer(): Too few bytes for sec1\n" );
+      return 1;
+    }
+
   switch ( b->sec0.edition )
     {
     case 3:
@@ -214,23 +267,47 @@ int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
       break;
     default:
       sprintf ( b->error, "bufrdeco_read_buffer(): This file is coded with version %u and is not supported\n", b->sec0.edition );
-      free ( ( void * ) bufrx );
       return 1;
     }
-  memcpy ( b->sec1.raw, c, b->sec1.length ); // raw data
+  if ( ( c + b->sec1.length ) > end )
+    {
+      sprintf ( b->error, "bufrdeco_read_buffer(): Bad length of sec1\n" );
+      return 1;
+    }
+  if ( copy )
+    {
+      memcpy ( b->sec1.raw, c, ( b->sec1.length < BUFR_LEN_SEC1 ) ? b->sec1.length : BUFR_LEN_SEC1 ); // raw data
+      b->sec1.raw_ptr = b->sec1.raw;
+    }
+  else
+    b->sec1.raw_ptr = c;
   c += b->sec1.length;
   //print_sec1_info(b);
 
   /******************* section 2 (Optional) ******************/
   if ( b->sec1.options & 0x80 )
     {
-      b->sec2.length = three_bytes_to_uint32 ( c );
-      memcpy ( b->sec2.raw, c, b->sec2.length );
+      if ( ( c + 3 ) > end || ( c + ( b->sec2.length = three_bytes_to_uint32 ( c ) ) ) > end )
+        {
+          sprintf ( b->error, "bufrdeco_read_buffer(): Bad length of sec2\n" );
+          return 1;
+        }
+      if ( copy )
+        {
+          memcpy ( b->sec2.raw, c, ( b->sec2.length < BUFR_LEN_SEC2 ) ? b->sec2.length : BUFR_LEN_SEC2 );
+          b->sec2.raw_ptr = b->sec2.raw;
+        }
+      else
+        b->sec2.raw_ptr = c;
       c += b->sec2.length;
     }
 
   /******************* section 3 *****************************/
-  b->sec3.length = three_bytes_to_uint32 ( c );
+  if ( ( c + 7 ) > end || ( c + ( b->sec3.length = three_bytes_to_uint32 ( c ) ) ) > end )
+    {
+      sprintf ( b->error, "bufrdeco_read_buffer(): Bad length of sec3\n" );
+      return 1;
+    }
   b->sec3.subsets = two_bytes_to_uint32 ( &c[4] );
   if ( c[6] & 0x80 )
     b->sec3.observed = 1;
@@ -249,16 +326,37 @@ int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
         ud++;
     }
   b->sec3.ndesc = ud;
-  memcpy ( b->sec3.raw, c, b->sec3.length );
+  if ( copy )
+    {
+      memcpy ( b->sec3.raw, c, ( b->sec3.length < BUFR_LEN_SEC3 ) ? b->sec3.length : BUFR_LEN_SEC3 );
+      b->sec3.raw_ptr = b->sec3.raw;
+    }
+  else
+    b->sec3.raw_ptr = c;
   c += b->sec3.length;
 
   /******************* section 4 *****************************/
-  b->sec4.length = three_bytes_to_uint32 ( c );
-  // we copy 4 byte more without danger because of latest '7777' and to use fastest exctracting bits algorithm
-  memcpy ( b->sec4.raw, c, b->sec4.length + 4 );
+  if ( ( c + 4 ) > end || ( c + ( b->sec4.length = three_bytes_to_uint32 ( c ) ) ) > end )
+    {
+      sprintf ( b->error, "bufrdeco_read_buffer(): Bad length of sec4\n" );
+      return 1;
+    }
+  if ( copy )
+    {
+      // we copy 4 byte more without danger because of latest '7777' and to use fastest exctracting bits algorithm
+      memcpy ( b->sec4.raw, c, b->sec4.length + 4 );
+      b->sec4.raw_ptr = b->sec4.raw;
+    }
+  else
+    b->sec4.raw_ptr = c; // Here the 4 bytes more are the '7777' in buffer
+  b->sec4.bits.data = b->sec4.raw_ptr + 4;
+  b->sec4.bits.nbytes = b->sec4.length; // length - 4 bytes of data and the '7777'
 
   b->sec4.bit_offset = 32; // the first bit in byte 4
 
+  // Changes in table B by operators are only valid in a message
+  bufrdeco_reset_tableb_overlay ( b );
+
   if ( b->mask & BUFRDECO_USE_ECMWF_TABLES )
     {
       if ( bufr_read_tables_ecmwf ( b ) )
@@ -275,3 +373,48 @@ int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
     }
   return 0;
 }
+
+/*!
+  \fn int bufrdeco_read_buffer ( struct bufrdeco *b, uint8_t *bufrx, size_t size  )
+  \brief Read a memory buffer and does preliminary and first decode pass
+  \param b pointer to struct \ref bufrdeco
+  \param bufrx buffer already allocated by caller
+  \param size size of BUFR in buffer
+
+  This function does the folowing tasks:
+  - Splits and parse the BUFR sections (without expanding descriptors nor parsing data)
+  - Reads the needed Table files and store them in memory.
+
+  The sections are copied into \a b, so the buffer can be released by caller after this call
+
+  Returns 0 if all is OK, 1 otherwise
+ */
+int bufrdeco_read_buffer ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
+{
+  // Some fast checks
+  if ( ( size + 4 ) >= BUFR_LEN )
+    {
+      sprintf ( b->error, "bufrdeco_init_buffer(): Buffer provided too large. Consider increase BUFR_LEN\n" );
+      return 1;
+    }
+
+  return bufrdeco_split_sections ( b, bufrx, size, 1 );
+}
+
+/*!
+  \fn int bufrdeco_read_buffer_view ( struct bufrdeco *b, uint8_t *bufrx, size_t size  )
+  \brief Read a memory buffer and does preliminary and first decode pass without copying it
+  \param b pointer to struct \ref bufrdeco
+  \param bufrx buffer already allocated by caller
+  \param size size of BUFR in buffer
+
+  As \ref bufrdeco_read_buffer but the sections are not copied. The raw pointers of sections
+  point into \a bufrx, so the buffer must be kept unchanged by caller until the bufr has been
+  decoded and \ref bufrdeco_reset has been called. There is no limit of \ref BUFR_LEN for the size.
+
+  Returns 0 if all is OK, 1 otherwise
+ */
+int bufrdeco_read_buffer_view ( struct bufrdeco *b,  uint8_t *bufrx, size_t size )
+{
+  return bufrdeco_split_sections ( b, bufrx, size, 0 );
+}
@@ -56,17 +56,9 @@ int bufr_read_tableb ( struct bufr_tableb *tb, char *error )
       return 1;
     }
 
-  // If we've already readed this table. We just regenerate the table with original values
+  // If we've already readed this table there is nothing to do. Tables are never changed when decoding
   if ( strcmp ( tb->path, tb->old_path ) == 0 )
     {
-      //printf ("Reutilizo tablas\n");
-      for ( i = 0; i < tb->nlines ; i++ )
-        {
-          tb->item[i].scale = tb->item[i].scale_ori;
-          tb->item[i].reference = tb->item[i].reference_ori;
-          tb->item[i].nbits = tb->item[i].nbits_ori;
-          tb->item[i].changed = 0;
-        }
       return 0; // all done
     }
 
@@ -90,15 +82,17 @@ int bufr_read_tableb ( struct bufr_tableb *tb, char *error )
       // First we build the descriptor
       ix = strtoul ( & ( l[0] ), &c, 10 );
       uint32_t_to_descriptor ( &desc, ix );
-      tb->item[i].changed = 0; // Original from table B
       tb->item[i].x = desc.x; // x
       tb->item[i].y = desc.y; // y
-      strcpy ( tb->item[i].key, desc.c ); // key
+      bufr_descriptor_to_string ( tb->item[i].key, &desc ); // key
       if ( tb->x_start[desc.x] == 0 )
         {
           tb->x_start[desc.x] = i;  // marc the start
         }
-      tb->y_ref[desc.x][desc.y] = i - tb->x_start[desc.x]; // marc the position from start of first x
+      if ( tb->dindex[desc.x][desc.y] == 0 )
+        {
+          tb->dindex[desc.x][desc.y] = i + 1; // direct index by descriptor
+        }
 
       // detailed name
       bufr_charray_to_string ( tb->item[i].name, &l[8], 64 );
@@ -109,16 +103,13 @@ int bufr_read_tableb ( struct bufr_tableb *tb, char *error )
       bufr_adjust_string ( tb->item[i].unit );
 
       // escale
-      tb->item[i].scale_ori = strtol ( &l[97], &c, 10 );
-      tb->item[i].scale = tb->item[i].scale_ori;
+      tb->item[i].scale = strtol ( &l[97], &c, 10 );
 
       // reference
-      tb->item[i].reference_ori = strtol ( &l[102], &c, 10 );
-      tb->item[i].reference = tb->item[i].reference_ori;
+      tb->item[i].reference = strtol ( &l[102], &c, 10 );
 
       // bits
-      tb->item[i].nbits_ori = strtol ( &l[115], &c, 10 );
-      tb->item[i].nbits = tb->item[i].nbits_ori;
+      tb->item[i].nbits = strtol ( &l[115], &c, 10 );
 
       /*printf("%s %s %s %d %u %lu\n", tb->item[i].key, tb->item[i].name, tb->item[i].unit,
        tb->item[i].escale, tb->item[i].reference, tb->item[i].nbits);*/
@@ -128,93 +119,153 @@ int bufr_read_tableb ( struct bufr_tableb *tb, char *error )
   fclose ( t );
   tb->nlines = i;
   tb->wmo_table = 0;
+  bufr_tableb_set_metadata ( tb );
   strcpy ( tb->old_path, tb->path ); // store latest path
   return 0;
 }
 
 /*!
-  \fn int bufr_restore_original_tableb_item ( struct bufr_tableb *tb, struct bufrdeco *b, uint8_t mode, char *key )
+  \fn int bufr_restore_original_tableb_item ( struct bufr_tableb *tb, struct bufrdeco *b, uint8_t mode, uint16_t key )
   \brief Restores the original table B parameters for a BUFR descriptor
   \param tb pointer to struct \ref bufr_tableb where are stored all table B data
   \param b pointer to the basic struct \ref bufrdeco
   \param mode integer with bit mask about changed parameteres by operator descriptors
   \param key descriptor string in format FXXYYY
 
+  Table B is never changed. Changes of scale and bits by operators 2 01 YYY and 2 02 YYY are in b->state
+  and only the reference changed by 2 03 YYY is stored in b->tableb_overlay. Here that change is discarded.
+
   Return 0 if success, 1 otherwise
 */
-int bufr_restore_original_tableb_item ( struct bufr_tableb *tb, struct bufrdeco *b, uint8_t mode, char *key )
+int bufr_restore_original_tableb_item ( struct bufr_tableb *tb, struct bufrdeco *b, uint8_t mode, uint16_t key )
 {
-  size_t i;
+  size_t i, j;
+  char aux[8];
+  struct bufr_tableb_overlay *o = & ( b->tableb_overlay );
 
   if ( bufr_find_tableb_index ( &i, tb, key ) )
     {
-      sprintf ( b->error, "bufr_restore_original_tableb_item(): descriptor '%s' not found in table B\n", key );
+      sprintf ( b->error, "bufr_restore_original_tableb_item(): descriptor '%s' not found in table B\n",
+                bufr_key_to_string ( aux, key ) );
       return 1; // descritor not found
     }
 
-  // escale
-  if ( mode & BUFR_TABLEB_CHANGED_SCALE || mode == 0 )
-    {
-      tb->item[i].scale = tb->item[i].scale_ori;
-      tb->item[i].changed &= ~ ( BUFR_TABLEB_CHANGED_SCALE ); // Clear bit mask
-    }
-
   // reference
-  if ( mode & BUFR_TABLEB_CHANGED_REFERENCE || mode == 0 )
+  if ( ( mode & BUFR_TABLEB_CHANGED_REFERENCE || mode == 0 ) && o->changed[i] )
     {
-      tb->item[i].reference = tb->item[i].reference_ori;
-      tb->item[i].changed &= ~ ( BUFR_TABLEB_CHANGED_REFERENCE ); // Clear bit mask
+      o->changed[i] = 0;
+      for ( j = 0; j < o->nchanged; j++ )
+        {
+          if ( o->index[j] == i )
+            {
+              o->index[j] = o->index[o->nchanged - 1];
+              o->nchanged--;
+              break;
+            }
+        }
     }
-  // bits
-  if ( mode & BUFR_TABLEB_CHANGED_BITS || mode == 0 )
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tableb_reference ( int32_t *reference, struct bufrdeco *b, size_t i )
+  \brief Get the current reference of an item in table B
+  \param reference pointer where to set the result
+  \param b pointer to the basic struct \ref bufrdeco
+  \param i index of item in table B
+
+  The reference is the one changed by operator 2 03 YYY, if any, or the original from table B
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_tableb_reference ( int32_t *reference, struct bufrdeco *b, size_t i )
+{
+  if ( i >= BUFR_MAXLINES_TABLEB )
+    return 1;
+
+  if ( b->tableb_overlay.changed[i] )
+    *reference = b->tableb_overlay.reference[i];
+  else
+    *reference = b->tables->b.item[i].reference;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tableb_change_reference ( struct bufrdeco *b, size_t i, int32_t reference )
+  \brief Set a new reference for an item in table B, as operator 2 03 YYY does
+  \param b pointer to the basic struct \ref bufrdeco
+  \param i index of item in table B
+  \param reference the new reference
+
+  The change is stored in b->tableb_overlay, so the shared table B is not modified
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_tableb_change_reference ( struct bufrdeco *b, size_t i, int32_t reference )
+{
+  struct bufr_tableb_overlay *o = & ( b->tableb_overlay );
+
+  if ( i >= BUFR_MAXLINES_TABLEB )
+    return 1;
+
+  if ( o->changed[i] == 0 )
     {
-      tb->item[i].nbits = tb->item[i].nbits_ori;
-      tb->item[i].changed &= ~ ( BUFR_TABLEB_CHANGED_BITS ); // Clear bit mask
+      o->changed[i] = 1;
+      o->index[o->nchanged++] = i;
     }
+  o->reference[i] = reference;
   return 0;
 }
 
 /*!
-  \fn int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, const char *key )
+  \fn int bufrdeco_reset_tableb_overlay ( struct bufrdeco *b )
+  \brief Discard all changes made in table B by operator descriptors
+  \param b pointer to the basic struct \ref bufrdeco
+
+  Only the changed items are cleared, so the cost is proportional to the amount of changes.
+  Operator 2 03 000 does this, and also it is done for every new message
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_reset_tableb_overlay ( struct bufrdeco *b )
+{
+  size_t j;
+  struct bufr_tableb_overlay *o = & ( b->tableb_overlay );
+
+  for ( j = 0; j < o->nchanged; j++ )
+    o->changed[o->index[j]] = 0;
+  o->nchanged = 0;
+  return 0;
+}
+
+/*!
+  \fn int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, uint16_t key )
   \brief found a descriptor index in a struct \ref bufr_tableb
   \param index pointer  to a size_t where to set the result if success
   \param tb pointer to struct \ref bufr_tableb where are stored all table B data
-  \param key descriptor string in format FXXYYY
+  \param key integer key of descriptor, as returned by \ref bufr_descriptor_to_key
+
+  The item is found with a single probe in the direct index tb->dindex[x][y], built when reading the table
 
   Return 0 if success, 1 otherwise
 */
-int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, const char *key )
+int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, uint16_t key )
 {
-  uint32_t ix;
-  size_t i, i0;
-  char *c;
-  struct bufr_descriptor desc;
+  uint16_t j;
 
-  ix = strtoul ( key, &c, 10 );
-  uint32_t_to_descriptor ( &desc, ix );
-
-  // first chance
-  i0 = tb->x_start[desc.x] + tb->y_ref[desc.x][desc.y];
-  if ( tb->item[i0].x == desc.x && tb->item[i0].y == desc.y )
+  // Only descriptors with f == 0 are in table B. Then the key is just x * 256 + y
+  if ( key >> 14 )
     {
-      *index = i0;
-      return 0;
+      return 1;
     }
-  // Second chance
-  i0 = tb->x_start[desc.x];
-  for ( i = i0 ; i < i0 + tb->num[desc.x] ; i++ )
+
+  j = tb->dindex[key >> 8][key & 0xff];
+  if ( j == 0 )
     {
-      if ( tb->item[i].x != desc.x )
-        {
-          return 1; // descriptor not found
-        }
-      if ( tb->item[i].y == desc.y )
-        {
-          *index = i;
-          return 0; // found
-        }
+      return 1; // descriptor not found
     }
-  return 1; // not found
+  *index = j - 1;
+  return 0;
 }
 
 /*!
@@ -230,6 +281,7 @@ int bufr_find_tableb_index ( size_t *index, struct bufr_tableb *tb, const char *
 int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrdeco *b, struct bufr_descriptor *d, int mode )
 {
   size_t i;
+  int32_t reference;
   uint32_t ival;
   uint8_t has_data;
   struct bufr_tableb *tb;
@@ -262,19 +314,21 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
       r->bit0 = b->state.bit_offset; // OFFSET
       strcpy ( r->name, "LOCAL DESCRIPTOR" );
       strcpy ( r->unit, "UNKNOWN" );
+      r->value_kind = 0;
+      r->factor = 1.0;
 
       // get bits for ref0
-      if ( get_bits_as_uint32_t ( &r->ref0, &r->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ),
-                                  b->state.local_bit_reserved ) == 0 )
+      if ( bit_reader_get_uint32_t ( &r->ref0, &r->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ),
+                                     b->state.local_bit_reserved ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
 
       // and get 6 bits for inc_bits
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), 6 ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), 6 ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
 
@@ -289,22 +343,27 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
     }
 
   // build the index for tableB
-  i = tb->x_start[d->x] + tb->y_ref[d->x][d->y];
+  if ( bufr_find_tableb_index ( &i, tb, bufr_descriptor_to_key ( d ) ) )
+    {
+      sprintf ( b->error, "bufrdeco_tableb_compressed(): descriptor '%u%02u%03u' not found in table B\n", d->f, d->x, d->y );
+      return 1;
+    }
 
   // copy the descriptor to reference member desc
   memcpy ( & ( r->desc ), d, sizeof ( struct bufr_descriptor ) );
-  r->ref = tb->item[i].reference_ori; // copy the reference value from tableB, first from original
+  r->ref = tb->item[i].reference; // copy the reference value from tableB, first from original
   r->bits = tb->item[i].nbits + b->state.added_bit_length; // copy the bits from tableB
   r->escale = tb->item[i].scale; // copy the scale from Tableb
   strcpy ( r->name, tb->item[i].name ); // copy the name
   strcpy ( r->unit, tb->item[i].unit ); // copy the unit name
+  r->value_kind = tb->item[i].kind;
 
   // Add the added_scaled if not flag or code table
-  if ( strstr ( r->unit, "CODE TABLE" ) != r->unit &&  strstr ( r->unit,"FLAG" ) != r->unit &&
-       strstr ( r->unit, "Code table" ) != r->unit &&  strstr ( r->unit,"Flag" ) != r->unit )
+  if ( r->value_kind != BUFR_VALUE_CODE_TABLE && r->value_kind != BUFR_VALUE_FLAG_TABLE )
     {
       r->escale += b->state.added_scale;
     }
+  r->factor = ( r->escale == tb->item[i].scale ) ? tb->item[i].factor : bufr_tableb_scale_factor ( r->escale );
   r->bit0 = b->state.bit_offset; // Sets the reference offset to current state offset
   r->cref0[0] = '\0'; // default
   r->ref0 = 0 ; // default
@@ -314,33 +373,35 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
     {
       // The descriptor operator 2 03 YYY is on action
       // get the bits
-      if ( get_bits_as_uint32_t ( &ival, &r->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), r->bits ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &r->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), r->bits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
 
-      // Change the reference value in tableB with value previously readed
-      // (we still have the original value in reference_ori)
-      if ( get_table_b_reference_from_uint32_t ( & ( tb->item[i].reference ), b->state.changing_reference, ival ) )
+      // Change the reference value with value previously readed
+      // (table B keeps the original value, the new one is in the overlay)
+      if ( get_table_b_reference_from_uint32_t ( &reference, b->state.changing_reference, ival ) ||
+           bufrdeco_tableb_change_reference ( b, i, reference ) )
         {
-          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot change reference in 2 03 YYY operator for '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot change reference in 2 03 YYY operator for '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       strcpy ( r->unit, "NEW REFERENCE" );
-      r->ref = tb->item[i].reference;
+      r->value_kind = BUFR_VALUE_NUMERIC;
+      r->ref = reference;
 
       // extracting inc_bits from next 6 bits
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), 6 ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), 6 ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       // Here is supossed that all subsets will have the same reference change,
       // so inc_bits must be 0 and no inc data should be present
       if ( ival )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Bad format for compressed data when changing reference from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Bad format for compressed data when changing reference from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       r->ref0 = 0; // here we also assume that ref0 = 0
@@ -348,22 +409,22 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
       return 0;
     }
 
-  if ( strstr ( r->unit, "CCITT" ) != NULL )
+  if ( r->value_kind == BUFR_VALUE_CCITT )
     {
       // Case of CCITT string as unit
 
       if ( b->state.fixed_ccitt != 0 ) // can be changed by 2 08 YYY operator
         r->bits = 8 * b->state.fixed_ccitt;
 
-      if ( get_bits_as_char_array ( r->cref0, &r->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), r->bits ) == 0 )
+      if ( bit_reader_get_char_array ( r->cref0, &r->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), r->bits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get uchars from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get uchars from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       // extracting inc_bits from next 6 bits
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), 6 ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), 6 ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       r->inc_bits = ival;
@@ -380,9 +441,9 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
   // get reference value
   if ( mode ) // case of associated field
     {
-      if ( get_bits_as_uint32_t ( &r->ref0, &r->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), b->state.assoc_bits ) == 0 )
+      if ( bit_reader_get_uint32_t ( &r->ref0, &r->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), b->state.assoc_bits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get associated bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get associated bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       // patch for delayed descriptor: it allways have data
@@ -391,9 +452,9 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
     }
   else // case of data
     {
-      if ( get_bits_as_uint32_t ( &r->ref0, &r->has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), r->bits ) == 0 )
+      if ( bit_reader_get_uint32_t ( &r->ref0, &r->has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), r->bits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get the data bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get the data bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       // patch for delayed descriptor: it allways have data
@@ -402,9 +463,9 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
     }
 
   // extracting inc_bits from next 6 bits for inc_bits
-  if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), 6 ) == 0 )
+  if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), 6 ) == 0 )
     {
-      sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%s'\n", d->c );
+      sprintf ( b->error, "bufrdeco_tableb_compressed(): Cannot get 6 bits for inc_bits from '%u%02u%03u'\n", d->f, d->x, d->y );
       return 1;
     }
   r->inc_bits = ival;
@@ -422,52 +483,91 @@ int bufrdeco_tableb_compressed ( struct bufrdeco_compressed_ref *r, struct bufrd
 }
 
 /*!
-  \fn int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
-  \brief Get data from a table B descriptor
+  \fn uint8_t bufr_tableb_value_kind ( const char *unit )
+  \brief Returns the kind of value of a table B descriptor from its unit
+  \param unit string with the unit of descriptor in table B
+
+  Returns \ref BUFR_VALUE_CCITT, \ref BUFR_VALUE_CODE_TABLE, \ref BUFR_VALUE_FLAG_TABLE or \ref BUFR_VALUE_NUMERIC
+*/
+uint8_t bufr_tableb_value_kind ( const char *unit )
+{
+  if ( strstr ( unit, "CCITT" ) != NULL )
+    return BUFR_VALUE_CCITT;
+  if ( strstr ( unit, "CODE TABLE" ) == unit || strstr ( unit, "Code table" ) == unit )
+    return BUFR_VALUE_CODE_TABLE;
+  if ( strstr ( unit, "FLAG" ) == unit || strstr ( unit, "Flag" ) == unit )
+    return BUFR_VALUE_FLAG_TABLE;
+  return BUFR_VALUE_NUMERIC;
+}
+
+/*!
+  \fn double bufr_tableb_scale_factor ( int32_t escale )
+  \brief Returns the multiplier to apply a scale to a value, i.e. 10 ^ ( - \a escale )
+  \param escale the scale
+
+  Usual scales are got from constants, so the result is the nearest double to the exact power of 10
+*/
+double bufr_tableb_scale_factor ( int32_t escale )
+{
+  if ( escale >= 0 && escale < 8 )
+    return pow10neg[ ( size_t ) escale];
+  else if ( escale < 0 && escale > -8 )
+    return pow10pos[ ( size_t ) ( -escale )];
+  return pow10 ( ( double ) ( -escale ) );
+}
+
+/*!
+  \fn int bufr_tableb_set_metadata ( struct bufr_tableb *tb )
+  \brief Set the kind of value and scale multiplier of every item in a table B just read
+  \param tb pointer to the struct \ref bufr_tableb
+
+  So no string nor math functions are needed to decode every value
+
+  Returns 0
+*/
+int bufr_tableb_set_metadata ( struct bufr_tableb *tb )
+{
+  size_t i;
+
+  for ( i = 0; i < tb->nlines; i++ )
+    {
+      tb->item[i].kind = bufr_tableb_value_kind ( tb->item[i].unit );
+      tb->item[i].factor = bufr_tableb_scale_factor ( tb->item[i].scale );
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tableb_item_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i, uint8_t kind )
+  \brief Get data from a table B descriptor once its item in table B and kind of value are known
   \param a pointer to a struct \ref bufr_atom_data where to set the results
   \param b pointer to the basic struct \ref bufrdeco
   \param d pointer to the target descriptor
+  \param i index of descriptor in table B
+  \param kind kind of value as returned by \ref bufr_tableb_value_kind
+
+  This is used by the compiled plans (see \ref bufrdeco_decode_subset_data_plan), which know \a i and \a kind
 
   Return 0 if success, 1 otherwise
 */
-int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
+int bufrdeco_tableb_item_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i,
+                               uint8_t kind )
 {
-  size_t i, nbits = 0;
+  size_t nbits = 0, tablec_ref;
   uint32_t ival;
   uint8_t has_data;
   int32_t /*escale = 0,*/ reference = 0;
+  char *cval, ctable[BUFR_EXPLAINED_LENGTH];
   struct bufr_tableb *tb;
 
   tb = & ( b->tables->b );
 
-  // Reject wrong arguments
-  if ( a == NULL || b == NULL || d == NULL )
-    {
-      return 1;
-    }
-
-  if ( is_a_local_descriptor ( d ) )
-    {
-      // if is a local descriptor we just skip the bits signified by operator 2 06 YYY
-      a->mask = DESCRIPTOR_IS_LOCAL;
-      strcpy ( a->name, "LOCAL DESCRIPTOR" );
-      strcpy ( a->unit, "UNKNOWN" );
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), b->state.local_bit_reserved ) == 0 )
-        {
-          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%s'\n", d->c );
-          return 1;
-        }
-      a->val = ival; // we assume escale = 0 and ref = 0
-      b->state.local_bit_reserved = 0; // Clean the reserved bits
-      return 0;
-    }
-
-  i = tb->x_start[d->x] + tb->y_ref[d->x][d->y];
-
   memcpy ( & ( a->desc ), d, sizeof ( struct bufr_descriptor ) );
   a->mask = 0;
-  strcpy ( a->name, tb->item[i].name );
-  strcpy ( a->unit, tb->item[i].unit );
+  a->name = tb->item[i].name;
+  a->unit = tb->item[i].unit;
+  a->cval = "";
+  a->ctable = "";
   a->escale = tb->item[i].scale;
 
   // Case of difference statistics active
@@ -479,19 +579,20 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
   if ( b->state.changing_reference != 255 )
     {
       // The descriptor operator 2 03 YYY is on action
-      if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), nbits ) == 0 )
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), nbits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
       // Change the reference value
-      if ( get_table_b_reference_from_uint32_t ( & ( tb->item[i].reference ), b->state.changing_reference, ival ) )
+      if ( get_table_b_reference_from_uint32_t ( &reference, b->state.changing_reference, ival ) ||
+           bufrdeco_tableb_change_reference ( b, i, reference ) )
         {
-          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot change reference in 2 03 YYY operator for '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot change reference in 2 03 YYY operator for '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
-      strcpy ( a->unit, "NEW REFERENCE" );
-      a->val = ( double ) tb->item[i].reference;
+      a->unit = "NEW REFERENCE";
+      a->val = ( double ) reference;
       return 0;
     }
 
@@ -499,19 +600,25 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
   if ( b->state.dstat_active )
     reference = - ( ( int32_t ) 1 << ( tb->item[i].nbits ) );
   else
-    reference = tb->item[i].reference;
+    bufrdeco_tableb_reference ( &reference, b, i );
 
   //printf(" escale = %d  reference = %d nbits = %lu\n", escale, reference, nbits);
-  if ( strstr ( a->unit, "CCITT" ) != NULL )
+  if ( kind == BUFR_VALUE_CCITT )
     {
       if ( b->state.fixed_ccitt != 0 ) // can be changed by 2 08 YYY operator
         nbits = 8 * b->state.fixed_ccitt;
 
-      if ( get_bits_as_char_array ( a->cval, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), nbits ) == 0 )
+      if ( ( cval = bufrdeco_string_arena_alloc ( & ( b->strings ), nbits / 8 + 1 ) ) == NULL )
+        {
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot allocate a string for '%u%02u%03u'\n", d->f, d->x, d->y );
+          return 1;
+        }
+      if ( bit_reader_get_char_array ( cval, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), nbits ) == 0 )
         {
-          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get uchars from '%s'\n", d->c );
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get uchars from '%u%02u%03u'\n", d->f, d->x, d->y );
           return 1;
         }
+      a->cval = cval;
       if ( has_data == 0 )
         {
           a->mask |= DESCRIPTOR_VALUE_MISSING;
@@ -527,9 +634,9 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
   // Set associated bits
   if ( b->state.assoc_bits &&
        a->desc.x != 31 &&  // Data description qualifier has not associated bits itself
-       get_bits_as_uint32_t ( &a->associated, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), b->state.assoc_bits ) == 0 )
+       bit_reader_get_uint32_t ( &a->associated, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), b->state.assoc_bits ) == 0 )
     {
-      sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get associated bits from '%s'\n", d->c );
+      sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get associated bits from '%u%02u%03u'\n", d->f, d->x, d->y );
       return 1;
     }
   else
@@ -537,16 +644,15 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
       a->associated = MISSING_INTEGER;
     }
 
-  if ( strstr ( a->unit, "CODE TABLE" ) != a->unit &&  strstr ( a->unit,"FLAG" ) != a->unit &&
-       strstr ( a->unit, "Code table" ) != a->unit &&  strstr ( a->unit,"Flag" ) != a->unit )
+  if ( kind == BUFR_VALUE_NUMERIC )
     {
       // case of numeric, no string nor code nor flag
       nbits += b->state.added_bit_length;
     }
 
-  if ( get_bits_as_uint32_t ( &ival, &has_data, &b->sec4.raw[4], & ( b->state.bit_offset ), nbits ) == 0 )
+  if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), nbits ) == 0 )
     {
-      sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%s'\n", d->c );
+      sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
       return 1;
     }
 
@@ -556,43 +662,41 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
 
   if ( has_data )
     {
-      if ( strstr ( a->unit, "CODE TABLE" ) != a->unit &&  strstr ( a->unit,"FLAG" ) != a->unit &&
-           strstr ( a->unit, "Code table" ) != a->unit &&  strstr ( a->unit,"Flag" ) != a->unit )
+      if ( kind == BUFR_VALUE_NUMERIC )
         {
           a->escale += b->state.added_scale;
           reference += b->state.added_reference;
           if ( b->state.factor_reference > 1 )
             reference *= b->state.factor_reference;
         }
-      // Get a numeric number
-      if ( a->escale >= 0 && a->escale < 8 )
+      // Get a numeric number. The multiplier is in table B unless changed by 2 02 YYY
+      if ( a->escale == tb->item[i].scale )
         {
-          a->val = ( double ) ( ( int32_t ) ival + reference ) * pow10neg[ ( size_t ) a->escale];
-        }
-      else if ( a->escale < 0 && a->escale > -8 )
-        {
-          a->val = ( double ) ( ( int32_t ) ival + reference ) * pow10pos[ ( size_t ) ( -a->escale )];
+          a->val = ( double ) ( ( int32_t ) ival + reference ) * tb->item[i].factor;
         }
       else
         {
-          a->val = ( double ) ( ( int32_t ) ival + reference ) * pow10 ( ( double ) ( -a->escale ) );
+          a->val = ( double ) ( ( int32_t ) ival + reference ) * bufr_tableb_scale_factor ( a->escale );
         }
 
-      if ( strstr ( a->unit, "CODE TABLE" ) == a->unit || strstr ( a->unit, "Code table" ) == a->unit )
+      if ( kind == BUFR_VALUE_CODE_TABLE )
         {
           ival = ( uint32_t ) ( a->val + 0.5 );
           a->mask |= DESCRIPTOR_IS_CODE_TABLE;
-          if ( bufrdeco_explained_table_val ( a->ctable, 256, & ( b->tables->c ), & ( tb->item[i].tablec_ref ), & ( a->desc ), ival ) != NULL )
+          tablec_ref = tb->item[i].tablec_ref; // a copy, table B is not changed when decoding
+          if ( bufrdeco_explained_table_val ( ctable, BUFR_EXPLAINED_LENGTH, & ( b->tables->c ), &tablec_ref, & ( a->desc ), ival ) != NULL &&
+               ( a->ctable = bufrdeco_string_arena_copy ( & ( b->strings ), ctable ) ) != NULL )
             {
               a->mask |= DESCRIPTOR_HAVE_CODE_TABLE_STRING;
             }
         }
-      else if ( strstr ( a->unit,"FLAG" ) == a->unit || strstr ( a->unit,"Flag" ) == a->unit )
+      else if ( kind == BUFR_VALUE_FLAG_TABLE )
         {
           ival = ( uint32_t ) ( a->val + 0.5 );
           a->mask |= DESCRIPTOR_IS_FLAG_TABLE;
 
-          if ( bufrdeco_explained_flag_val ( a->ctable, 256, & ( b->tables->c ), & ( a->desc ), ival, nbits ) != NULL )
+          if ( bufrdeco_explained_flag_val ( ctable, BUFR_EXPLAINED_LENGTH, & ( b->tables->c ), & ( a->desc ), ival, nbits ) != NULL &&
+               ( a->ctable = bufrdeco_string_arena_copy ( & ( b->strings ), ctable ) ) != NULL )
             {
               a->mask |= DESCRIPTOR_HAVE_FLAG_TABLE_STRING;
             }
@@ -606,3 +710,130 @@ int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct b
 
   return 0;
 }
+
+/*!
+  \fn int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
+  \brief Get data from a table B descriptor
+  \param a pointer to a struct \ref bufr_atom_data where to set the results
+  \param b pointer to the basic struct \ref bufrdeco
+  \param d pointer to the target descriptor
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_tableb_val ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
+{
+  size_t i;
+  uint32_t ival;
+  uint8_t has_data;
+  struct bufr_tableb *tb;
+
+  tb = & ( b->tables->b );
+
+  // Reject wrong arguments
+  if ( a == NULL || b == NULL || d == NULL )
+    {
+      return 1;
+    }
+
+  if ( is_a_local_descriptor ( d ) )
+    {
+      // if is a local descriptor we just skip the bits signified by operator 2 06 YYY
+      a->mask = DESCRIPTOR_IS_LOCAL;
+      a->name = "LOCAL DESCRIPTOR";
+      a->unit = "UNKNOWN";
+      a->cval = "";
+      a->ctable = "";
+      if ( bit_reader_get_uint32_t ( &ival, &has_data, & ( b->sec4.bits ), & ( b->state.bit_offset ), b->state.local_bit_reserved ) == 0 )
+        {
+          sprintf ( b->error, "bufrdeco_tableb_val(): Cannot get bits from '%u%02u%03u'\n", d->f, d->x, d->y );
+          return 1;
+        }
+      a->val = ival; // we assume escale = 0 and ref = 0
+      b->state.local_bit_reserved = 0; // Clean the reserved bits
+      return 0;
+    }
+
+  if ( bufr_find_tableb_index ( &i, tb, bufr_descriptor_to_key ( d ) ) )
+    {
+      sprintf ( b->error, "bufrdeco_tableb_val(): descriptor '%u%02u%03u' not found in table B\n", d->f, d->x, d->y );
+      return 1;
+    }
+
+  return bufrdeco_tableb_item_val ( a, b, d, i, tb->item[i].kind );
+}
+
+/*!
+  \fn int bufrdeco_tableb_item_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i, uint8_t kind )
+  \brief Skip the data of a table B descriptor once its item in table B and kind of value are known, just updating the bit offset
+  \param a pointer to a struct \ref bufr_atom_data used as scratch when data must be decoded anyway
+  \param b pointer to the basic struct \ref bufrdeco
+  \param d pointer to the target descriptor
+  \param i index of descriptor in table B
+  \param kind kind of value as returned by \ref bufr_tableb_value_kind
+
+  The width of data is got as in \ref bufrdeco_tableb_item_val, but nothing is read. The descriptors defining
+  a new reference value are fully decoded in \a a
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_tableb_item_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d, size_t i,
+                                uint8_t kind )
+{
+  size_t nbits;
+
+  if ( b->state.changing_reference != 255 )
+    {
+      return bufrdeco_tableb_item_val ( a, b, d, i, kind );
+    }
+
+  nbits = b->tables->b.item[i].nbits;
+  if ( b->state.dstat_active )
+    nbits++;
+
+  if ( kind == BUFR_VALUE_CCITT )
+    {
+      if ( b->state.fixed_ccitt != 0 )
+        nbits = 8 * b->state.fixed_ccitt;
+    }
+  else
+    {
+      if ( b->state.assoc_bits && d->x != 31 )
+        nbits += b->state.assoc_bits;
+      if ( kind == BUFR_VALUE_NUMERIC )
+        nbits += b->state.added_bit_length;
+    }
+
+  b->state.bit_offset += nbits;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tableb_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
+  \brief Skip the data of a table B descriptor, just updating the bit offset
+  \param a pointer to a struct \ref bufr_atom_data used as scratch when data must be decoded anyway
+  \param b pointer to the basic struct \ref bufrdeco
+  \param d pointer to the target descriptor
+
+  It is \ref bufrdeco_tableb_item_skip once the descriptor is found in table B. Local descriptors are
+  fully decoded in \a a
+
+  Return 0 if success, 1 otherwise
+*/
+int bufrdeco_tableb_skip ( struct bufr_atom_data *a, struct bufrdeco *b, struct bufr_descriptor *d )
+{
+  size_t i;
+  struct bufr_tableb *tb = & ( b->tables->b );
+
+  if ( is_a_local_descriptor ( d ) )
+    {
+      return bufrdeco_tableb_val ( a, b, d );
+    }
+
+  if ( bufr_find_tableb_index ( &i, tb, bufr_descriptor_to_key ( d ) ) )
+    {
+      sprintf ( b->error, "bufrdeco_tableb_skip(): descriptor '%u%02u%03u' not found in table B\n", d->f, d->x, d->y );
+      return 1;
+    }
+
+  return bufrdeco_tableb_item_skip ( a, b, d, i, tb->item[i].kind );
+}
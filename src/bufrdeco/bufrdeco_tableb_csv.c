@@ -49,17 +49,9 @@ int bufr_read_tableb_csv ( struct bufr_tableb *tb, char *error )
       return 1;
     }
 
-  // If we've already readed this table. We just regenerate the table with original values
+  // If we've already readed this table there is nothing to do. Tables are never changed when decoding
   if ( strcmp ( tb->path, tb->old_path ) == 0 )
     {
-      //printf ("Reutilizo tablas\n");
-      for ( i = 0; i < tb->nlines ; i++ )
-        {
-          tb->item[i].scale = tb->item[i].scale_ori;
-          tb->item[i].reference = tb->item[i].reference_ori;
-          tb->item[i].nbits = tb->item[i].nbits_ori;
-          tb->item[i].changed = 0;
-        }
       return 0; // all done
     }
 
@@ -87,15 +79,17 @@ int bufr_read_tableb_csv ( struct bufr_tableb *tb, char *error )
       // First we build the descriptor
       ix = strtoul ( tk[0], &c, 10 );
       uint32_t_to_descriptor ( &desc, ix );
-      tb->item[i].changed = 0; // Original from table B
       tb->item[i].x = desc.x; // x
       tb->item[i].y = desc.y; // y
-      strcpy ( tb->item[i].key, desc.c ); // key
+      bufr_descriptor_to_string ( tb->item[i].key, &desc ); // key
       if ( tb->num[desc.x] == 0 )
         {
           tb->x_start[desc.x] = i;  // marc the start
         }
-      tb->y_ref[desc.x][desc.y] = i - tb->x_start[desc.x]; // marc the position from start of first x
+      if ( tb->dindex[desc.x][desc.y] == 0 )
+        {
+          tb->dindex[desc.x][desc.y] = i + 1; // direct index by descriptor
+        }
       ( tb->num[desc.x] )++;
 
       // detailed name
@@ -121,16 +115,13 @@ int bufr_read_tableb_csv ( struct bufr_tableb *tb, char *error )
       strcpy ( tb->item[i].unit, caux );
 
       // escale
-      tb->item[i].scale_ori = strtol ( tk[4], &c, 10 );
-      tb->item[i].scale = tb->item[i].scale_ori;
+      tb->item[i].scale = strtol ( tk[4], &c, 10 );
 
       // reference
-      tb->item[i].reference_ori = strtol ( tk[5], &c, 10 );
-      tb->item[i].reference = tb->item[i].reference_ori;
+      tb->item[i].reference = strtol ( tk[5], &c, 10 );
 
       // bits
-      tb->item[i].nbits_ori = strtol ( tk[6], &c, 10 );
-      tb->item[i].nbits = tb->item[i].nbits_ori;
+      tb->item[i].nbits = strtol ( tk[6], &c, 10 );
 
       i++;
     }
@@ -138,6 +129,7 @@ int bufr_read_tableb_csv ( struct bufr_tableb *tb, char *error )
   fclose ( t );
   tb->nlines = i;
   tb->wmo_table = 1;
+  bufr_tableb_set_metadata ( tb );
   strcpy ( tb->old_path, tb->path ); // store latest path
   return 0;
 }
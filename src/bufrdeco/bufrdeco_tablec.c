@@ -83,50 +83,295 @@ int bufr_read_tablec ( struct bufr_tablec *tc, char *error )
   fclose ( t );
   tc->nlines = i;
   tc->wmo_table = 0;
+  if ( bufr_tablec_build_index ( tc ) )
+    {
+      sprintf ( error,"Too many code entries in table C file '%s'\n", tc->path );
+      return 1;
+    }
   strcpy ( tc->old_path, tc->path ); // store latest path
   return 0;
 }
 
 /*!
- \fn  int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, const char *key )
+ \fn  int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, uint16_t key )
  \brief Find the index of a line in table C for a given key of a descriptor
  \param index pointer where to set the result
  \param tc pointer to a struct \ref bufr_tablec where all table data is stored
- \param key string in the form FXXYYY which is the key of descriptor we want to find out
+ \param key integer key of descriptor, as returned by \ref bufr_descriptor_to_key
 
  If the descriptor has been found with success then returns 0, othewise returns 1
 */
-int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, const char *key )
+int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, uint16_t key )
+{
+  struct bufr_descriptor desc;
+
+  bufr_key_to_descriptor ( &desc, key );
+  if ( desc.f != 0 || desc.x > 63 || tc->dstart[desc.x][desc.y] == 0 )
+    {
+      return 1; // not found
+    }
+  *index = tc->dstart[desc.x][desc.y] - 1;
+  return 0;
+}
+
+/*!
+  \fn uint64_t bufr_tablec_hash_key ( uint32_t x, uint32_t y, uint32_t code )
+  \brief Returns the key used in hash index of table C for a code or bit number of descriptor 0 x y
+  \param x x of descriptor
+  \param y y of descriptor
+  \param code code value, or bit number if a flag table
+*/
+uint64_t bufr_tablec_hash_key ( uint32_t x, uint32_t y, uint32_t code )
+{
+  return ( ( uint64_t ) ( x & 0x3F ) << 40 ) | ( ( uint64_t ) ( y & 0xFF ) << 32 ) | ( uint64_t ) code;
+}
+
+/*!
+  \fn static size_t bufr_tablec_hash_slot ( uint64_t key )
+  \brief Returns the first slot to probe in hash index of table C for a key
+  \param key the key as returned by \ref bufr_tablec_hash_key
+*/
+static size_t bufr_tablec_hash_slot ( uint64_t key )
 {
-  size_t i, i0;
-  size_t x = 0;
+  // Fibonacci hashing. The upper bits are the better mixed ones
+  return ( size_t ) ( ( key * 0x9E3779B97F4A7C15ULL ) >> 50 ) & ( BUFR_TABLEC_HASH_SIZE - 1 );
+}
+
+/*!
+  \fn static int bufr_tablec_hash_insert ( struct bufr_tablec *tc, uint64_t key, size_t index )
+  \brief Add an entry to the hash index of a struct \ref bufr_tablec
+  \param tc pointer to the struct \ref bufr_tablec
+  \param key the key as returned by \ref bufr_tablec_hash_key
+  \param index line (ECMWF) or item (WMO) in table for the key
+
+  If the key is already in index the first entry is kept, as a sequential search would do.
+
+  Returns 0 if success, 1 if the index is full
+*/
+static int bufr_tablec_hash_insert ( struct bufr_tablec *tc, uint64_t key, size_t index )
+{
+  size_t h, n;
+
+  h = bufr_tablec_hash_slot ( key );
+  for ( n = 0; n < BUFR_TABLEC_HASH_SIZE; n++ )
+    {
+      if ( tc->hash_index[h] == 0 )
+        {
+          tc->hash_key[h] = key;
+          tc->hash_index[h] = index + 1;
+          return 0;
+        }
+      if ( tc->hash_key[h] == key )
+        {
+          return 0; // already indexed
+        }
+      h = ( h + 1 ) & ( BUFR_TABLEC_HASH_SIZE - 1 );
+    }
+  return 1;
+}
+
+/*!
+  \fn int bufr_tablec_build_index ( struct bufr_tablec *tc )
+  \brief Builds the index by descriptor and the hash index by descriptor and code of a struct \ref bufr_tablec
+  \param tc pointer to the struct \ref bufr_tablec already read from file
+
+  It is called once when reading the table, so the code and flag values are found then with a direct lookup
+  instead of a sequential search over the table lines. It works either with ECMWF (lines) or WMO (items) tables
+
+  Every descriptor with all its codes from 0 to 63, as the flag tables, also gets an array with the line or item
+  of every bit number in \a tc->bits[], so a flag value is explained without hash probes.
+
+  Returns 0 if success, 1 otherwise
+*/
+int bufr_tablec_build_index ( struct bufr_tablec *tc )
+{
+  size_t i, k, n;
+  uint32_t x = 0, y = 0, v;
   char *c, aux[8];
+  int valid = 0;
+  uint8_t maxv[64][256]; // greatest code of every descriptor. 255 if greater than 63
+
+  memset ( tc->dstart, 0, sizeof ( tc->dstart ) );
+  memset ( tc->hash_index, 0, sizeof ( tc->hash_index ) );
+  memset ( tc->bits_start, 0, sizeof ( tc->bits_start ) );
+  memset ( tc->bits_len, 0, sizeof ( tc->bits_len ) );
+  memset ( tc->bits, 0, sizeof ( tc->bits ) );
+  memset ( maxv, 0, sizeof ( maxv ) );
 
-  aux[0] = key[1];
-  aux[1] = key[2];
-  aux[2] = '\0';
-  x = strtoul ( aux, &c, 10 );
-  i0 = tc->x_start[x];
-  for ( i = i0 ; i < i0 + tc->num[x] ; i++ )
+  for ( i = 0; i < tc->nlines; i++ )
     {
-      if ( tc->l[i][0] != key[0] ||
-           tc->l[i][1] != key[1] ||
-           tc->l[i][2] != key[2] ||
-           tc->l[i][3] != key[3] ||
-           tc->l[i][4] != key[4] ||
-           tc->l[i][5] != key[5] )
+      if ( tc->wmo_table )
         {
-          continue;
+          x = tc->item[i].x;
+          y = tc->item[i].y;
+          v = tc->item[i].ival;
         }
       else
         {
-          *index = i;
+          // A line with a descriptor
+          if ( tc->l[i][0] != ' ' && tc->l[i][0] != '\0' )
+            {
+              aux[0] = tc->l[i][1];
+              aux[1] = tc->l[i][2];
+              aux[2] = '\0';
+              x = strtoul ( aux, &c, 10 );
+              y = strtoul ( &tc->l[i][3], &c, 10 ) ;
+              valid = ( x < 64 && y < 256 );
+              if ( valid && tc->dstart[x][y] == 0 )
+                {
+                  tc->dstart[x][y] = i + 1;
+                }
+            }
+          // A line with a new code or bit number. Others are continuation lines
+          if ( ! valid || strlen ( tc->l[i] ) < 13 || tc->l[i][12] == ' ' )
+            {
+              continue;
+            }
+          v = strtoul ( &tc->l[i][12], &c, 10 );
+        }
+
+      if ( tc->wmo_table && tc->dstart[x][y] == 0 )
+        {
+          tc->dstart[x][y] = i + 1;
+        }
+
+      if ( bufr_tablec_hash_insert ( tc, bufr_tablec_hash_key ( x, y, v ), i ) )
+        {
+          return 1;
+        }
+
+      if ( x < 64 && y < 256 && maxv[x][y] < 64 )
+        {
+          maxv[x][y] = ( v < 64 ) ? ( ( v > maxv[x][y] ) ? v : maxv[x][y] ) : 255;
+        }
+    }
+
+  // The arrays by bit number
+  for ( x = 0, n = 0; x < 64; x++ )
+    {
+      for ( y = 0; y < 256; y++ )
+        {
+          if ( tc->dstart[x][y] == 0 || maxv[x][y] > 63 || ( n + maxv[x][y] + 1 ) > BUFR_TABLEC_BITS_SIZE )
+            {
+              continue;
+            }
+          tc->bits_start[x][y] = n + 1;
+          tc->bits_len[x][y] = maxv[x][y] + 1;
+          for ( v = 0; v <= maxv[x][y]; v++ )
+            {
+              if ( bufr_tablec_lookup ( &k, tc, x, y, v ) == 0 )
+                {
+                  tc->bits[n + v] = k + 1;
+                }
+            }
+          n += maxv[x][y] + 1;
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufr_tablec_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t code )
+  \brief Find the line (ECMWF) or item (WMO) of table C for a code or bit number of descriptor 0 x y
+  \param index pointer where to set the result
+  \param tc pointer to a struct \ref bufr_tablec with the index already built
+  \param x x of descriptor
+  \param y y of descriptor
+  \param code code value, or bit number if a flag table
+
+  Returns 0 if found, 1 otherwise
+*/
+int bufr_tablec_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t code )
+{
+  size_t h, n;
+  uint64_t key;
+
+  if ( x > 63 || y > 255 || tc->dstart[x][y] == 0 )
+    {
+      return 1; // descriptor not in table
+    }
+
+  key = bufr_tablec_hash_key ( x, y, code );
+  h = bufr_tablec_hash_slot ( key );
+  for ( n = 0; n < BUFR_TABLEC_HASH_SIZE && tc->hash_index[h]; n++ )
+    {
+      if ( tc->hash_key[h] == key )
+        {
+          *index = tc->hash_index[h] - 1;
           return 0;
         }
+      h = ( h + 1 ) & ( BUFR_TABLEC_HASH_SIZE - 1 );
     }
   return 1; // not found
 }
 
+/*!
+  \fn int bufr_tablec_bit_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t bit )
+  \brief Find the line (ECMWF) or item (WMO) of table C for a bit number of a flag table descriptor 0 x y
+  \param index pointer where to set the result
+  \param tc pointer to a struct \ref bufr_tablec with the index already built
+  \param x x of descriptor
+  \param y y of descriptor
+  \param bit bit number. 0 for the meaning of value 0
+
+  The array of bits of the descriptor built in \ref bufr_tablec_build_index is used. If the descriptor has no
+  array then the hash index is used as in \ref bufr_tablec_lookup
+
+  Returns 0 if found, 1 otherwise
+*/
+int bufr_tablec_bit_lookup ( size_t *index, struct bufr_tablec *tc, uint32_t x, uint32_t y, uint32_t bit )
+{
+  size_t s;
+
+  if ( x > 63 || y > 255 )
+    {
+      return 1;
+    }
+
+  if ( ( s = tc->bits_start[x][y] ) == 0 )
+    {
+      return bufr_tablec_lookup ( index, tc, x, y, bit );
+    }
+
+  if ( bit >= tc->bits_len[x][y] || tc->bits[s - 1 + bit] == 0 )
+    {
+      return 1; // not found
+    }
+  *index = tc->bits[s - 1 + bit] - 1;
+  return 0;
+}
+
+/*!
+  \fn static char * bufrdeco_append_tablec_line ( char *expl, size_t dim, struct bufr_tablec *tc, size_t i )
+  \brief Appends the explanation in line \a i of an ECMWF table C, with its continuation lines, to \a expl
+  \param expl string with resulting meaning
+  \param dim max length alowed for \a expl string
+  \param tc pointer to a \ref bufr_tablec struct
+  \param i line of table C with code or bit number
+
+  Returns \a expl
+*/
+static char * bufrdeco_append_tablec_line ( char *expl, size_t dim, struct bufr_tablec *tc, size_t i )
+{
+  char *c, *s;
+  uint32_t nx, nl;
+
+  // read how many lines for the description
+  nl = strtoul ( &tc->l[i][21], &c, 10 );
+  s = expl + strlen ( expl );
+  if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
+    {
+      s += sprintf ( s, "|" );
+    }
+  s += sprintf ( s,"%s", &tc->l[i][24] );
+  for ( nx = 1 ; nx < nl && ( i + nx ) < tc->nlines; nx++ )
+    if ( ( strlen ( expl ) + strlen ( &tc->l[i + nx][22] ) ) < dim )
+      {
+        s += sprintf ( s, "%s", &tc->l[i + nx][22] );
+      }
+  return expl;
+}
+
 
 /*!
   \fn char * bufrdeco_explained_table_val (char *expl, size_t dim, struct bufr_tablec *tc, struct bufr_descriptor *d, int ival)
@@ -142,9 +387,7 @@ int bufr_find_tablec_index ( size_t *index, struct bufr_tablec *tc, const char *
 */
 char * bufrdeco_explained_table_val ( char *expl, size_t dim, struct bufr_tablec *tc, size_t *index, struct bufr_descriptor *d, uint32_t ival )
 {
-  char *c;
-  uint32_t nv, v,  nl;
-  size_t  i, j;
+  size_t  i;
 
   if ( tc->wmo_table )
     {
@@ -152,63 +395,28 @@ char * bufrdeco_explained_table_val ( char *expl, size_t dim, struct bufr_tablec
       return bufrdeco_explained_table_csv_val ( expl, dim, tc, index, d, ival );
     }
 
-  if ( *index == 0 )
+  if ( d->x > 63 || tc->dstart[d->x][d->y] == 0 )
     {
-      // here the calling b item learn where to find table C line
-      if ( bufr_find_tablec_index ( index, tc, d->c ) )
-        {
-          //sprintf ( b->error, "bufrdeco_explained_table_val(): descriptor '%s' not found in table D\n", d->c );
-          return NULL; // descritor not found
-        }
+      return NULL; // descritor not found
     }
 
-  i = *index;
-  // reads the amount of possible values
-  if ( tc->l[i][7] != ' ' )
-    {
-      nv = strtoul ( &tc->l[i][7], &c, 10 );
-    }
-  else
-    {
-      return NULL;
-    }
+  // here the calling b item learn where to find table C line
+  *index = tc->dstart[d->x][d->y] - 1;
 
-  // read a value
-  for ( j = 0; j < nv && i < tc->nlines ; i++ )
+  // check the amount of possible values
+  if ( tc->l[*index][7] == ' ' )
     {
-      if ( tc->l[i][12] != ' ' )
-        {
-          v = strtoul ( &tc->l[i][12], &c, 10 );
-          j++;
-          if ( v != ival )
-            {
-              continue;
-            }
-          break;
-        }
+      return NULL;
     }
 
-  if ( j == nv || i == tc->nlines )
+  // find the value
+  if ( bufr_tablec_lookup ( &i, tc, d->x, d->y, ival ) )
     {
       return NULL;  // Value not found
     }
 
-  // read how many lines for the descriptors
-  nl = strtoul ( &tc->l[i][21], &c, 10 );
-
-
-  // if match then we have finished the search
-  strcpy ( expl, &tc->l[i][24] );
-  if ( nl > 1 )
-    {
-      for ( nv = 1 ; nv < nl; nv++ )
-        if ( ( strlen ( expl ) + strlen ( &tc->l[i + nv][22] ) ) < dim )
-          {
-            strcat ( expl, &tc->l[i + nv][22] );
-          }
-    }
-
-  return expl;
+  expl[0] = '\0';
+  return bufrdeco_append_tablec_line ( expl, dim, tc, i );
 }
 
 /*!
@@ -228,10 +436,8 @@ char * bufrdeco_explained_table_val ( char *expl, size_t dim, struct bufr_tablec
 char * bufrdeco_explained_flag_val ( char *expl, size_t dim, struct bufr_tablec *tc, struct bufr_descriptor *d,
                                      uint64_t ival, uint8_t nbits )
 {
-  char *c, *s;
-  uint64_t test, test0;
-  uint64_t nb, nx, v,  nl;
-  size_t i, j;
+  uint32_t v;
+  size_t i;
 
   if ( tc->wmo_table )
     {
@@ -239,105 +445,40 @@ char * bufrdeco_explained_flag_val ( char *expl, size_t dim, struct bufr_tablec
       return bufrdeco_explained_flag_csv_val ( expl, dim, tc, d, ival, nbits );
     }
 
-  // Find first line for descriptor
-  for ( i = 0; i <  tc->nlines; i++ )
+  if ( d->x > 63 || tc->dstart[d->x][d->y] == 0 )
     {
-      if ( tc->l[i][0] != d->c[0] ||
-           tc->l[i][1] != d->c[1] ||
-           tc->l[i][2] != d->c[2] ||
-           tc->l[i][3] != d->c[3] ||
-           tc->l[i][4] != d->c[4] ||
-           tc->l[i][5] != d->c[5] )
-        {
-          continue;
-        }
-      else
-        {
-          break;
-        }
+      return NULL; // descriptor not found
     }
 
-  if ( i == tc->nlines )
+  // check the amount of possible bits
+  if ( tc->l[tc->dstart[d->x][d->y] - 1][7] == ' ' )
     {
-      //printf("Descriptor %s No encontrado\n", d->c);
       return NULL;
     }
-  //printf("Descriptor %s en linea %d\n", d->c, i);
 
-  // reads the amount of possible bits
-  if ( tc->l[i][7] != ' ' )
-    {
-      nb = strtoul ( &tc->l[i][7], &c, 10 );
-    }
-  else
+  // init description
+  expl[0] = '\0';
+
+  // case 0 with meaning
+  if ( ival == 0 )
     {
-      return NULL;
+      if ( bufr_tablec_bit_lookup ( &i, tc, d->x, d->y, 0 ) == 0 )
+        {
+          bufrdeco_append_tablec_line ( expl, dim, tc, i );
+        }
+      return expl;
     }
 
-  // read a value
-  s = expl;
-  s[0] = '\0';
-
-  for ( j = 0, test0 = 1; j < nb && i < tc->nlines ; i++ )
+  // Every bit set, from the most significant (bit 1) to the less one (bit nbits)
+  for ( v = 1; v <= nbits && v < 64; v++ )
     {
-      if ( tc->l[i][12] != ' ' )
+      if ( ( ival & ( ( uint64_t ) 1 << ( nbits - v ) ) ) == 0 ||
+           bufr_tablec_bit_lookup ( &i, tc, d->x, d->y, v ) )
         {
-          v = strtol ( &tc->l[i][12], &c, 10 ); // v is the bit number
-          j++;
-
-          // case 0 with meaning
-          if ( v == 0 )
-            {
-              test0 = 1;
-              if ( ival == 0 )
-                {
-                  nl = strtoul ( &tc->l[i][21], &c, 10 );
-                  if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
-                    {
-                      s += sprintf ( s, "|" );
-                    }
-                  s += sprintf ( s,"%s", &tc->l[i][24] );
-                  if ( nl > 1 )
-                    {
-                      for ( nx = 1 ; nx < nl; nx++ )
-                        if ( ( strlen ( expl ) + strlen ( &tc->l[i + nx][22] ) )  < dim )
-                          {
-                            s += sprintf ( s, "%s", &tc->l[i + nx][22] );
-                          }
-                    }
-                  return expl;
-                }
-            }
-
-          test = test0 << ( nbits - v );
-
-          if ( v && ( test & ival ) != 0 )
-            {
-              // bit match
-              // read how many lines for the descriptors
-              nl = strtol ( &tc->l[i][21], &c, 10 );
-              if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
-                {
-                  s += sprintf ( s, "|" );
-                }
-              s += sprintf ( s,"%s", &tc->l[i][24] );
-              if ( nl > 1 )
-                {
-                  for ( nx = 1 ; nx < nl; nx++ )
-                    if ( ( strlen ( expl ) + strlen ( &tc->l[i + nx][22] ) )  < dim )
-                      {
-                        s += sprintf ( s, "%s", &tc->l[i + nx][22] );
-                      }
-                }
-
-            }
-          else
-            {
-              continue;
-            }
+          continue;
         }
+      bufrdeco_append_tablec_line ( expl, dim, tc, i );
     }
 
-  // if match then we have finished the search
   return expl;
 }
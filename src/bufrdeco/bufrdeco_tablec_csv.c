@@ -131,44 +131,32 @@ int bufr_read_tablec_csv ( struct bufr_tablec *tc, char *error )
   fclose ( t );
   tc->nlines = i;
   tc->wmo_table = 1;
+  if ( bufr_tablec_build_index ( tc ) )
+    {
+      sprintf ( error,"Too many code entries in table C file '%s'\n", tc->path );
+      return 1;
+    }
   strcpy ( tc->old_path, tc->path ); // store latest path
   return 0;
 }
 
 
 /*!
-  \fn int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tableb *tb, const char *key, uint32_t code )
+  \fn int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tablec *tc, uint16_t key, uint32_t code )
   \brief found a descriptor index in a struct \ref bufr_tablec
   \param index pointer  to a size_t where to set the result if success
-  \param tb pointer to struct \ref bufr_tableb where are stored all table B data
-  \param key descriptor string in format FXXYYY
+  \param tc pointer to struct \ref bufr_tablec where are stored all table C data
+  \param key integer key of descriptor, as returned by \ref bufr_descriptor_to_key
   \param code value to search in this table/flag
 
   Return 0 if success, 1 otherwise
 */
-int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tablec *tc, const char *key, uint32_t code )
+int bufr_find_tablec_csv_index ( size_t *index, struct bufr_tablec *tc, uint16_t key, uint32_t code )
 {
-  uint32_t ix;
-  size_t i, i0;
-  char *c;
   struct bufr_descriptor desc;
 
-  ix = strtoul ( key, &c, 10 );
-  uint32_t_to_descriptor ( &desc, ix );
-  i0 = tc->x_start[desc.x];
-  for ( i = i0 ; i < i0 + tc->num[desc.x] ; i++ )
-    {
-      if ( tc->item[i].x != desc.x )
-        {
-          return 1; // descriptor not found
-        }
-      if ( tc->item[i].y == desc.y && tc->item[i].ival == code )
-        {
-          *index = i;
-          return 0; // found
-        }
-    }
-  return 1; // not found
+  bufr_key_to_descriptor ( &desc, key );
+  return bufr_tablec_lookup ( index, tc, desc.x, desc.y, code );
 }
 
 /*!
@@ -187,13 +175,13 @@ char * bufrdeco_explained_table_csv_val ( char *expl, size_t dim, struct bufr_ta
 {
   size_t  i;
 
-  if ( bufr_find_tablec_csv_index ( &i, tc, d->c, ival ) )
+  if ( bufr_find_tablec_csv_index ( &i, tc, bufr_descriptor_to_key ( d ), ival ) )
     {
       return NULL; // descritor not found
     }
 
   // here the calling b item learn where to find first table C struct for a given x and y.
-  *index = tc->x_start[d->x] + tc->y_ref[d->x][d->y];
+  *index = tc->dstart[d->x][d->y] - 1;
 
   if ( strlen ( tc->item[i].description ) < dim )
     {
@@ -224,9 +212,8 @@ char * bufrdeco_explained_flag_csv_val ( char *expl, size_t dim, struct bufr_tab
     uint64_t ival, uint8_t nbits )
 {
   char *s;
-  uint64_t test, test0;
-  uint64_t v;
-  size_t i, j;
+  uint32_t v;
+  size_t i;
 
   if ( tc->num[d->x] == 0 )
     {
@@ -234,55 +221,36 @@ char * bufrdeco_explained_flag_csv_val ( char *expl, size_t dim, struct bufr_tab
       return NULL;
     }
 
-  // First line for descriptor
-  i = tc->x_start[d->x] + tc->y_ref[d->x][d->y];
-
   // init description
   s = expl;
   s[0] = '\0';
-  //printf ( "%ld %s %d %d %d %d\n", i, tc->item[i].key, tc->item[i].x, tc->item[i].y, d->x , d->y );
-  for ( j = 0, test0 = 1 ; j < nbits && ( tc->item[i].x == d->x ) && ( tc->item[i].y == d->y ) ; i++ )
-    {
-      v = tc->item[i].ival; // v is the bit number
-      j++;
 
-      // case 0 with meaning
-      if ( v == 0 )
+  // case 0 with meaning
+  if ( ival == 0 )
+    {
+      if ( bufr_tablec_bit_lookup ( &i, tc, d->x, d->y, 0 ) == 0 && strlen ( tc->item[i].description ) < dim )
         {
-          test0 = 1;
-          if ( ival == 0 )
-            {
-              if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
-                {
-                  s += sprintf ( s, "|" );
-                }
-              if ( strlen ( expl ) + strlen ( tc->item[i].description ) < dim )
-                {
-                  s += sprintf ( s,"%s", tc->item[i].description );
-                }
-              return expl;
-            }
+          sprintf ( s,"%s", tc->item[i].description );
         }
+      return expl;
+    }
 
-      test = test0 << ( nbits - v );
-
-      if ( v && ( test & ival ) != 0 )
+  // Every bit set, from the most significant (bit 1) to the less one (bit nbits)
+  for ( v = 1; v <= nbits && v < 64; v++ )
+    {
+      if ( ( ival & ( ( uint64_t ) 1 << ( nbits - v ) ) ) == 0 ||
+           bufr_tablec_bit_lookup ( &i, tc, d->x, d->y, v ) )
         {
-          if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
-            {
-              s += sprintf ( s, "|" );
-            }
-          if ( strlen ( expl ) + strlen ( tc->item[i].description ) < dim )
-            {
-              s += sprintf ( s,"%s", tc->item[i].description );
-            }
+          continue;
         }
-      else
+      if ( strlen ( expl ) && ( strlen ( expl ) + 1 ) < dim )
         {
-          continue;
+          s += sprintf ( s, "|" );
+        }
+      if ( strlen ( expl ) + strlen ( tc->item[i].description ) < dim )
+        {
+          s += sprintf ( s,"%s", tc->item[i].description );
         }
-      //printf ( "%s\n", expl );
     }
-  // if match then we have finished the search
   return expl;
 }
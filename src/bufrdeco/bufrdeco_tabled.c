@@ -83,105 +83,127 @@ int bufr_read_tabled ( struct bufr_tabled *td, char *error )
   fclose ( t );
   td->nlines = i;
   td->wmo_table = 0;
+  bufr_tabled_build_index ( td );
   strcpy ( td->old_path, td->path ); // store latest path
   return 0;
 }
 
 /*!
- \fn  int bufr_find_tabled_index ( size_t *index, struct bufr_tabled *td, const char *key )
+  \fn int bufr_tabled_build_index ( struct bufr_tabled *td )
+  \brief Decode the descriptors of all lines of a table D and build the index of sequences
+  \param td pointer to a target struct \ref bufr_tabled with lines already read in ECMWF format
+
+  After this, the descriptors of sequence 3 x y are the td->seq_num[x][y] structs in td->desc[] since
+  td->seq_start[x][y], so no line needs to be parsed when decoding
+
+  Returns 0
+*/
+int bufr_tabled_build_index ( struct bufr_tabled *td )
+{
+  size_t i;
+  uint32_t v, nv;
+  char aux[8], *c;
+  struct bufr_descriptor seq;
+
+  memset ( td->seq_num, 0, sizeof ( td->seq_num ) );
+  for ( i = 0; i < td->nlines; i++ )
+    {
+      v = strtoul ( & ( td->l[i][11] ), &c, 10 );
+      uint32_t_to_descriptor ( & ( td->desc[i] ), v );
+
+      // Is the first line of a sequence ?
+      if ( td->l[i][1] == ' ' || td->l[i][2] == ' ' )
+        continue;
+
+      memcpy ( aux, & ( td->l[i][1] ), 6 );
+      aux[6] = '\0';
+      uint32_t_to_descriptor ( &seq, strtoul ( aux, &c, 10 ) );
+      nv = strtoul ( & ( td->l[i][7] ), &c, 10 );
+      if ( seq.f != 3 || seq.x > 63 )
+        continue;
+      if ( ( i + nv ) > td->nlines )
+        nv = td->nlines - i;
+      td->seq_start[seq.x][seq.y] = i;
+      td->seq_num[seq.x][seq.y] = nv;
+    }
+  return 0;
+}
+
+/*!
+ \fn  int bufr_find_tabled_index ( size_t *index, struct bufr_tabled *td, uint16_t key )
  \brief Find the index of a line in table D for a given key of a descriptor
  \param index pointer where to set the result
  \param td pointer to a struct \ref bufr_tabled where all table data is stored
- \param key string in the form FXXYYY which is the key of descriptor we want to find out
+ \param key integer key of descriptor, as returned by \ref bufr_descriptor_to_key
+
+ The index of sequences built in \ref bufr_tabled_build_index is used, so no line is scanned
 
  If the descriptor has been found with success then returns 0, othewise returns 1
 */
-int bufr_find_tabled_index ( size_t *index, struct bufr_tabled *td, const char *key )
+int bufr_find_tabled_index ( size_t *index, struct bufr_tabled *td, uint16_t key )
 {
-  size_t i, i0;
-  size_t ix = 0;
-  char *c, aux[8];
-
-  aux[0] = key[1];
-  aux[1] = key[2];
-  aux[2] = '\0';
-  ix = strtoul ( aux, &c, 10 );
-  i0 = td->x_start[ix];
-  for ( i = i0 ; i < i0 + td->num[ix] ; i++ )
-    {
-      if ( td->l[i][1] != key[0] ||
-           td->l[i][2] != key[1] ||
-           td->l[i][3] != key[2] ||
-           td->l[i][4] != key[3] ||
-           td->l[i][5] != key[4] ||
-           td->l[i][6] != key[5] )
-        {
-          continue;
-        }
-      else
-        {
-          *index = i;
-          return 0;
-        }
-    }
-  return 1; // not found
+  struct bufr_descriptor desc;
+
+  bufr_key_to_descriptor ( &desc, key );
+  if ( desc.f != 3 || td->seq_num[desc.x][desc.y] == 0 )
+    return 1; // not found
+
+  *index = td->seq_start[desc.x][desc.y];
+  return 0;
 }
 
 
 /*!
- \fn int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, const char *key )
+ \fn int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, uint16_t key )
  \brief get the descriptors array for a descriptor sequence defined in table D with F = 3
  \param s target struct \ref bufr_sequence
  \param b pointer to the basic container struct \ref bufrdeco
- \param key string in the form FXXYYY which is the key of descriptor we want to find out, F = 3
+ \param key integer key of descriptor, as returned by \ref bufr_descriptor_to_key, F = 3
 
  If the sequence has been filled with success then returns 0, otherwise returns 1
 */
-int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, const char *key )
+int bufrdeco_tabled_get_descriptors_array ( struct bufr_sequence *s, struct bufrdeco *b, uint16_t key )
 {
-  size_t i, j;
-  uint32_t nv, v;
-  char *c;
+  size_t i, nv;
+  char aux[8];
   struct bufr_tabled *td;
 
   td = & ( b->tables->d );
 
   // Reject wrong arguments
-  if ( s == NULL || b == NULL || key == NULL )
+  if ( s == NULL || b == NULL )
     {
       sprintf ( b->error,"bufrdeco_tabled_get_descritors_array(): Wrong entry arguments\n" );
       return 1;
     }
 
-  // here the calling b item learn where to find table C line
-
+  // The index of sequences gives directly where the descriptors are
   if ( bufr_find_tabled_index ( &i, td, key ) )
     {
-      sprintf ( b->error, "bufrdeco_tabled_val(): descriptor '%s' not found in table D\n", key );
+      sprintf ( b->error, "bufrdeco_tabled_val(): descriptor '%s' not found in table D\n", bufr_key_to_string ( aux, key ) );
       return 1; // descritor not found
     }
+  nv = td->seq_num[ ( key >> 8 ) & 0x3f][key & 0xff];
+  if ( nv > NMAXSEQ_DESCRIPTORS )
+    {
+      sprintf ( b->error, "bufrdeco_tabled_get_descritors_array(): Too much descriptors in sequence '%s'\n",
+                bufr_key_to_string ( aux, key ) );
+      return 1;
+    }
 
   // Get the name of common sequence
-  if (td->item[i].description[0])
-     strcpy(s->name, td->item[i].description);
+  if ( td->item[i].description[0] )
+    strcpy ( s->name, td->item[i].description );
   else
-     s->name[0] = 0;
-  
-  // reads the amount of possible values
-  nv = strtoul ( &td->l[i][7], &c, 10 );
+    s->name[0] = 0;
 
   // s->level must be set by caller
   // s->father must be set by caller
 
-  s->ndesc = 0;
+  // copy all descriptors, already decoded
+  memcpy ( s->lseq, & ( td->desc[i] ), nv * sizeof ( struct bufr_descriptor ) );
+  s->ndesc = nv;
 
-  // read all descriptors
-  for ( j = 0; j < nv && ( i + j ) < td->nlines ; j++ )
-    {
-      v = strtoul ( & ( td->l[i+j][11] ), &c, 10 );
-      uint32_t_to_descriptor ( & ( s->lseq[j] ), v );
-      ( s->ndesc ) ++;
-    }
   // s->sons are not set here
   return 0;
 }
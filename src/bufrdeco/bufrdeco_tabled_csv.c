@@ -151,6 +151,7 @@ int bufr_read_tabled_csv ( struct bufr_tabled *td, char *error )
     printf ( "%s\n", td->l[kk] );*/
   td->nlines = i;
   td->wmo_table = 1;
+  bufr_tabled_build_index ( td );
   strcpy ( td->old_path, td->path ); // store latest path
   return 0;
 }
@@ -0,0 +1,253 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_tables_cache.c
+ \brief This file has the code of the process-wide cache of loaded tables
+
+ When decoding files with messages of several master table versions, every change of version
+ forces to read and parse again the table files. Here several sets of tables are kept in
+ memory, keyed by the pathnames of the table files, until a memory budget is reached. Then the
+ least recently used set is released.
+
+ The cached tables are shared by reference count (see \ref bufrdeco_share_tables), so the cache
+ can be used by several decoders in different threads.
+*/
+#include "bufrdeco.h"
+
+/*!
+  The cache of tables. It is used by all struct \ref bufrdeco in the process
+*/
+static struct bufrdeco_tables_cache BUFRDECO_TABLES_CACHE = { .budget = BUFRDECO_TABLES_CACHE_BUDGET };
+
+/*!
+  \fn static void bufrdeco_tables_cache_lock ( void )
+  \brief Get the lock of the cache. Critical sections are short, so we just spin
+*/
+static void bufrdeco_tables_cache_lock ( void )
+{
+  while ( __sync_lock_test_and_set ( &BUFRDECO_TABLES_CACHE.lock, 1 ) )
+    ;
+}
+
+/*!
+  \fn static void bufrdeco_tables_cache_unlock ( void )
+  \brief Release the lock of the cache
+*/
+static void bufrdeco_tables_cache_unlock ( void )
+{
+  __sync_lock_release ( &BUFRDECO_TABLES_CACHE.lock );
+}
+
+/*!
+  \fn static void bufrdeco_tables_cache_evict ( size_t budget )
+  \brief Release the least recently used sets of tables until the memory used is in \a budget
+  \param budget max amount of memory in bytes
+
+  The lock must be got by caller
+*/
+static void bufrdeco_tables_cache_evict ( size_t budget )
+{
+  size_t i, lru;
+  struct bufrdeco_tables_cache *c = &BUFRDECO_TABLES_CACHE;
+
+  while ( c->nt && ( c->nt * sizeof ( struct bufr_tables ) > budget || c->nt == BUFRDECO_TABLES_CACHE_SIZE ) )
+    {
+      for ( i = 1, lru = 0; i < c->nt; i++ )
+        {
+          if ( c->entry[i].last_use < c->entry[lru].last_use )
+            lru = i;
+        }
+      // The memory is freed when no decoder is using these tables
+      bufrdeco_free_tables ( & ( c->entry[lru].t ) );
+      c->entry[lru] = c->entry[c->nt - 1];
+      c->nt--;
+    }
+}
+
+/*!
+  \fn struct bufr_tables * bufrdeco_tables_cache_get ( const char *pathb, const char *pathc, const char *pathd )
+  \brief Search a set of tables in cache
+  \param pathb pathname of table B file
+  \param pathc pathname of table C file
+  \param pathd pathname of table D file
+
+  If found, a reference is added to the tables, so the caller must release it with \ref bufrdeco_free_tables
+  (as done in \ref bufrdeco_close)
+
+  Returns a pointer to the tables if found, NULL otherwise
+*/
+struct bufr_tables * bufrdeco_tables_cache_get ( const char *pathb, const char *pathc, const char *pathd )
+{
+  size_t i;
+  struct bufr_tables *t = NULL;
+  struct bufrdeco_tables_cache *c = &BUFRDECO_TABLES_CACHE;
+
+  bufrdeco_tables_cache_lock ();
+  for ( i = 0; i < c->nt; i++ )
+    {
+      if ( bufrdeco_tables_loaded ( c->entry[i].t, pathb, pathc, pathd ) )
+        {
+          t = c->entry[i].t;
+          __sync_add_and_fetch ( & ( t->refcount ), 1 );
+          c->entry[i].last_use = ++ ( c->clock );
+          break;
+        }
+    }
+  if ( t == NULL )
+    c->nmiss++;
+  else
+    c->nhits++;
+  bufrdeco_tables_cache_unlock ();
+  return t;
+}
+
+/*!
+  \fn int bufrdeco_tables_cache_add ( struct bufr_tables *t )
+  \brief Add a set of loaded tables to cache
+  \param t pointer to the struct \ref bufr_tables
+
+  The cache adds a reference to the tables. If needed, other tables are released to keep
+  the memory used in budget.
+
+  Returns 0 if the tables has been added, 1 otherwise
+*/
+int bufrdeco_tables_cache_add ( struct bufr_tables *t )
+{
+  size_t i;
+  struct bufrdeco_tables_cache *c = &BUFRDECO_TABLES_CACHE;
+
+  if ( t == NULL || c->budget < sizeof ( struct bufr_tables ) )
+    return 1;
+
+  bufrdeco_tables_cache_lock ();
+
+  // Maybe already there
+  for ( i = 0; i < c->nt; i++ )
+    {
+      if ( c->entry[i].t == t ||
+           bufrdeco_tables_loaded ( c->entry[i].t, t->b.old_path, t->c.old_path, t->d.old_path ) )
+        {
+          bufrdeco_tables_cache_unlock ();
+          return 1;
+        }
+    }
+
+  // Make room for a new set
+  bufrdeco_tables_cache_evict ( c->budget - sizeof ( struct bufr_tables ) );
+
+  __sync_add_and_fetch ( & ( t->refcount ), 1 );
+  c->entry[c->nt].t = t;
+  c->entry[c->nt].last_use = ++ ( c->clock );
+  c->nt++;
+  bufrdeco_tables_cache_unlock ();
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tables_cache_set_budget ( size_t budget )
+  \brief Set the max amount of memory used by tables in cache
+  \param budget max amount of memory in bytes. If 0 the cache is not used
+
+  Every set of tables needs sizeof(struct \ref bufr_tables) bytes. The default is \ref BUFRDECO_TABLES_CACHE_BUDGET
+
+  Returns 0
+*/
+int bufrdeco_tables_cache_set_budget ( size_t budget )
+{
+  bufrdeco_tables_cache_lock ();
+  BUFRDECO_TABLES_CACHE.budget = budget;
+  bufrdeco_tables_cache_evict ( budget );
+  bufrdeco_tables_cache_unlock ();
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tables_cache_clear ( void )
+  \brief Release all tables in cache
+
+  The budget is not changed. The tables still used by any decoder are freed when it calls \ref bufrdeco_close
+
+  Returns 0
+*/
+int bufrdeco_tables_cache_clear ( void )
+{
+  bufrdeco_tables_cache_lock ();
+  bufrdeco_tables_cache_evict ( 0 );
+  bufrdeco_tables_cache_unlock ();
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_use_cached_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+  \brief Set in a struct \ref bufrdeco the tables from cache, if found
+  \param b pointer to the target struct \ref bufrdeco
+  \param pathb pathname of table B file
+  \param pathc pathname of table C file
+  \param pathd pathname of table D file
+
+  Returns 1 if the tables were in cache and now are used by \a b, 0 otherwise
+*/
+int bufrdeco_use_cached_tables ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+{
+  struct bufr_tables *t;
+
+  if ( BUFRDECO_TABLES_CACHE.budget == 0 )
+    return 0;
+
+  if ( ( t = bufrdeco_tables_cache_get ( pathb, pathc, pathd ) ) == NULL )
+    return 0;
+
+  // The reference got from cache is now owned by b
+  bufrdeco_free_tables ( & ( b->tables ) );
+  b->tables = t;
+  return 1;
+}
+
+/*!
+  \fn int bufrdeco_resolve_tables_dir ( struct bufrdeco *b, const char *dir1, const char *dir2 )
+  \brief Set the directory of table files if not set by caller
+  \param b pointer to the target struct \ref bufrdeco
+  \param dir1 first default directory to try
+  \param dir2 second default directory to try
+
+  The directory found is kept in b->bufrtables_dir, so this is done only once
+
+  Returns 0 if there is a directory for tables, 1 otherwise
+*/
+int bufrdeco_resolve_tables_dir ( struct bufrdeco *b, const char *dir1, const char *dir2 )
+{
+  struct stat st;
+
+  if ( b->bufrtables_dir[0] )
+    return 0;
+
+  // try to guess directory
+  if ( stat ( dir1, &st ) == 0 && S_ISDIR ( st.st_mode ) )
+    {
+      strcpy ( b->bufrtables_dir, dir1 );
+      return 0;
+    }
+  if ( stat ( dir2, &st ) == 0 && S_ISDIR ( st.st_mode ) )
+    {
+      strcpy ( b->bufrtables_dir, dir2 );
+      return 0;
+    }
+  return 1;
+}
@@ -0,0 +1,205 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_tables_image.c
+ \brief This file has the code to write and map binary images of tables
+
+ Reading and parsing the csv table files needs some milliseconds for every set of tables. A binary
+ image is a copy of the struct \ref bufr_tables with all indexes already built, written by
+ build_bufrdeco_tables, which just needs to be mapped in memory. As the image is mapped privately, all
+ the processes using it share the same copy in page cache.
+
+ For WMO table files BUFR_XX_Y_Z_TableB_en.csv the image is BUFR_XX_Y_Z_Tables_en.bin in the same
+ directory. It can be built with
+
+ \code
+ build_bufrdeco_tables -t I -i BUFR_XX_Y_Z_TableB_en.csv > BUFR_XX_Y_Z_Tables_en.bin
+ \endcode
+
+ An image older than any of its csv files is ignored.
+*/
+#include "bufrdeco.h"
+
+/*!
+  \fn int bufrdeco_tables_image_path ( char *image, const char *pathb )
+  \brief Get the pathname of the binary image of tables for a table B file
+  \param image string where to set the result
+  \param pathb pathname of a WMO csv table B file
+
+  Returns 0 if all is OK, 1 if there is not an image name for \a pathb
+*/
+int bufrdeco_tables_image_path ( char *image, const char *pathb )
+{
+  char *c, *e;
+
+  if ( strlen ( pathb ) >= 256 )
+    return 1;
+
+  strcpy ( image, pathb );
+  if ( ( c = strrchr ( image, '/' ) ) == NULL )
+    c = image;
+
+  if ( ( c = strstr ( c, "TableB" ) ) == NULL || ( e = strrchr ( c, '.' ) ) == NULL )
+    return 1;
+
+  c[5] = 's'; // TableB -> Tables
+  strcpy ( e, ".bin" );
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_write_tables_image ( struct bufr_tables *t, FILE *f, char *error )
+  \brief Write a binary image of a struct \ref bufr_tables
+  \param t pointer to the struct \ref bufr_tables with all tables already loaded
+  \param f pointer to the opened file where to write
+  \param error string where to set the error, if any
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrdeco_write_tables_image ( struct bufr_tables *t, FILE *f, char *error )
+{
+  int refcount;
+  struct bufrdeco_input_map image;
+  struct bufrdeco_tables_image_header h;
+
+  memset ( &h, 0, sizeof ( struct bufrdeco_tables_image_header ) );
+  memcpy ( h.magic, BUFRDECO_TABLES_IMAGE_MAGIC, sizeof ( h.magic ) );
+  h.version = BUFRDECO_TABLES_IMAGE_VERSION;
+  h.endian = 0x01020304;
+  h.size = sizeof ( struct bufr_tables );
+
+  // The fields only meaningful in memory are written as 0
+  refcount = t->refcount;
+  image = t->image;
+  t->refcount = 0;
+  memset ( & ( t->image ), 0, sizeof ( struct bufrdeco_input_map ) );
+
+  if ( fwrite ( &h, sizeof ( struct bufrdeco_tables_image_header ), 1, f ) != 1 ||
+       fwrite ( t, sizeof ( struct bufr_tables ), 1, f ) != 1 )
+    {
+      sprintf ( error, "bufrdeco_write_tables_image(): Cannot write the image of tables\n" );
+      t->refcount = refcount;
+      t->image = image;
+      return 1;
+    }
+
+  t->refcount = refcount;
+  t->image = image;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_map_tables_image ( struct bufr_tables **t, const char *image, char *error )
+  \brief Map a binary image of tables in memory
+  \param t pointer to the pointer where to set the mapped struct \ref bufr_tables
+  \param image pathname of the image file
+  \param error string where to set the error, if any
+
+  The mapped tables are released with \ref bufrdeco_free_tables
+
+  Returns 0 if all is OK, 1 otherwise
+*/
+int bufrdeco_map_tables_image ( struct bufr_tables **t, const char *image, char *error )
+{
+  int fd;
+  struct stat st;
+  void *m;
+  struct bufrdeco_tables_image_header *h;
+  size_t len = sizeof ( struct bufrdeco_tables_image_header ) + sizeof ( struct bufr_tables );
+
+  if ( ( fd = open ( image, O_RDONLY ) ) < 0 )
+    {
+      sprintf ( error, "bufrdeco_map_tables_image(): Cannot open '%s'\n", image );
+      return 1;
+    }
+
+  if ( fstat ( fd, &st ) < 0 || ( size_t ) st.st_size != len )
+    {
+      sprintf ( error, "bufrdeco_map_tables_image(): Bad size of image '%s'\n", image );
+      close ( fd );
+      return 1;
+    }
+
+  // Private, so the few fields written when using the tables do not change the file
+  m = mmap ( NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+  close ( fd );
+  if ( m == MAP_FAILED )
+    {
+      sprintf ( error, "bufrdeco_map_tables_image(): Cannot map '%s'\n", image );
+      return 1;
+    }
+
+  h = ( struct bufrdeco_tables_image_header * ) m;
+  if ( memcmp ( h->magic, BUFRDECO_TABLES_IMAGE_MAGIC, sizeof ( h->magic ) ) ||
+       h->version != BUFRDECO_TABLES_IMAGE_VERSION || h->endian != 0x01020304 ||
+       h->size != sizeof ( struct bufr_tables ) )
+    {
+      sprintf ( error, "bufrdeco_map_tables_image(): '%s' is not a valid image for this version\n", image );
+      munmap ( m, len );
+      return 1;
+    }
+
+  *t = ( struct bufr_tables * ) ( ( uint8_t * ) m + sizeof ( struct bufrdeco_tables_image_header ) );
+  ( *t )->refcount = 1;
+  ( *t )->image.addr = ( uint8_t * ) m;
+  ( *t )->image.len = len;
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_load_tables_image ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+  \brief Set in a struct \ref bufrdeco the tables from a binary image, if there is a valid one
+  \param b pointer to the target struct \ref bufrdeco
+  \param pathb pathname of table B file
+  \param pathc pathname of table C file
+  \param pathd pathname of table D file
+
+  Returns 0 if the tables has been loaded from an image, 1 otherwise
+*/
+int bufrdeco_load_tables_image ( struct bufrdeco *b, const char *pathb, const char *pathc, const char *pathd )
+{
+  char image[256], error[512];
+  struct stat sti, st;
+  struct bufr_tables *t = NULL;
+
+  if ( bufrdeco_tables_image_path ( image, pathb ) || stat ( image, &sti ) )
+    return 1;
+
+  // Do not use an image older than any of the table files
+  if ( ( stat ( pathb, &st ) == 0 && st.st_mtime > sti.st_mtime ) ||
+       ( stat ( pathc, &st ) == 0 && st.st_mtime > sti.st_mtime ) ||
+       ( stat ( pathd, &st ) == 0 && st.st_mtime > sti.st_mtime ) )
+    return 1;
+
+  // If the image is not valid we just read the table files
+  if ( bufrdeco_map_tables_image ( &t, image, error ) )
+    return 1;
+
+  strcpy ( t->b.path, pathb );
+  strcpy ( t->b.old_path, pathb );
+  strcpy ( t->c.path, pathc );
+  strcpy ( t->c.old_path, pathc );
+  strcpy ( t->d.path, pathd );
+  strcpy ( t->d.old_path, pathd );
+
+  bufrdeco_free_tables ( & ( b->tables ) );
+  b->tables = t;
+  return 0;
+}
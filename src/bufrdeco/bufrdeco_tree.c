@@ -46,24 +46,25 @@ int get_unexpanded_descriptor_array_from_sec3 ( struct bufr_sequence *s, struct
 
 
 /*!
-  \fn int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *father,  const char *key )
+  \fn int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *father, const struct bufr_descriptor *key )
   \brief Parse the descriptor tree in a recursive way
-  \param key string with descriptor in form 'FXXYYY'
+  \param key pointer to the struct \ref bufr_descriptor of the sequence. NULL for the main sequence in sec3
   \param father pointer to the father struct \ref bufr_sequence
   \param b pointer to the base struct \ref bufrdeco
 
   Returns 0 if success, 1 otherwise
  */
-int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *father,  const char *key )
+int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *father, const struct bufr_descriptor *key )
 {
   size_t i, nl;
   struct bufr_sequence *l;
 
   if ( key == NULL )
     {
-      memset ( b->tree, 0, sizeof ( struct bufrdeco_expanded_tree ) );
+      // Every member of used sequences is set here, so the tree is not cleared
       // case first layer
       b->tree->nseq = 1;
+      b->tree->bitmap_operators = 0;
       l = & ( b->tree->seq[0] );
       strcpy ( l->key, "000000" );
       l->level = 0;
@@ -90,13 +91,13 @@ int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *fa
         }
       nl = b->tree->nseq;
       l = & ( b->tree->seq[nl - 1] );
-      strcpy ( l->key, key );
+      bufr_descriptor_to_string ( l->key, key );
       l->level = father->level + 1;
       l->father = father;
       l->iseq = nl - 1;
       //printf ("level=%lu ", l->level);
       // here we get ndesc and lsec array from table d
-      if ( bufrdeco_tabled_get_descriptors_array ( l, b, key ) )
+      if ( bufrdeco_tabled_get_descriptors_array ( l, b, bufr_descriptor_to_key ( key ) ) )
         {
           return 1; // something went wrong
         }
@@ -105,6 +106,12 @@ int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *fa
   // now we detect sons and go to parse them
   for ( i = 0; i < l->ndesc ; i++ )
     {
+      // Operators using bitmaps
+      if ( l->lseq[i].f == 2 && l->lseq[i].x >= 22 && l->lseq[i].x <= 37 )
+        {
+          b->tree->bitmap_operators = 1;
+        }
+
       // we search for descriptors with f == 3
       if ( l->lseq[i].f != 3 )
         {
@@ -113,7 +120,7 @@ int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *fa
         }
       l->sons[i] = & ( b->tree->seq[b->tree->nseq] );
       // we then recursively parse the son
-      if ( bufrdeco_parse_tree_recursive ( b, l, l->lseq[i].c ) )
+      if ( bufrdeco_parse_tree_recursive ( b, l, & ( l->lseq[i] ) ) )
         {
           return 1;
         }
@@ -145,11 +152,210 @@ int bufrdeco_parse_tree_recursive ( struct bufrdeco *b, struct bufr_sequence *fa
 
   And so we go in a recursive way up to the end.
 
+  Messages with the same descriptors in sec3 and tables share the same tree, taken from the cache of
+  trees (see \ref bufrdeco_tree_cache_get). So the tree, and its plan to decode subsets compiled with
+  \ref bufrdeco_compile_plan, are only built for new templates. The tree also
+  knows the memory used by prior messages, so the working memory is sized here (see \ref bufrdeco_prepare_arena).
+
   If success return 0, if something went wrong return 1
 */
 int bufrdeco_parse_tree ( struct bufrdeco *b )
 {
+  struct bufrdeco_expanded_tree *t;
+
+  // Already parsed for another message
+  if ( ( t = bufrdeco_tree_cache_get ( b ) ) != NULL )
+    {
+      bufrdeco_free_expanded_tree ( & ( b->tree ) );
+      b->tree = t;
+      bufrdeco_prepare_arena ( b );
+      return 0;
+    }
+
+  // We need a private tree to build. A shared one is never changed
+  if ( b->tree == NULL || __atomic_load_n ( & ( b->tree->refcount ), __ATOMIC_ACQUIRE ) > 1 )
+    {
+      if ( bufrdeco_init_expanded_tree ( & ( b->tree ) ) )
+        {
+          sprintf ( b->error,"bufrdeco_parse_tree(): Cannot allocate space for expanded tree of descriptors\n" );
+          return 1;
+        }
+    }
+
   // here we start the parse
-  return  bufrdeco_parse_tree_recursive ( b, NULL, NULL );
+  if ( bufrdeco_parse_tree_recursive ( b, NULL, NULL ) )
+    {
+      return 1;
+    }
+  bufrdeco_compile_plan ( b );
+
+  // Keep it for other messages
+  bufrdeco_tree_cache_add ( b );
+  bufrdeco_prepare_arena ( b );
+  return 0;
+}
+
+
+/*!
+  \fn static struct bufr_plan_op * bufrdeco_plan_add ( struct bufr_plan *p, uint8_t op, struct bufr_sequence *l, size_t k, uint8_t replicated, struct bufrdeco *b )
+  \brief Add an instruction to a compiled plan
+  \param p pointer to the target struct \ref bufr_plan
+  \param op the instruction, as \ref BUFR_PLAN_VALUE ...
+  \param l pointer to the struct \ref bufr_sequence with the descriptor
+  \param k index of descriptor in \a l->lseq[]
+  \param replicated 1 if the descriptor is a member of a replication, 0 if member of a sequence
+  \param b pointer to the base struct \ref bufrdeco
+
+  For \ref BUFR_PLAN_VALUE and \ref BUFR_PLAN_DELAYED the data of descriptor in table B are also set. Local
+  descriptors and those not found in table B have kind 0.
+
+  Returns a pointer to the instruction, NULL if there is no room for it
+*/
+static struct bufr_plan_op * bufrdeco_plan_add ( struct bufr_plan *p, uint8_t op, struct bufr_sequence *l, size_t k,
+    uint8_t replicated, struct bufrdeco *b )
+{
+  size_t i;
+  struct bufr_plan_op *o;
+  struct bufr_tableb *tb = & ( b->tables->b );
+
+  if ( p->n >= BUFR_MAX_PLAN_OPS )
+    {
+      return NULL;
+    }
+
+  o = & ( p->op[p->n++] );
+  memset ( o, 0, sizeof ( struct bufr_plan_op ) );
+  o->op = op;
+  o->seq = l;
+  o->ns = k;
+  o->replicated = replicated;
+  if ( ( op == BUFR_PLAN_VALUE || op == BUFR_PLAN_DELAYED ) && is_a_local_descriptor ( & ( l->lseq[k] ) ) == 0 &&
+       bufr_find_tableb_index ( &i, tb, bufr_descriptor_to_key ( & ( l->lseq[k] ) ) ) == 0 )
+    {
+      o->tableb = i;
+      o->kind = tb->item[i].kind;
+      o->nbits = tb->item[i].nbits;
+      o->scale = tb->item[i].scale;
+      o->reference = tb->item[i].reference;
+      o->factor = tb->item[i].factor;
+    }
+  return o;
 }
 
+/*!
+  \fn static int bufrdeco_compile_plan_recursive ( struct bufr_plan *p, struct bufr_sequence *l, size_t i0, size_t n, uint8_t replicated, size_t depth, struct bufrdeco *b )
+  \brief Compile some descriptors of a sequence in a recursive way
+  \param p pointer to the target struct \ref bufr_plan
+  \param l pointer to the source struct \ref bufr_sequence
+  \param i0 index of first descriptor in \a l->lseq[] to compile
+  \param n amount of descriptors to compile
+  \param replicated 1 if the descriptors are members of a replication, 0 if members of a sequence
+  \param depth nesting level of sequences and replications
+  \param b pointer to the base struct \ref bufrdeco
+
+  Sequences are expanded in place. Every replication is a loop instruction, the instructions of the replicated
+  descriptors and a \ref BUFR_PLAN_END which jumps back to the loop.
+
+  Returns 0 if success, 1 if the descriptors cannot be compiled
+*/
+static int bufrdeco_compile_plan_recursive ( struct bufr_plan *p, struct bufr_sequence *l, size_t i0, size_t n,
+    uint8_t replicated, size_t depth, struct bufrdeco *b )
+{
+  size_t i, loop, ndesc;
+  struct bufr_plan_op *o;
+
+  if ( ( i0 + n ) > l->ndesc || depth >= BUFR_MAX_PLAN_DEPTH )
+    {
+      return 1;
+    }
+
+  for ( i = i0; i < ( i0 + n ); i++ )
+    {
+      switch ( l->lseq[i].f )
+        {
+        case 0:
+          if ( bufrdeco_plan_add ( p, BUFR_PLAN_VALUE, l, i, replicated, b ) == NULL )
+            {
+              return 1;
+            }
+          break;
+
+        case 1:
+          ndesc = l->lseq[i].x;
+          loop = p->n;
+          if ( l->lseq[i].y != 0 )
+            {
+              if ( ( o = bufrdeco_plan_add ( p, BUFR_PLAN_REPLICATE, l, i, replicated, b ) ) == NULL )
+                {
+                  return 1;
+                }
+              o->n = l->lseq[i].y;
+            }
+          else
+            {
+              // case of delayed. The factor is the next descriptor
+              i++;
+              if ( i >= l->ndesc || bufrdeco_plan_add ( p, BUFR_PLAN_DELAYED, l, i, replicated, b ) == NULL )
+                {
+                  return 1;
+                }
+            }
+          if ( bufrdeco_compile_plan_recursive ( p, l, i + 1, ndesc, 1, depth + 1, b ) ||
+               ( o = bufrdeco_plan_add ( p, BUFR_PLAN_END, l, i, 1, b ) ) == NULL )
+            {
+              return 1;
+            }
+          o->jump = loop;
+          p->op[loop].jump = p->n - 1;
+          i += ndesc;
+          break;
+
+        case 2:
+          if ( bufrdeco_plan_add ( p, BUFR_PLAN_OPERATOR, l, i, replicated, b ) == NULL )
+            {
+              return 1;
+            }
+          break;
+
+        case 3:
+          if ( l->sons[i] == NULL ||
+               bufrdeco_compile_plan_recursive ( p, l->sons[i], 0, l->sons[i]->ndesc, 0, depth + 1, b ) )
+            {
+              return 1;
+            }
+          break;
+
+        default:
+          return 1;
+        }
+    }
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_compile_plan ( struct bufrdeco *b )
+  \brief Compile the tree of descriptors into a flat list of instructions to decode non compressed subsets
+  \param b pointer to the base struct \ref bufrdeco with the tree just parsed
+
+  Every table B descriptor is an instruction with its width, scale, reference and kind of value. Replications are
+  loops and operators are instructions run by \ref bufrdeco_parse_f2_descriptor. The plan is run for every subset
+  by \ref bufrdeco_decode_subset_data_plan and it is kept in the tree, so it is cached with it.
+
+  Trees with operators using bitmaps are not compiled, as their data are linked while walking the tree. Neither are
+  those too big or too deep. Their subsets are decoded by \ref bufrdeco_decode_subset_data_recursive.
+
+  Returns 0 if the plan is compiled, 1 otherwise. Then \a b->tree->plan.n is 0
+*/
+int bufrdeco_compile_plan ( struct bufrdeco *b )
+{
+  struct bufr_plan *p = & ( b->tree->plan );
+
+  p->n = 0;
+  if ( b->tree->bitmap_operators ||
+       bufrdeco_compile_plan_recursive ( p, & ( b->tree->seq[0] ), 0, b->tree->seq[0].ndesc, 0, 0, b ) )
+    {
+      p->n = 0;
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,252 @@
+/***************************************************************************
+ *   Copyright (C) 2013-2018 by Guillermo Ballester Valor                  *
+ *   gbv@ogimet.com                                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/*!
+ \file bufrdeco_tree_cache.c
+ \brief This file has the code of the process-wide cache of parsed descriptor trees
+
+ Most of messages use a few templates, i.e. the same unexpanded descriptors in sec3. Parsing the
+ tree of such a template always gives the same result for the same tables B and D (the plan compiled
+ from the tree has the data of table B of its descriptors), so the trees are kept here and shared by
+ reference count among messages and decoders.
+*/
+#include "bufrdeco.h"
+
+/*!
+  The cache of trees. It is used by all struct \ref bufrdeco in the process
+*/
+static struct bufrdeco_tree_cache BUFRDECO_TREE_CACHE = { .budget = BUFRDECO_TREE_CACHE_BUDGET };
+
+/*!
+  \fn static void bufrdeco_tree_cache_lock ( void )
+  \brief Get the lock of the cache. Critical sections are short, so we just spin
+*/
+static void bufrdeco_tree_cache_lock ( void )
+{
+  while ( __sync_lock_test_and_set ( &BUFRDECO_TREE_CACHE.lock, 1 ) )
+    ;
+}
+
+/*!
+  \fn static void bufrdeco_tree_cache_unlock ( void )
+  \brief Release the lock of the cache
+*/
+static void bufrdeco_tree_cache_unlock ( void )
+{
+  __sync_lock_release ( &BUFRDECO_TREE_CACHE.lock );
+}
+
+/*!
+  \fn static uint32_t bufrdeco_tree_cache_hash ( struct bufrdeco *b )
+  \brief Returns the hash (FNV-1a) of the unexpanded descriptors in sec3 and the paths of tables B and D
+  \param b pointer to the struct \ref bufrdeco with sec3 already read
+*/
+static uint32_t bufrdeco_tree_cache_hash ( struct bufrdeco *b )
+{
+  size_t i;
+  uint16_t key;
+  uint32_t h = 2166136261U;
+  const char *c;
+
+  for ( i = 0; i < b->sec3.ndesc; i++ )
+    {
+      key = bufr_descriptor_to_key ( & ( b->sec3.unexpanded[i] ) );
+      h = ( h ^ ( key >> 8 ) ) * 16777619U;
+      h = ( h ^ ( key & 0xff ) ) * 16777619U;
+    }
+  for ( c = b->tables->b.old_path; *c; c++ )
+    {
+      h = ( h ^ ( uint8_t ) *c ) * 16777619U;
+    }
+  // A separator, so the pair of paths is not ambiguous
+  h = ( h ^ 0xff ) * 16777619U;
+  for ( c = b->tables->d.old_path; *c; c++ )
+    {
+      h = ( h ^ ( uint8_t ) *c ) * 16777619U;
+    }
+  return h;
+}
+
+/*!
+  \fn static int bufrdeco_tree_cache_match ( struct bufrdeco_tree_cache_entry *e, struct bufrdeco *b, uint32_t hash )
+  \brief Check if a tree in cache is the one for the current message in a struct \ref bufrdeco
+  \param e pointer to the entry in cache
+  \param b pointer to the struct \ref bufrdeco with sec3 already read
+  \param hash hash for \a b as returned by \ref bufrdeco_tree_cache_hash
+
+  Returns 1 if match, 0 otherwise
+*/
+static int bufrdeco_tree_cache_match ( struct bufrdeco_tree_cache_entry *e, struct bufrdeco *b, uint32_t hash )
+{
+  struct bufr_sequence *l = & ( e->t->seq[0] );
+
+  return e->hash == hash && l->ndesc == b->sec3.ndesc &&
+         memcmp ( l->lseq, b->sec3.unexpanded, l->ndesc * sizeof ( struct bufr_descriptor ) ) == 0 &&
+         strcmp ( e->pathd, b->tables->d.old_path ) == 0 && strcmp ( e->pathb, b->tables->b.old_path ) == 0;
+}
+
+/*!
+  \fn static void bufrdeco_tree_cache_evict ( size_t budget )
+  \brief Release the least recently used trees until the memory used is in \a budget
+  \param budget max amount of memory in bytes
+
+  The lock must be got by caller
+*/
+static void bufrdeco_tree_cache_evict ( size_t budget )
+{
+  size_t i, lru;
+  struct bufrdeco_tree_cache *c = &BUFRDECO_TREE_CACHE;
+
+  while ( c->nt && ( c->nt * sizeof ( struct bufrdeco_expanded_tree ) > budget || c->nt == BUFRDECO_TREE_CACHE_SIZE ) )
+    {
+      for ( i = 1, lru = 0; i < c->nt; i++ )
+        {
+          if ( c->entry[i].last_use < c->entry[lru].last_use )
+            lru = i;
+        }
+      // The memory is freed when no decoder is using this tree
+      bufrdeco_free_expanded_tree ( & ( c->entry[lru].t ) );
+      c->entry[lru] = c->entry[c->nt - 1];
+      c->nt--;
+    }
+}
+
+/*!
+  \fn struct bufrdeco_expanded_tree * bufrdeco_tree_cache_get ( struct bufrdeco *b )
+  \brief Search in cache the tree of descriptors for the current message in a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco with sec3 and tables already read
+
+  If found, a reference is added to the tree, so the caller must release it with \ref bufrdeco_free_expanded_tree
+  (as done in \ref bufrdeco_reset and \ref bufrdeco_close). The tree must not be changed.
+
+  Returns a pointer to the tree if found, NULL otherwise
+*/
+struct bufrdeco_expanded_tree * bufrdeco_tree_cache_get ( struct bufrdeco *b )
+{
+  size_t i;
+  uint32_t hash;
+  struct bufrdeco_expanded_tree *t = NULL;
+  struct bufrdeco_tree_cache *c = &BUFRDECO_TREE_CACHE;
+
+  if ( c->budget == 0 || b->tables == NULL )
+    return NULL;
+
+  hash = bufrdeco_tree_cache_hash ( b );
+
+  bufrdeco_tree_cache_lock ();
+  for ( i = 0; i < c->nt; i++ )
+    {
+      if ( bufrdeco_tree_cache_match ( & ( c->entry[i] ), b, hash ) )
+        {
+          t = c->entry[i].t;
+          __sync_add_and_fetch ( & ( t->refcount ), 1 );
+          c->entry[i].last_use = ++ ( c->clock );
+          break;
+        }
+    }
+  if ( t == NULL )
+    c->nmiss++;
+  else
+    c->nhits++;
+  bufrdeco_tree_cache_unlock ();
+  return t;
+}
+
+/*!
+  \fn int bufrdeco_tree_cache_add ( struct bufrdeco *b )
+  \brief Add to cache the tree just parsed in a struct \ref bufrdeco
+  \param b pointer to the struct \ref bufrdeco
+
+  The cache adds a reference to the tree, which is shared from now and never changed. If needed, other
+  trees are released to keep the memory used in budget.
+
+  Returns 0 if the tree has been added, 1 otherwise
+*/
+int bufrdeco_tree_cache_add ( struct bufrdeco *b )
+{
+  size_t i;
+  uint32_t hash;
+  struct bufrdeco_tree_cache *c = &BUFRDECO_TREE_CACHE;
+
+  if ( b->tree == NULL || b->tables == NULL || c->budget < sizeof ( struct bufrdeco_expanded_tree ) ||
+       strlen ( b->tables->b.old_path ) >= sizeof ( c->entry[0].pathb ) ||
+       strlen ( b->tables->d.old_path ) >= sizeof ( c->entry[0].pathd ) )
+    return 1;
+
+  hash = bufrdeco_tree_cache_hash ( b );
+
+  bufrdeco_tree_cache_lock ();
+
+  // Maybe already there, added by another decoder
+  for ( i = 0; i < c->nt; i++ )
+    {
+      if ( c->entry[i].t == b->tree || bufrdeco_tree_cache_match ( & ( c->entry[i] ), b, hash ) )
+        {
+          bufrdeco_tree_cache_unlock ();
+          return 1;
+        }
+    }
+
+  // Make room for a new tree
+  bufrdeco_tree_cache_evict ( c->budget - sizeof ( struct bufrdeco_expanded_tree ) );
+
+  __sync_add_and_fetch ( & ( b->tree->refcount ), 1 );
+  c->entry[c->nt].t = b->tree;
+  c->entry[c->nt].hash = hash;
+  strcpy ( c->entry[c->nt].pathb, b->tables->b.old_path );
+  strcpy ( c->entry[c->nt].pathd, b->tables->d.old_path );
+  c->entry[c->nt].last_use = ++ ( c->clock );
+  c->nt++;
+  bufrdeco_tree_cache_unlock ();
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tree_cache_set_budget ( size_t budget )
+  \brief Set the max amount of memory used by trees in cache
+  \param budget max amount of memory in bytes. If 0 the cache is not used
+
+  Every tree needs sizeof(struct \ref bufrdeco_expanded_tree) bytes. The default is \ref BUFRDECO_TREE_CACHE_BUDGET
+
+  Returns 0
+*/
+int bufrdeco_tree_cache_set_budget ( size_t budget )
+{
+  bufrdeco_tree_cache_lock ();
+  BUFRDECO_TREE_CACHE.budget = budget;
+  bufrdeco_tree_cache_evict ( budget );
+  bufrdeco_tree_cache_unlock ();
+  return 0;
+}
+
+/*!
+  \fn int bufrdeco_tree_cache_clear ( void )
+  \brief Release all trees in cache
+
+  The budget is not changed. The trees still used by any decoder are freed when it is reset or closed
+
+  Returns 0
+*/
+int bufrdeco_tree_cache_clear ( void )
+{
+  bufrdeco_tree_cache_lock ();
+  bufrdeco_tree_cache_evict ( 0 );
+  bufrdeco_tree_cache_unlock ();
+  return 0;
+}
@@ -22,6 +22,9 @@
  \brief This file has the code of useful routines for library bufrdeco
 */
 #include "bufrdeco.h"
+#if defined ( __GNUC__ ) && defined ( __x86_64__ )
+#include <immintrin.h>
+#endif
 
 uint8_t bitf[8] = {0x80,0x40,0x20,0x10,0x08,0x04,0x02,0x01}; /*!< Mask a single bit of a byte */
 uint8_t biti[8] = {0xFF,0x7f,0x3f,0x1F,0x0F,0x07,0x03,0x01}; /*!< Mask remaining bits in a byte (less significant) */
@@ -202,6 +205,317 @@ size_t get_bits_as_uint32_t ( uint32_t *target, uint8_t *has_data, uint8_t *sour
   return bit_length;
 }
 
+/*!
+  \fn static uint64_t bit_reader_load ( const uint8_t *c )
+  \brief Get 8 bytes as a big endian uint64_t
+  \param c pointer to first byte
+*/
+static uint64_t bit_reader_load ( const uint8_t *c )
+{
+  uint64_t x;
+
+  memcpy ( &x, c, 8 );
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  x = __builtin_bswap64 ( x );
+#endif
+  return x;
+}
+
+/*!
+  \fn static void bit_reader_store ( uint8_t *c, uint64_t x )
+  \brief Set 8 bytes from a big endian uint64_t
+  \param c pointer to first byte
+  \param x the value
+*/
+static void bit_reader_store ( uint8_t *c, uint64_t x )
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  x = __builtin_bswap64 ( x );
+#endif
+  memcpy ( c, &x, 8 );
+}
+
+/*!
+  \fn static uint64_t bit_reader_window ( const struct bufrdeco_bit_reader *r, size_t byte )
+  \brief Get 8 bytes of data since a given one as a big endian uint64_t
+  \param r pointer to the struct \ref bufrdeco_bit_reader
+  \param byte index of first byte in data
+
+  Bytes beyond the end of data are got as 0. Caller must check that \a byte is in data.
+*/
+static uint64_t bit_reader_window ( const struct bufrdeco_bit_reader *r, size_t byte )
+{
+  uint64_t x = 0;
+  size_t i;
+
+  if ( byte + 8 <= r->nbytes )
+    return bit_reader_load ( r->data + byte );
+
+  // Near the end of data
+  for ( i = 0; i < 8; i++ )
+    {
+      x <<= 8;
+      if ( byte + i < r->nbytes )
+        x |= r->data[byte + i];
+    }
+  return x;
+}
+
+/*!
+  \fn size_t bit_reader_get_uint32_t ( uint32_t *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r, size_t *bit0_offset, size_t bit_length )
+  \brief Read bits from data in sec4 and set them as an uint32_t
+  \param target uint32_t pointer where to set the result
+  \param has_data Output flags to check whether is missing data. If 0 then data is missing, othewise has data
+  \param r pointer to the struct \ref bufrdeco_bit_reader with data
+  \param bit0_offset Bit offset
+  \param bit_length Lenght (in bits) for the chunck to extract
+
+  Any length from 1 to 32 bits is got from a single 64 bits window, so this takes the same time for every
+  length, and the check of missing data (all bits set) has no branches. This replaces \ref get_bits_as_uint32_t
+  and \ref get_bits_as_uint32_t2 in the decoder.
+
+  If returns the amount of bits readed. 0 if problems. It also update bits_offset with the new bits.
+*/
+size_t bit_reader_get_uint32_t ( uint32_t *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r,
+                                 size_t *bit0_offset, size_t bit_length )
+{
+  uint64_t x;
+
+  if ( bit_length > 32 || bit_length == 0 || ( *bit0_offset + bit_length ) > 8 * r->nbytes )
+    return 0;
+
+  // At most 7 + 32 bits are used from the window
+  x = bit_reader_window ( r, *bit0_offset >> 3 ) << ( *bit0_offset & 7 );
+  *target = ( uint32_t ) ( x >> ( 64 - bit_length ) );
+  *has_data = ( *target != ( 0xFFFFFFFFU >> ( 32 - bit_length ) ) );
+  *bit0_offset += bit_length;
+  return bit_length;
+}
+
+#if defined ( __GNUC__ ) && defined ( __x86_64__ )
+/*!
+  \fn static int bit_reader_has_avx2 ( void )
+  \brief Check once if the CPU running the code has AVX2 instructions
+
+  Returns 1 if AVX2 is available, 0 otherwise
+*/
+static int bit_reader_has_avx2 ( void )
+{
+  static int has_avx2 = -1;
+
+  if ( has_avx2 < 0 )
+    {
+      __builtin_cpu_init ();
+      has_avx2 = __builtin_cpu_supports ( "avx2" ) ? 1 : 0;
+    }
+  return has_avx2;
+}
+
+/*!
+  \fn static size_t bit_reader_get_uint32_array_avx2 ( uint32_t *target, const struct bufrdeco_bit_reader *r, size_t bit0_offset, size_t bit_length, size_t n )
+  \brief AVX2 kernel of \ref bit_reader_get_uint32_array. It gets 8 values at once
+  \param target array of uint32_t with room for \a n values where to set the results
+  \param r pointer to the struct \ref bufrdeco_bit_reader with data
+  \param bit0_offset bit offset of first value
+  \param bit_length length in bits of every value, from 1 to 32
+  \param n number of values
+
+  The 64 bits windows of four values are gathered in a register. Then their bytes are swapped to big endian
+  and every window is shifted by its own bit offset, as the scalar code does for a single value. It stops
+  when a window is not fully in data.
+
+  Returns the amount of values got. The remaining ones must be got by caller
+*/
+__attribute__ ( ( target ( "avx2" ) ) )
+static size_t bit_reader_get_uint32_array_avx2 ( uint32_t *target, const struct bufrdeco_bit_reader *r, size_t bit0_offset,
+    size_t bit_length, size_t n )
+{
+  size_t i;
+  const long long *base = ( const long long * ) r->data;
+  const __m256i bswap = _mm256_setr_epi8 ( 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 );
+  const __m256i seven = _mm256_set1_epi64x ( 7 );
+  const __m256i step = _mm256_set1_epi64x ( 4 * bit_length );
+  const __m256i low = _mm256_setr_epi32 ( 0, 2, 4, 6, 0, 2, 4, 6 );
+  const __m128i sh = _mm_cvtsi32_si128 ( 64 - bit_length );
+  __m256i o0, o1, x0, x1;
+
+  o0 = _mm256_add_epi64 ( _mm256_set1_epi64x ( bit0_offset ),
+                          _mm256_setr_epi64x ( 0, bit_length, 2 * bit_length, 3 * bit_length ) );
+  o1 = _mm256_add_epi64 ( o0, step );
+
+  for ( i = 0; i + 8 <= n && ( ( ( bit0_offset + ( i + 7 ) * bit_length ) >> 3 ) + 8 ) <= r->nbytes; i += 8 )
+    {
+      x0 = _mm256_i64gather_epi64 ( base, _mm256_srli_epi64 ( o0, 3 ), 1 );
+      x1 = _mm256_i64gather_epi64 ( base, _mm256_srli_epi64 ( o1, 3 ), 1 );
+      x0 = _mm256_srl_epi64 ( _mm256_sllv_epi64 ( _mm256_shuffle_epi8 ( x0, bswap ), _mm256_and_si256 ( o0, seven ) ), sh );
+      x1 = _mm256_srl_epi64 ( _mm256_sllv_epi64 ( _mm256_shuffle_epi8 ( x1, bswap ), _mm256_and_si256 ( o1, seven ) ), sh );
+      // The low 32 bits of every window, in order
+      x0 = _mm256_permutevar8x32_epi32 ( x0, low );
+      x1 = _mm256_permutevar8x32_epi32 ( x1, low );
+      _mm256_storeu_si256 ( ( __m256i * ) ( target + i ), _mm256_permute2x128_si256 ( x0, x1, 0x20 ) );
+      o0 = _mm256_add_epi64 ( o1, step );
+      o1 = _mm256_add_epi64 ( o0, step );
+    }
+  return i;
+}
+#endif
+
+/*!
+  \fn size_t bit_reader_get_uint32_array ( uint32_t *target, const struct bufrdeco_bit_reader *r, size_t bit0_offset, size_t bit_length, size_t n )
+  \brief Read a sequence of values with the same length in bits from data in sec4
+  \param target array of uint32_t with room for \a n values where to set the results
+  \param r pointer to the struct \ref bufrdeco_bit_reader with data
+  \param bit0_offset bit offset of first value
+  \param bit_length length in bits of every value, from 1 to 32
+  \param n number of values
+
+  This is the way the increments for all subsets of a descriptor are packed in compressed data. Every value is
+  shifted out of a 64 bits window as in \ref bit_reader_get_uint32_t, but the checks are done once. On x86-64
+  CPUs with AVX2, checked at run time, most of values are got with \ref bit_reader_get_uint32_array_avx2.
+
+  Returns the amount of bits readed. 0 if problems
+*/
+size_t bit_reader_get_uint32_array ( uint32_t *target, const struct bufrdeco_bit_reader *r, size_t bit0_offset,
+                                    size_t bit_length, size_t n )
+{
+  size_t i = 0, o, sh;
+
+  if ( bit_length > 32 || bit_length == 0 || ( bit0_offset + bit_length * n ) > 8 * r->nbytes )
+    return 0;
+
+#if defined ( __GNUC__ ) && defined ( __x86_64__ )
+  if ( n >= 16 && bit_reader_has_avx2 () )
+    i = bit_reader_get_uint32_array_avx2 ( target, r, bit0_offset, bit_length, n );
+#endif
+
+  sh = 64 - bit_length;
+  o = bit0_offset + i * bit_length;
+  // While the window is fully in data
+  for ( ; i < n && ( ( o >> 3 ) + 8 ) <= r->nbytes; i++, o += bit_length )
+    {
+      target[i] = ( uint32_t ) ( ( bit_reader_load ( r->data + ( o >> 3 ) ) << ( o & 7 ) ) >> sh );
+    }
+  for ( ; i < n; i++, o += bit_length )
+    {
+      target[i] = ( uint32_t ) ( ( bit_reader_window ( r, o >> 3 ) << ( o & 7 ) ) >> sh );
+    }
+  return bit_length * n;
+}
+
+#if defined ( __GNUC__ ) && defined ( __x86_64__ )
+/*!
+  \fn static size_t bit_reader_get_char_array_avx2 ( uint8_t *target, const uint8_t *c, unsigned int sh, size_t nc, int *all_set )
+  \brief AVX2 kernel of \ref bit_reader_get_char_array. It gets 32 chars at once
+  \param target array where to set the chars
+  \param c pointer to the byte in data with the first bit of first char
+  \param sh bit offset of first char in \a c[0], from 0 to 7
+  \param nc number of chars
+  \param all_set pointer where to set 1 if all the chars got have all bits set, 0 otherwise
+
+  Every byte is shifted left by \a sh bits and the first bits of next byte are appended, as the scalar code does
+  with a 64 bits word. If \a sh is 0 the next byte is not read. The check of missing data is also done 32 chars
+  at once.
+
+  Returns the amount of chars got. The remaining ones must be got by caller
+*/
+__attribute__ ( ( target ( "avx2" ) ) )
+static size_t bit_reader_get_char_array_avx2 ( uint8_t *target, const uint8_t *c, unsigned int sh, size_t nc, int *all_set )
+{
+  size_t j;
+  const __m256i ones = _mm256_set1_epi8 ( -1 );
+  const __m256i mhi = _mm256_set1_epi8 ( ( char ) ( 0xFF << sh ) );
+  const __m256i mlo = _mm256_set1_epi8 ( ( char ) ( 0xFF >> ( 8 - sh ) ) );
+  const __m128i shl = _mm_cvtsi32_si128 ( sh ), shr = _mm_cvtsi32_si128 ( 8 - sh );
+  __m256i x, acc = ones;
+
+  for ( j = 0; ( j + 32 ) <= nc; j += 32 )
+    {
+      x = _mm256_loadu_si256 ( ( const __m256i * ) ( c + j ) );
+      if ( sh )
+        {
+          // 16 bits shifts, then the bits crossing from the neighbour byte are masked out
+          x = _mm256_or_si256 ( _mm256_and_si256 ( _mm256_sll_epi16 ( x, shl ), mhi ),
+                                _mm256_and_si256 ( _mm256_srl_epi16 ( _mm256_loadu_si256 ( ( const __m256i * ) ( c + j + 1 ) ), shr ), mlo ) );
+        }
+      _mm256_storeu_si256 ( ( __m256i * ) ( target + j ), x );
+      acc = _mm256_and_si256 ( acc, x );
+    }
+  *all_set = ( _mm256_movemask_epi8 ( _mm256_cmpeq_epi8 ( acc, ones ) ) == -1 );
+  return j;
+}
+#endif
+
+/*!
+  \fn size_t bit_reader_get_char_array ( char *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r, size_t *bit0_offset, size_t bit_length )
+  \brief Read bits from data in sec4 and set them as an array of chars
+  \param target string with the resulting array
+  \param has_data if 1 then has data, if 0 what we got is missing data (all bits set)
+  \param r pointer to the struct \ref bufrdeco_bit_reader with data
+  \param bit0_offset bit offset of first bit of first char
+  \param bit_length number of bits to extract. Obviously this will be divisible by 8
+
+  If the offset is byte aligned the chars are just copied. Otherwise 8 chars are got at once shifting a 64 bits
+  word and the first bits of next byte. The check of missing data is also done 8 chars at once. On x86-64 CPUs
+  with AVX2, checked at run time, long strings are got 32 chars at once with \ref bit_reader_get_char_array_avx2.
+
+  If returns the amount of bits readed. 0 if problems. It also update bit0_offset with the new bits.
+*/
+size_t bit_reader_get_char_array ( char *target, uint8_t *has_data, const struct bufrdeco_bit_reader *r,
+                                   size_t *bit0_offset, size_t bit_length )
+{
+  size_t j, j0 = 0, nc;
+  const uint8_t *c;
+  unsigned int sh;
+  int all_set = 1;
+  uint64_t x, all = ~ ( uint64_t ) 0;
+
+  if ( bit_length % 8 || ( *bit0_offset + bit_length ) > 8 * r->nbytes )
+    return 0;
+
+  nc = bit_length / 8;
+  c = r->data + ( *bit0_offset >> 3 );
+  sh = *bit0_offset & 7;
+
+#if defined ( __GNUC__ ) && defined ( __x86_64__ )
+  if ( nc >= 32 && bit_reader_has_avx2 () )
+    j0 = bit_reader_get_char_array_avx2 ( ( uint8_t * ) target, c, sh, nc, &all_set );
+#endif
+
+  if ( sh == 0 )
+    {
+      memcpy ( target + j0, c + j0, nc - j0 );
+    }
+  else
+    {
+      // As the offset is not aligned, the bits of the last char end in byte c[nc], which is in data
+      for ( j = j0; ( j + 8 ) <= nc; j += 8 )
+        {
+          x = ( bit_reader_load ( c + j ) << sh ) | ( c[j + 8] >> ( 8 - sh ) );
+          bit_reader_store ( ( uint8_t * ) target + j, x );
+        }
+      for ( ; j < nc; j++ )
+        {
+          target[j] = ( char ) ( ( c[j] << sh ) | ( c[j + 1] >> ( 8 - sh ) ) );
+        }
+    }
+  target[nc] = '\0';
+
+  // Missing data has all bits set
+  for ( j = j0; ( j + 8 ) <= nc; j += 8 )
+    {
+      memcpy ( &x, target + j, 8 );
+      all &= x;
+    }
+  for ( ; j < nc; j++ )
+    {
+      all &= ( uint8_t ) target[j] | ~ ( uint64_t ) 0xFF;
+    }
+  *has_data = ( all_set == 0 || all != ~ ( uint64_t ) 0 );
+  *bit0_offset += bit_length;
+  return bit_length;
+}
+
 
 /*!
  \fn int get_table_b_reference_from_uint32_t ( int32_t *target, uint8_t bits, uint32_t source )
@@ -264,10 +578,67 @@ int uint32_t_to_descriptor ( struct bufr_descriptor *d, uint32_t id )
   d->f = id / 100000;
   d->x = ( id % 100000 ) / 1000;
   d->y = id % 1000;
-  sprintf ( d->c, "%06u", id );
   return 0;
 }
 
+/*!
+  \fn uint16_t bufr_descriptor_to_key ( const struct bufr_descriptor *d )
+  \brief returns the integer key of a descriptor, with f, x and y packed as in the 16 bits of a BUFR file
+  \param d pointer to the source struct \ref bufr_descriptor
+
+  This is the key used to find descriptors in tables. No string is involved
+*/
+uint16_t bufr_descriptor_to_key ( const struct bufr_descriptor *d )
+{
+  return ( uint16_t ) ( ( ( d->f & 0x03 ) << 14 ) | ( ( d->x & 0x3f ) << 8 ) | d->y );
+}
+
+/*!
+  \fn int bufr_key_to_descriptor ( struct bufr_descriptor *d, uint16_t key )
+  \brief set a struct \ref bufr_descriptor from an integer key as returned by \ref bufr_descriptor_to_key
+  \param d pointer to the resulting descriptor
+  \param key the integer key
+
+  It resturns 0 if all is OK. 1 otherwise
+*/
+int bufr_key_to_descriptor ( struct bufr_descriptor *d, uint16_t key )
+{
+  if ( d == NULL )
+    return 1;
+  d->f = ( key >> 14 ) & 0x03;
+  d->x = ( key >> 8 ) & 0x3f;
+  d->y = key & 0xff;
+  return 0;
+}
+
+/*!
+  \fn char * bufr_descriptor_to_string ( char *target, const struct bufr_descriptor *d )
+  \brief writes a descriptor as a string in the form FXXYYY
+  \param target string where to write the result. At least 8 chars
+  \param d pointer to the source struct \ref bufr_descriptor
+
+  Only needed when printing. Returns \a target
+*/
+char * bufr_descriptor_to_string ( char *target, const struct bufr_descriptor *d )
+{
+  sprintf ( target, "%u%02u%03u", d->f, d->x, d->y );
+  return target;
+}
+
+/*!
+  \fn char * bufr_key_to_string ( char *target, uint16_t key )
+  \brief writes a descriptor integer key as a string in the form FXXYYY
+  \param target string where to write the result. At least 8 chars
+  \param key the integer key, as returned by \ref bufr_descriptor_to_key
+
+  Only needed when printing. Returns \a target
+*/
+char * bufr_key_to_string ( char *target, uint16_t key )
+{
+  sprintf ( target, "%u%02u%03u", ( key >> 14 ) & 0x03, ( key >> 8 ) & 0x3f, key & 0xff );
+  return target;
+}
+
 /*!
   \fn int two_bytes_to_descriptor (struct bufr_descriptor *d, const uint8_t *source)
   \brief set a struct \ref bufr_descriptor from two consecutive bytes in bufr file
@@ -281,7 +652,6 @@ int two_bytes_to_descriptor ( struct bufr_descriptor *d, const uint8_t *source )
   d->y = source[1];
   d->x = source[0] & 0x3f;
   d->f = ( source[0] >> 6 ) & 0x03;
-  sprintf ( d->c, "%u%02u%03u", d->f, d->x, d->y );
   return 0;
 }
 
@@ -30,9 +30,12 @@ const char DEFAULT_BUFRTABLES_WMO_CSV_DIR1[] = "/usr/local/share/bufr2synop/";
 const char DEFAULT_BUFRTABLES_WMO_CSV_DIR2[] = "/usr/share/bufr2synop/";
 
 /*!
-  \fn int get_wmo_tablenames ( struct bufrdeco *b)
+  \fn int get_wmo_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd )
   \brief Get the complete pathnames for WMO csv table files needed by a bufr message
   \param b pointer for a struct \ref bufrdeco
+  \param pathb string where to set the pathname of table B
+  \param pathc string where to set the pathname of table C
+  \param pathd string where to set the pathname of table D
 
   For WMO files this format is adopted
        BUFR_XX_Y_Z_TableB_en for table B
@@ -43,40 +46,16 @@ const char DEFAULT_BUFRTABLES_WMO_CSV_DIR2[] = "/usr/share/bufr2synop/";
   Y is the revision (currently ignored)
   Z is minor revision (currently ignored)
 */
-int get_wmo_tablenames ( struct bufrdeco *b )
+int get_wmo_tablenames ( struct bufrdeco *b, char *pathb, char *pathc, char *pathd )
 {
-  struct stat st;
   char aux[128];
 
-  if ( b->bufrtables_dir[0] == '\0' )
+  // The directory is guessed just once
+  if ( bufrdeco_resolve_tables_dir ( b, DEFAULT_BUFRTABLES_WMO_CSV_DIR1, DEFAULT_BUFRTABLES_WMO_CSV_DIR2 ) )
     {
-      // try to guess directory
-      if ( stat ( DEFAULT_BUFRTABLES_WMO_CSV_DIR1, &st ) )
-        {
-          if ( stat ( DEFAULT_BUFRTABLES_WMO_CSV_DIR2, &st ) )
-            {
-              return 1;
-            }
-          else
-            {
-              if ( S_ISDIR ( st.st_mode ) )
-                {
-                  strcpy ( aux, DEFAULT_BUFRTABLES_WMO_CSV_DIR2 );
-                }
-            }
-        }
-      else
-        {
-          if ( S_ISDIR ( st.st_mode ) )
-            {
-              strcpy ( aux,DEFAULT_BUFRTABLES_WMO_CSV_DIR1 );
-            }
-        }
-    }
-  else
-    {
-      strcpy ( aux, b->bufrtables_dir );
+      return 1;
     }
+  strcpy ( aux, b->bufrtables_dir );
 
   switch ( b->sec1.master_version )
     {
@@ -90,24 +69,24 @@ int get_wmo_tablenames ( struct bufrdeco *b )
     case 11:
     case 12:
     case 13:
-      sprintf ( b->tables->b.path,"%sBUFR_13_0_0_TableB_en.csv", aux );
-      sprintf ( b->tables->c.path,"%sBUFR_13_0_0_TableC_en.csv", aux );
-      sprintf ( b->tables->d.path,"%sBUFR_13_0_0_TableD_en.csv", aux );
+      sprintf ( pathb,"%sBUFR_13_0_0_TableB_en.csv", aux );
+      sprintf ( pathc,"%sBUFR_13_0_0_TableC_en.csv", aux );
+      sprintf ( pathd,"%sBUFR_13_0_0_TableD_en.csv", aux );
       break;
     case 18:
-      sprintf ( b->tables->b.path,"%sBUFR_18_1_0_TableB_en.csv", aux );
-      sprintf ( b->tables->c.path,"%sBUFR_18_1_0_TableC_en.csv", aux );
-      sprintf ( b->tables->d.path,"%sBUFR_18_1_0_TableD_en.csv", aux );
+      sprintf ( pathb,"%sBUFR_18_1_0_TableB_en.csv", aux );
+      sprintf ( pathc,"%sBUFR_18_1_0_TableC_en.csv", aux );
+      sprintf ( pathd,"%sBUFR_18_1_0_TableD_en.csv", aux );
       break;
     case 19:
-      sprintf ( b->tables->b.path,"%sBUFR_19_1_1_TableB_en.csv", aux );
-      sprintf ( b->tables->c.path,"%sBUFR_19_1_1_TableC_en.csv", aux );
-      sprintf ( b->tables->d.path,"%sBUFR_19_1_1_TableD_en.csv", aux );
+      sprintf ( pathb,"%sBUFR_19_1_1_TableB_en.csv", aux );
+      sprintf ( pathc,"%sBUFR_19_1_1_TableC_en.csv", aux );
+      sprintf ( pathd,"%sBUFR_19_1_1_TableD_en.csv", aux );
       break;
     case 22:
-      sprintf ( b->tables->b.path,"%sBUFR_22_0_1_TableB_en.csv", aux );
-      sprintf ( b->tables->c.path,"%sBUFR_22_0_1_TableC_en.csv", aux );
-      sprintf ( b->tables->d.path,"%sBUFR_22_0_1_TableD_en.csv", aux );
+      sprintf ( pathb,"%sBUFR_22_0_1_TableB_en.csv", aux );
+      sprintf ( pathc,"%sBUFR_22_0_1_TableC_en.csv", aux );
+      sprintf ( pathd,"%sBUFR_22_0_1_TableD_en.csv", aux );
       break;
     case 14:
     case 15:
@@ -126,14 +105,14 @@ int get_wmo_tablenames ( struct bufrdeco *b )
     case 32:
     case 33:
     case 34:    
-      sprintf ( b->tables->b.path,"%sBUFR_%d_0_0_TableB_en.csv", aux, b->sec1.master_version );
-      sprintf ( b->tables->c.path,"%sBUFR_%d_0_0_TableC_en.csv", aux, b->sec1.master_version );
-      sprintf ( b->tables->d.path,"%sBUFR_%d_0_0_TableD_en.csv", aux, b->sec1.master_version );
+      sprintf ( pathb,"%sBUFR_%d_0_0_TableB_en.csv", aux, b->sec1.master_version );
+      sprintf ( pathc,"%sBUFR_%d_0_0_TableC_en.csv", aux, b->sec1.master_version );
+      sprintf ( pathd,"%sBUFR_%d_0_0_TableD_en.csv", aux, b->sec1.master_version );
       break;
     default:
-      sprintf ( b->tables->b.path,"%sBUFR_34_0_0_TableB_en.csv", aux );
-      sprintf ( b->tables->c.path,"%sBUFR_34_0_0_TableC_en.csv", aux );
-      sprintf ( b->tables->d.path,"%sBUFR_34_0_0_TableD_en.csv", aux );
+      sprintf ( pathb,"%sBUFR_34_0_0_TableB_en.csv", aux );
+      sprintf ( pathc,"%sBUFR_34_0_0_TableC_en.csv", aux );
+      sprintf ( pathd,"%sBUFR_34_0_0_TableD_en.csv", aux );
       break;
     }
   return 0;
@@ -148,18 +127,31 @@ int get_wmo_tablenames ( struct bufrdeco *b )
 */
 int bufr_read_tables_wmo ( struct bufrdeco *b )
 {
+  char pathb[256], pathc[256], pathd[256];
 
   // get tablenames
-  if ( get_wmo_tablenames ( b ) )
+  if ( get_wmo_tablenames ( b, pathb, pathc, pathd ) )
     {
       sprintf ( b->error, "bufrdeco_read_tables_ecmwf(): Cannot find bufr tables\n" );
       return 1;
     }
 
-  // If tables still not initialized then do it
-  if ( b->tables == NULL && bufrdeco_init_tables ( & ( b->tables ) ) )
+  // If the same tables are already loaded, or are in cache, there is nothing to do
+  if ( bufrdeco_tables_loaded ( b->tables, pathb, pathc, pathd ) ||
+       bufrdeco_use_cached_tables ( b, pathb, pathc, pathd ) )
+    {
+      return 0;
+    }
+
+  // A binary image of tables, if any, is much faster to load than table files
+  if ( bufrdeco_load_tables_image ( b, pathb, pathc, pathd ) == 0 )
+    {
+      bufrdeco_tables_cache_add ( b->tables );
+      return 0;
+    }
+
+  if ( bufrdeco_prepare_tables ( b, pathb, pathc, pathd ) )
     {
-      sprintf ( b->error, "bufrdeco_read_tables_ecmwf(): Cannot allocate memory for tables\n" );
       return 1;
     }
 
@@ -178,5 +170,8 @@ int bufr_read_tables_wmo ( struct bufrdeco *b )
     {
       return 1;
     }
+
+  // Keep them for other messages and decoders
+  bufrdeco_tables_cache_add ( b->tables );
   return 0;
 }
@@ -325,6 +325,8 @@ char *guess_WMO_region_temp ( struct temp_chunks *temp );
 int read_table_c ( char tablec[MAXLINES_TABLEC][92], size_t *nlines_tablec, char *bufrtables_dir, int ksec1[40] );
 int parse_subset_sequence ( struct metreport *m, struct bufr_subset_sequence_data *sq, struct bufr2tac_subset_state *st,
                             int *kdtlst, size_t nlst, int *ksec1, char *err );
+int bufrdeco_parse_subset_sequence ( struct metreport *m, struct bufr2tac_subset_state *st, struct bufrdeco *b,
+                                     char *err );
 int find_descriptor ( int *haystack, size_t nlst, int needle );
 int find_descriptor_interval ( int *haystack, size_t nlst, int needlemin, int needlemax );
 int bufr_set_environment ( char *default_bufrtables, char *bufrtables_dir );
@@ -193,3 +193,44 @@ int parse_subset_sequence ( struct metreport *m, struct bufr_subset_sequence_dat
   // when reached this point we have han error
   return 1;
 }
+
+/*!
+  \fn int bufrdeco_parse_subset_sequence ( struct metreport *m, struct bufr2tac_subset_state *st, struct bufrdeco *b, char *err )
+  \brief Parse the latest subset decoded by bufrdeco library to TAC. This is an interface to use bufr2tac
+  \param m pointer to a struct \ref metreport where to set the data
+  \param st pointer to a struct \ref bufr2tac_subset_state
+  \param b pointer to the struct \ref bufrdeco with the subset in b->seq
+  \param err string where to write errors if any
+*/
+int bufrdeco_parse_subset_sequence ( struct metreport *m, struct bufr2tac_subset_state *st,
+                                     struct bufrdeco *b, char *err )
+{
+  size_t i;
+  int ksec1[40], res;
+  int *kdtlst;
+  size_t nlst = ( size_t ) b->sec3.ndesc;
+
+  // memory for kdtlst
+  if ( ( kdtlst = ( int * ) calloc ( 1, nlst * sizeof ( int ) ) ) == NULL )
+    {
+      sprintf ( err, "decobufr_parse_subset_sequence(): cannot alloc memory for kdtlst\n" );
+      return 1;
+    }
+
+  // sets descriptor as integer according to ECMWF
+  for ( i = 0; i < nlst ; i++ )
+    {
+      descriptor_to_integer ( &kdtlst[i], &b->sec3.unexpanded[i] );
+    }
+
+  // And now set only used ksec1 elements
+  ksec1[5] = b->sec1.category;
+  ksec1[6] = b->sec1.subcategory_local;
+
+  // Finaly we call to bufr2tac library
+  memset ( m, 0, sizeof ( struct metreport ) );
+  m->h = &b->header;
+  res = parse_subset_sequence ( m, &b->seq, st, kdtlst, nlst, ksec1, err );
+  free ( ( void * ) kdtlst );
+  return res;
+}
@@ -102,19 +102,20 @@ int read_table_c ( char tablec[MAXLINES_TABLEC][92], size_t *nlines_tablec, char
 */
 char * get_explained_table_val ( char *expl, size_t dim, char tablec[MAXLINES_TABLEC][92], size_t nlines_tablec, struct bufr_descriptor *d, int ival )
 {
-  char *c;
+  char *c, key[8];
   long nv, v,  nl;
   size_t i, j;
 
   // Find first line for descriptor
+  bufr_descriptor_to_string ( key, d );
   for ( i = 0; i <  nlines_tablec; i++ )
     {
-      if ( tablec[i][0] != d->c[0] ||
-           tablec[i][1] != d->c[1] ||
-           tablec[i][2] != d->c[2] ||
-           tablec[i][3] != d->c[3] ||
-           tablec[i][4] != d->c[4] ||
-           tablec[i][5] != d->c[5] )
+      if ( tablec[i][0] != key[0] ||
+           tablec[i][1] != key[1] ||
+           tablec[i][2] != key[2] ||
+           tablec[i][3] != key[3] ||
+           tablec[i][4] != key[4] ||
+           tablec[i][5] != key[5] )
         continue;
       else
         break;
@@ -122,10 +123,10 @@ char * get_explained_table_val ( char *expl, size_t dim, char tablec[MAXLINES_TA
 
   if ( i == nlines_tablec )
     {
-      //printf("Descriptor %s No encontrado\n", d->c);
+      //printf("Descriptor %s No encontrado\n", key);
       return NULL;
     }
-  //printf("Descriptor %s en linea %d\n", d->c, i);
+  //printf("Descriptor %s en linea %d\n", key, i);
 
   // reads the amount of possible values
   if ( tablec[i][7] != ' ' )
@@ -180,20 +181,21 @@ char * get_explained_table_val ( char *expl, size_t dim, char tablec[MAXLINES_TA
 */
 char * get_explained_flag_val ( char *expl, size_t dim, char tablec[MAXLINES_TABLEC][92], size_t nlines_tablec, struct bufr_descriptor *d, unsigned long ival )
 {
-  char *c, *s;
+  char *c, *s, key[8];
   unsigned long test, test0;
   unsigned long nb, nx, v,  nl;
   size_t i, j;
 
   // Find first line for descriptor
+  bufr_descriptor_to_string ( key, d );
   for ( i = 0; i <  nlines_tablec; i++ )
     {
-      if ( tablec[i][0] != d->c[0] ||
-           tablec[i][1] != d->c[1] ||
-           tablec[i][2] != d->c[2] ||
-           tablec[i][3] != d->c[3] ||
-           tablec[i][4] != d->c[4] ||
-           tablec[i][5] != d->c[5] )
+      if ( tablec[i][0] != key[0] ||
+           tablec[i][1] != key[1] ||
+           tablec[i][2] != key[2] ||
+           tablec[i][3] != key[3] ||
+           tablec[i][4] != key[4] ||
+           tablec[i][5] != key[5] )
         continue;
       else
         break;
@@ -201,10 +203,10 @@ char * get_explained_flag_val ( char *expl, size_t dim, char tablec[MAXLINES_TAB
 
   if ( i == nlines_tablec )
     {
-      //printf("Descriptor %s No encontrado\n", d->c);
+      //printf("Descriptor %s No encontrado\n", key);
       return NULL;
     }
-  //printf("Descriptor %s en linea %d\n", d->c, i);
+  //printf("Descriptor %s en linea %d\n", key, i);
 
   // reads the amount of possible bits
   if ( tablec[i][7] != ' ' )